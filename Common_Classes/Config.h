@@ -25,20 +25,38 @@
 #include "driverlib/timer.h"
 
 
-// Choose the device for which the code is compiled
+// Choose the device for which the code is compiled (host programs may choose
+// it on the command line with -DMINISEG or -DTIVSEG)
+#if !defined(MINISEG) && !defined(TIVSEG)
 #define MINISEG
 // #define TIVSEG
+#endif
 
 
 // System
 #define CFG_SYS_FREQ                     40000000           // CPU clock
 
-#define CFG_DEBUG_TIMER_BASE             TIMER1_BASE        // Timer used to send debug data with a fixed frequency to the computer.
-#define CFG_DEBUG_TIMER_FREQ             20                 // Frequency at which the computer receives new debug data.
+#define CFG_DEBUG_FREQ                   20                 // Frequency at which the computer receives new debug data (telemetry task, see Segway::addTasks).
+#define CFG_DEBUG_BINARY                 false              // Send the debug values as binary frames (see DebugFrame.h) instead of text. Needs Host_Tools/DebugDecode to read them. Saves the CPU time of printf, but a frame is only about 1.1 to 1.3 times smaller than the text line (each has its own header and CRC), so CFG_DEBUG_FREQ can hardly be raised.
+#define CFG_DEBUG_SLOW_FREQ              1                  // Rate [Hz] of the slowly changing debug values (sensor temperature, battery voltage) in the binary frames (see System::addDebugChannel). Divisor of CFG_DEBUG_FREQ.
+#define CFG_PROFILING                    false              // Measure the CPU cycles of Segway::update, the sensor reads, the arctangent and PWM::setDuty with the probes of System (see System::addProbe). Send "p" via the Serial Monitor to get the statistics, "r" to reset them.
 
 
 // Main timer
-#define CFG_MAIN_TIMER_BASE              TIMER0_BASE        // Timer used to run the segway code.
+#define CFG_MAIN_TIMER_BASE              TIMER0_BASE        // Timer generating the tick of the scheduler (see Scheduler.h), which runs the segway code. Ticks at CFG_CTLR_UPDATE_FREQ.
+#define CFG_CYCLE_BUDGET                 false              // Measure the CPU cycles of the stages of Segway::update and show their maxima instead of the normal debug values.
+
+
+// Ride log
+#define CFG_RIDELOG_ENABLE               false              // Send the inputs and outputs of each controller update as binary records via the USB UART (see RideLog.h). Disables the debug values. A record has 40 bytes, at 115200 baud that's about 280 per second: the update frequency must not exceed CFG_RIDELOG_MAX_FREQ (not with CFG_CTLR_HIGH_RATE).
+#define CFG_RIDELOG_MAX_FREQ             250                // Highest update frequency [Hz] whose records the USB UART can send, with some margin for the header and lost bytes.
+#define CFG_RIDELOG_UART_BASE            UART0_BASE         // USB UART, configured by System::init.
+
+
+// Black box
+#define CFG_RECORDER_ENABLE              false              // Keep the last updates in RAM (see FlightRecorder.h, 6 KiB) and freeze them on a fall or System::error. Send "b" via the Serial Monitor to get them, "a" to record again.
+#define CFG_RECORDER_FALL_ANGLE          45.0f              // Tilt [deg] at which the segway is considered fallen.
+#define CFG_RECORDER_AFTER_FALL          32                 // Updates still recorded after the fall (less than FlightRecorder::SIZE).
 
 
 // Motors
@@ -83,6 +101,24 @@
 #define CFG_SENSOR_INVERT_ANGLE_RATE     false              // Rotating in driving direction is positive
 #define CFG_SENSOR_INVERT_HOR            true               // Driving direction is positive
 #define CFG_SENSOR_INVERT_VER            true               // Downwards is positive
+#define CFG_SENSOR_ANTI_ALIASING         false              // Enable the sensor's low pass filter at half the update frequency (see CFG_SENSOR_LOW_PASS). Prevents aliasing but delays the measurements by 5 to 14ms: only use it with gains tuned for it or with CFG_CTLR_DELAY_COMPENSATION.
+#define CFG_SENSOR_LOW_PASS              (CFG_SENSOR_ANTI_ALIASING ? CFG_CTLR_UPDATE_FREQ / 2 : 0) // Bandwidth [Hz] of the sensor's low pass filter, 0 disables it. At most half the update frequency.
+#define CFG_SENSOR_SAMPLE_FREQ           (1000 / CFG_CTLR_UPDATE_FREQ * CFG_CTLR_UPDATE_FREQ) // Rate at which the sensor measures (unless using the FIFO or data ready trigger): the highest multiple of the update frequency up to 1kHz (the gyroscope rate with the low pass filter). The faster, the more recent the sample read by each update.
+#define CFG_SENSOR_GYRO_CAL_SAMPLES      200                // Samples averaged at startup to measure the gyroscope offset. The segway must not move while powering up. 0 disables the calibration.
+#define CFG_SENSOR_GYRO_TRACKING         0.01f              // Weight of each sample when following the gyroscope offset in standby. 0.0f disables the tracking.
+#define CFG_SENSOR_GYRO_STANDSTILL       2.0f               // Maximum angle rate [deg/s] on any axis which is still considered as standstill during tracking.
+#define CFG_SENSOR_GYRO_TEMP_COEFFS      {0.0f, 0.0f, 0.0f} // Change of the gyroscope offsets (x, y, z) in deg/s per degree Celsius. Fit from the logged temperature and angle rate at rest.
+#define CFG_SENSOR_ACCEL_TEMP_COEFFS     {0.0f, 0.0f, 0.0f} // Change of the accelerometer offsets (x, y, z) in g per degree Celsius.
+#define CFG_SENSOR_ASYNC_READ            false              // Read the next sample in background at the end of each update. Hides the I2C transfer time but the sample is one update period old.
+#define CFG_SENSOR_FIFO_SAMPLES          0                  // Number of samples per update averaged from the sensor FIFO. 0 disables the FIFO. Not used together with CFG_SENSOR_ASYNC_READ.
+#ifndef CFG_SENSOR_DATA_READY_TRIGGER
+#define CFG_SENSOR_DATA_READY_TRIGGER    false              // Run the update as soon as the sensor has a new sample (see Segway::enableDataReadyTrigger). Requires the INT pin to be connected. Not used together with CFG_SENSOR_FIFO_SAMPLES. Can be set with -D (f.ex. for Host_Tools/SegwaySim).
+#endif
+#if CFG_SENSOR_FIFO_SAMPLES && CFG_SENSOR_DATA_READY_TRIGGER
+#error "The data ready interrupt can't trigger the updates with the FIFO enabled (see CFG_SENSOR_DATA_READY_TRIGGER)."
+#endif
+#define CFG_SENSOR_INT_PORT              GPIO_PORTC_BASE
+#define CFG_SENSOR_INT_PIN               GPIO_PIN_4         // PC4: connected to the INT pin of the MPU6050
 
 
 // Battery voltage
@@ -91,27 +127,82 @@
 #define CFG_BATT_AIN                     ADC_CTL_CH1        // PE2
 #define CFG_BATT_MIN                     21.0f
 #define CFG_BATT_TIMEOUT                 5                  // Seconds until segway stops because of low battery.
+#define CFG_BATT_FREQ                    10                 // Rate [Hz] at which the battery voltage is checked.
 
 
 // Steering
 #define CFG_STEERING_BASE                ADC0_BASE
 #define CFG_STEERING_SSEQ                1
 #define CFG_STEERING_AIN                 ADC_CTL_CH2        // PE1
+#define CFG_STEERING_FREQ                100                // Rate [Hz] at which the steering is read (at most CFG_CTLR_UPDATE_FREQ).
 
 
 // Controller
+#define CFG_CTLR_TIVSEG_UPDATE_FREQ      100                // Setting for TivSeg
+#define CFG_CTLR_TIVSEG_FILTER_FACT      0.995f             // @100Hz update frequency. Determined by experiments.
+#define CFG_CTLR_MINISEG_UPDATE_FREQ     10                 // Setting for MiniSeg
+#define CFG_CTLR_MINISEG_FILTER_FACT     0.95f              // Setting for MiniSeg
+
+#define CFG_CTLR_HIGH_RATE               false              // Run the controller at CFG_CTLR_HIGH_RATE_FREQ instead of the update frequency of the device. The filter factors are converted to keep their time constants (see HighRateParams in ControllerParams.h).
+#define CFG_CTLR_HIGH_RATE_FREQ          1000               // Update frequency [Hz] of the high rate mode. Supported are 500 to 1000. The blocking sensor read needs about 0.4ms, consider CFG_SENSOR_ASYNC_READ. The gains of the MiniSeg rely on its low update frequency and need to be tuned again (f.ex. with Host_Tools/GainSweep).
+
 #ifdef TIVSEG
-#define CFG_CTLR_UPDATE_FREQ             100                // Setting for TivSeg
-#define CFG_CTLR_FILTER_FACT             0.995f             // @100Hz update frequency. Determined by experiments.
+#define CFG_CTLR_DEVICE_PARAMS           TivSegParams       // Parameter set tuned for the device (see ControllerParams.h)
+#define CFG_CTLR_DEVICE_UPDATE_FREQ      CFG_CTLR_TIVSEG_UPDATE_FREQ
 #endif
 
 #ifdef MINISEG
-#define CFG_CTLR_UPDATE_FREQ             10                 // Setting for MiniSeg
-#define CFG_CTLR_FILTER_FACT             0.95f              // Setting for MiniSeg
+#define CFG_CTLR_DEVICE_PARAMS           MiniSegParams      // Parameter set tuned for the device (see ControllerParams.h)
+#define CFG_CTLR_DEVICE_UPDATE_FREQ      CFG_CTLR_MINISEG_UPDATE_FREQ
+#endif
+
+#if CFG_CTLR_HIGH_RATE
+#define CFG_CTLR_PARAMS                  HighRateParams<CFG_CTLR_DEVICE_PARAMS, CFG_CTLR_HIGH_RATE_FREQ> // Parameter set the Controller is compiled for
+#define CFG_CTLR_UPDATE_FREQ             CFG_CTLR_HIGH_RATE_FREQ
+#else
+#define CFG_CTLR_PARAMS                  CFG_CTLR_DEVICE_PARAMS // Parameter set the Controller is compiled for
+#define CFG_CTLR_UPDATE_FREQ             CFG_CTLR_DEVICE_UPDATE_FREQ
 #endif
 
+#if CFG_RIDELOG_ENABLE && CFG_CTLR_UPDATE_FREQ > CFG_RIDELOG_MAX_FREQ
+#error "The ride log can't send a record per update at this update frequency (see CFG_RIDELOG_ENABLE)."
+#endif
+
+#if CFG_SENSOR_SAMPLE_FREQ < CFG_CTLR_UPDATE_FREQ || 2 * CFG_SENSOR_LOW_PASS > CFG_CTLR_UPDATE_FREQ
+#error "The sensor must sample at least at the update frequency, its low pass filter must not pass more than half of it (see CFG_SENSOR_SAMPLE_FREQ)."
+#endif
+
+#ifndef CFG_CTLR_ANGLE_GAIN
+#define CFG_CTLR_ANGLE_GAIN              5.0f               // Torque per rad of tilt. Determined by experiments. This gain and the following ones with #ifndef can be set with -D (f.ex. to try a set of Host_Tools/GainSweep in Host_Tools/SegwaySim).
+#endif
+#ifndef CFG_CTLR_RATE_GAIN
+#define CFG_CTLR_RATE_GAIN               0.2f               // Torque per rad/s of angle rate. Reduced from 0.4 to prevent oscillations (forward - backward).
+#endif
+#ifndef CFG_CTLR_DRIVE_GAIN
+#define CFG_CTLR_DRIVE_GAIN              1.2f               // Acceleration of the drive speed per torque.
+#endif
+#ifndef CFG_CTLR_OVERSPEED_GAIN
+#define CFG_CTLR_OVERSPEED_GAIN          0.4f               // Tilt back [rad] per overspeed.
+#endif
+#ifndef CFG_CTLR_OVERSPEED_INT_GAIN
+#define CFG_CTLR_OVERSPEED_INT_GAIN      0.7f               // Tilt back [rad] per integrated overspeed.
+#endif
+#define CFG_CTLR_OVERSPEED_DECAY         0.04f              // Decay [1/s] of the integrated overspeed after the speed dropped below the limit.
+#define CFG_CTLR_RAW_SENSOR_VALUES       false              // Hand the raw sensor values to the controller, which converts them with one precomputed factor.
+#define CFG_CTLR_MEASURED_DT             false              // Integrate with the measured time since the last update (see Controller::setUpdatePeriodUS) instead of the nominal 1 / CFG_CTLR_UPDATE_FREQ. Compensates late updates (see Scheduler::getDeadlineMisses).
+#define CFG_CTLR_DELAY_COMPENSATION      false              // Compensate the delay of the sensor's low pass filter by extrapolating the angle. The gains have been determined without it.
+#define CFG_CTLR_ESTIMATOR               ComplementaryEstimator // Estimator of the angle (see Estimator.h): ComplementaryEstimator (CFG_CTLR_*_FILTER_FACT) or KalmanEstimator (CFG_CTLR_KALMAN_*).
+#define CFG_CTLR_KALMAN_GYRO_NOISE       0.05f              // Noise [rad/s] of the angle rate (standard deviation), including vibrations.
+#define CFG_CTLR_KALMAN_BIAS_NOISE       0.001f             // Random walk [rad/s/sqrt(s)] of the gyroscope offset.
+#define CFG_CTLR_KALMAN_ACCEL_NOISE      0.1f               // Noise [rad] of the accelerometer angle (standard deviation), mostly caused by accelerating.
+#define CFG_CTLR_ADAPTIVE_ACCEL          false              // Weight the accelerometer angle less the more the acceleration differs from 1g (f.ex. when accelerating hard).
+#define CFG_CTLR_ACCEL_TOLERANCE         0.2f               // Difference [g] from 1g at which the accelerometer angle is ignored completely (adaptive mode).
+#define CFG_CTLR_SPEED_TO_ACCEL          0.0f               // Acceleration [g] per change of the drive speed per second. Subtracted from the horizontal acceleration in adaptive mode. Depends on motors and wheels, 0.0f disables it.
+#define CFG_CTLR_FAST_ATAN2              true               // Compute the angle of the accelerometer with fastAtan2 (max. error 0.0007deg, see FastMath.h) instead of the much slower atan2f.
 #define CFG_CTLR_MAX_SPEED               0.5f
+#ifndef CFG_CTLR_LOW_PASS_FACT
 #define CFG_CTLR_LOW_PASS_FACT           0.1f               // @100Hz update frequency. Determined by experiments.
+#endif
 #define CFG_CTLR_MAXDUTY                 0.9f               // Duty cycle needs to be limited to 0.9 for the motor driver of the TivSeg. Value could be 1.0 for MiniSeg
 
 #endif /* CONFIG_H_ */
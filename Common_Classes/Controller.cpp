@@ -12,21 +12,31 @@
 
 #include "Controller.h"
 
-Controller::Controller()
+template <class Params, template <class> class Estimator>
+constexpr float Controller<Params, Estimator>::RAW_TO_ANGLE_RATE;
+template <class Params, template <class> class Estimator>
+constexpr float Controller<Params, Estimator>::RAW_TO_ANGLE_CHANGE;
+template <class Params, template <class> class Estimator>
+constexpr float Controller<Params, Estimator>::RAW_TO_ACCEL;
+
+template <class Params, template <class> class Estimator>
+Controller<Params, Estimator>::Controller()
 {
     /*
      * Default empty constructor
      */
 }
 
-Controller::~Controller()
+template <class Params, template <class> class Estimator>
+Controller<Params, Estimator>::~Controller()
 {
     /*
      * Default empty destructor
      */
 }
 
-void Controller::init(System *sys, float maxSpeed)
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::init(System *sys, float maxSpeed)
 {
     /*
      * Initialize the controller by configuring the working and behavior
@@ -37,18 +47,27 @@ void Controller::init(System *sys, float maxSpeed)
 
     // Create local reference to the given System object.
     this->sys = sys;
+    arcTanProbe = sys->addProbe(CFG_CTLR_FAST_ATAN2 ? "fastAtan2" : "atan2f");
+    angleChannel = sys->addDebugChannel("Angle_[0.1deg]", DEBUGFRAME_FLOAT);
+    if (CFG_CTLR_ADAPTIVE_ACCEL)
+    {
+        accelTrustChannel = sys->addDebugChannel("Accel_Trust_[%]");
+    }
 
     // We use floats, therefore we want to profit from the FPU.
     // Check if it's already enabled and if not, enable it.
     sys->enableFPU();
 
+    estimator.init();
+
     this->maxSpeed = maxSpeed;
 
     // Initialize speed values
     resetSpeeds();
 }
 
-void Controller::resetSpeeds()
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::resetSpeeds()
 {
     /*
      * Reset all speed values to 0
@@ -59,8 +78,11 @@ void Controller::resetSpeeds()
     rightSpeed = 0.0f;
 }
 
-void Controller::updateValuesRad(float steeringValue, float angleRateRad,
-                                 float accelHor, float accelVer)
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::updateValuesRad(float steeringValue,
+                                                    float angleRateRad,
+                                                    float accelHor,
+                                                    float accelVer)
 {
     /*
      * Feed current sensor values into the controller to generate new PWM
@@ -74,23 +96,98 @@ void Controller::updateValuesRad(float steeringValue, float angleRateRad,
      * accelVer:      vertical acceleration in g
      */
 
-    // Get angle from accelerometer and gyrometer. Factor by experiments.
-    // Based on http://www.ups.bplaced.de/Dokumentation/Runner%207.38.pdf
-    float angleAccelRad = atan2f(-accelHor, -accelVer);
-    angleRad = compFilter(integrate(angleRad, angleRateRad),
-                              angleAccelRad, CFG_CTLR_FILTER_FACT);
+    float angleChangeRad = angleRateRad * scaleDT(Params::DT);
+    updateValues(steeringValue, angleRateRad, angleChangeRad,
+                 accelHor, accelVer);
+}
+
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::updateValuesRaw(float steeringValue,
+                                                    int32_t rawAngleRate,
+                                                    int32_t rawAccelHor,
+                                                    int32_t rawAccelVer)
+{
+    /*
+     * Same as Controller::updateValuesRad but with raw sensor values (see
+     * MPU6050::getRawAngleRate and the like). All unit conversions are done
+     * with a single multiplication by a constant computed at compile time.
+     *
+     * steeringValue: value from -1.0f (right) to 1.0f (left).
+     * rawAngleRate:  angle rate around the wheel axis in sensor units
+     * rawAccelHor:   horizontal acceleration in sensor units
+     * rawAccelVer:   vertical acceleration in sensor units
+     */
+
+    float angleRateRad = rawAngleRate * RAW_TO_ANGLE_RATE;
+    float angleChangeRad = rawAngleRate * scaleDT(RAW_TO_ANGLE_CHANGE);
+    updateValues(steeringValue, angleRateRad, angleChangeRad,
+                 rawAccelHor * RAW_TO_ACCEL, rawAccelVer * RAW_TO_ACCEL);
+}
+
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::updateValues(float steeringValue,
+                                                 float angleRateRad,
+                                                 float angleChangeRad,
+                                                 float accelHor,
+                                                 float accelVer)
+{
+    /*
+     * Controller algorithm used by Controller::updateValuesRad and
+     * Controller::updateValuesRaw.
+     *
+     * steeringValue:  value from -1.0f (right) to 1.0f (left).
+     * angleRateRad:   angle rate around the wheel axis in rad/s
+     * angleChangeRad: change of the angle in rad since the last update
+     *                 (integrated angle rate)
+     * accelHor:       horizontal acceleration in g
+     * accelVer:       vertical acceleration in g
+     */
+
+    // Start of the estimation (see Controller::getEstimationCycles).
+    uint32_t estimationStart = CFG_CYCLE_BUDGET ? sys->getCycles() : 0;
+
+    /*
+     * In adaptive mode the angle of the accelerometer is trusted less the
+     * more the acceleration differs from 1g, because it's then dominated by
+     * the movement of the segway and not by gravity. Additionally the known
+     * acceleration of the drive (derivative of driveSpeed, which is
+     * proportional to the last torque) is removed first.
+     * |a| - 1g is approximated by (|a|^2 - 1g^2) / 2 to avoid the root.
+     */
+    float accelTrust = 1.0f;
+    if (CFG_CTLR_ADAPTIVE_ACCEL)
+    {
+        accelHor -= Params::DRIVE_ACCEL_GAIN * torque;
+        float deviation = 0.5f * fabsf(accelHor * accelHor
+                                       + accelVer * accelVer - 1.0f);
+        accelTrust = fmaxf(0.0f, 1.0f - deviation * Params::ACCEL_TRUST_SLOPE);
+        sys->setDebugVal(accelTrustChannel, accelTrust * 100.0f);
+    }
+    float angleAccelRad = arcTanRad(-accelHor, -accelVer);
+
+    // Get angle from accelerometer and gyrometer (see Estimator.h).
+    estimator.update(angleRateRad, angleChangeRad, angleAccelRad, accelTrust,
+                     scaleDT(Params::DT));
+    float angleRad = estimator.getAngle();
+    if (CFG_CYCLE_BUDGET)
+    {
+        estimationCycles = sys->getCycles() - estimationStart;
+    }
 
     // A low pass filter to prevent higher frequency oscillations (forward -
     // backward). Factor by experiments.
-    angleRate = compFilter(angleRateRad, angleRate, CFG_CTLR_LOW_PASS_FACT);
+    angleRate = compFilter(estimator.getAngleRate(), angleRate,
+                           Params::LOW_PASS_FACT);
 
     /*
-     * Calculate torque needed for balance.
-     * Note: the reduction of the factor 0.4 to 0.2 is needed to prevent
-     * higher frequency oscillations (forward - backward). Factor by
-     * experiments.
+     * Calculate torque needed for balance. Gains by experiments (see
+     * Config.h).
+     * The angle is extrapolated by the sensor delay (0 by default, see
+     * Controller::setSensorDelayUS).
      */
-    torque = 5.0f * (angleRad - angleStableRad) + 0.2f * angleRate;
+    torque = Params::ANGLE_GAIN * (angleRad + sensorDelay * angleRate
+                                   - angleStableRad)
+             + Params::RATE_GAIN * angleRate;
 
     // Speed limiter
     float overspeed = driveSpeed - maxSpeed;
@@ -107,28 +204,30 @@ void Controller::updateValuesRad(float steeringValue, float angleRateRad,
         // stop speed limiter
         if (overspeedInt > 0.0f)
         {
-            overspeedInt -= 0.04f / CFG_CTLR_UPDATE_FREQ;
+            overspeedInt -= scaleDT(Params::OVERSPEED_DECAY_DT);
         }
     }
 
     // New stable position
-    angleStableRad = 0.4f * overspeed + 0.7f * overspeedInt;
+    angleStableRad = Params::OVERSPEED_GAIN * overspeed
+                     + Params::OVERSPEED_INT_GAIN * overspeedInt;
 
     // Reduce steering when driving faster
     float steeringAdjusted = 0.07f / (0.3f + fabsf(driveSpeed)) * steeringValue;
 
     // Update current drive speed
-    driveSpeed = integrate(driveSpeed, 1.2f * torque);
+    driveSpeed += scaleDT(Params::DRIVE_GAIN_DT) * torque;
 
     // Apply steering. Note: *increasing* leftSpeed actually causes the segway
     // to turn to the *right*!
     leftSpeed  = torque + driveSpeed + steeringAdjusted;
     rightSpeed = torque + driveSpeed - steeringAdjusted;
 
-    sys->setDebugVal("Angle_[0.1deg]", angleRad * 1800.0f / 3.14159f);
+    sys->setDebugValFloat(angleChannel, angleRad * (1800.0f / 3.14159f));
 }
 
-float Controller::getLeftSpeed()
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::getLeftSpeed()
 {
     /*
      * Returns the duty cycle for the left motor as float. 
@@ -152,7 +251,8 @@ float Controller::getLeftSpeed()
     return leftSpeed;
 }
 
-float Controller::getRightSpeed()
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::getRightSpeed()
 {
     /*
      * Returns the duty cycle for the right motor as float. 
@@ -176,17 +276,87 @@ float Controller::getRightSpeed()
     return rightSpeed;
 }
 
-float Controller::getMaxSpeed()
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::getMaxSpeed()
 {
     return maxSpeed;
 }
 
-void Controller::setMaxSpeed(float speed)
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::setMaxSpeed(float speed)
 {
     maxSpeed = speed;
 }
 
-float Controller::integrate(float last, float current)
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::getAngle()
+{
+    /*
+     * Returns the angle in rad estimated by the last update.
+     */
+
+    return estimator.getAngle();
+}
+
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::getTorque()
+{
+    /*
+     * Returns the torque (as duty cycle) computed by the last update to
+     * balance the segway, before the drive speed and the steering are
+     * added.
+     */
+
+    return torque;
+}
+
+template <class Params, template <class> class Estimator>
+uint32_t Controller<Params, Estimator>::getEstimationCycles()
+{
+    /*
+     * Returns the CPU cycles the last update needed for the estimation of
+     * the angle (accelerometer angle and estimator). The rest of the update
+     * is the control itself. Only measured if CFG_CYCLE_BUDGET is enabled.
+     */
+
+    return estimationCycles;
+}
+
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::setSensorDelayUS(uint32_t delayUS)
+{
+    /*
+     * Compensate the delay of the sensor values (f.ex. caused by a low pass
+     * filter) by extrapolating the angle with the current angle rate.
+     * Default is no compensation.
+     *
+     * delayUS: Delay of the sensor values in microseconds.
+     */
+
+    sensorDelay = delayUS * 0.000001f;
+}
+
+template <class Params, template <class> class Estimator>
+void Controller<Params, Estimator>::setUpdatePeriodUS(uint32_t periodUS)
+{
+    /*
+     * Set the measured time since the last update. It's used instead of
+     * Params::DT to integrate the angle rate, the drive speed and the
+     * overspeed and to remove the estimated gyroscope offset if
+     * CFG_CTLR_MEASURED_DT is enabled. The estimator keeps its nominal
+     * filter factors.
+     * Call it before each update with the time since the start of the last
+     * one. Periods shorter than half or longer than twice the nominal one
+     * (f.ex. the first update) are limited.
+     *
+     * periodUS: Time since the last update in microseconds.
+     */
+
+    dtScale = fminf(2.0f, fmaxf(0.5f, periodUS * 0.000001f / Params::DT));
+}
+
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::integrate(float last, float current)
 {
     /*
      * Integrates numerically.
@@ -196,18 +366,54 @@ float Controller::integrate(float last, float current)
      * current:    value to integrate
      */
 
-    return (last + current / CFG_CTLR_UPDATE_FREQ);
+    return (last + current * scaleDT(Params::DT));
 }
 
-float Controller::arcTanDeg(float a, float b)
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::scaleDT(float valueDT)
+{
+    /*
+     * Converts a value proportional to the nominal update period (f.ex.
+     * Params::DRIVE_GAIN_DT) to the measured one if CFG_CTLR_MEASURED_DT is
+     * enabled (see Controller::setUpdatePeriodUS). Otherwise the value is
+     * returned unchanged and the constant stays precomputed.
+     */
+
+    if (CFG_CTLR_MEASURED_DT)
+    {
+        return valueDT * dtScale;
+    }
+    return valueDT;
+}
+
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::arcTanRad(float a, float b)
+{
+    /*
+     * Returns arctan(a/b) in radian (range -pi to pi). Uses the approximation
+     * fastAtan2 if enabled in Config.h (CFG_CTLR_FAST_ATAN2).
+     */
+
+    ProbeScope probe(sys, arcTanProbe);
+
+    if (CFG_CTLR_FAST_ATAN2)
+    {
+        return fastAtan2(a, b);
+    }
+    return atan2f(a, b);
+}
+
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::arcTanDeg(float a, float b)
 {
     /*
      * Returns arctan(a/b) in degree.
      */
-    return (atan2f(a, b) * 180.0f / 3.14159265358979f);
+    return (arcTanRad(a, b) * (180.0f / 3.14159265358979f));
 }
 
-float Controller::compFilter(float a, float b, float filterFactor)
+template <class Params, template <class> class Estimator>
+float Controller<Params, Estimator>::compFilter(float a, float b, float filterFactor)
 {
     /*
      * Applies a complementary filter.
@@ -215,3 +421,19 @@ float Controller::compFilter(float a, float b, float filterFactor)
 
     return (filterFactor * a + (1.0f - filterFactor) * b);
 }
+
+
+// The parameter sets and estimators the controller is compiled for. Config.h
+// selects the ones which are used (CFG_CTLR_PARAMS, CFG_CTLR_ESTIMATOR).
+template class Controller<TivSegParams, ComplementaryEstimator>;
+template class Controller<TivSegParams, KalmanEstimator>;
+template class Controller<MiniSegParams, ComplementaryEstimator>;
+template class Controller<MiniSegParams, KalmanEstimator>;
+template class Controller<HighRateParams<TivSegParams, CFG_CTLR_HIGH_RATE_FREQ>,
+                          ComplementaryEstimator>;
+template class Controller<HighRateParams<TivSegParams, CFG_CTLR_HIGH_RATE_FREQ>,
+                          KalmanEstimator>;
+template class Controller<HighRateParams<MiniSegParams, CFG_CTLR_HIGH_RATE_FREQ>,
+                          ComplementaryEstimator>;
+template class Controller<HighRateParams<MiniSegParams, CFG_CTLR_HIGH_RATE_FREQ>,
+                          KalmanEstimator>;
@@ -8,6 +8,9 @@
  *
  * The controller class contains the algorithm which determines the motor drive
  * speeds based on an angle rate, an angle value and a steering position.
+ * It's a template specialized at compile time for a parameter set (see
+ * ControllerParams.h) and an estimator of the angle (see Estimator.h), f.ex.
+ * Controller<TivSegParams, KalmanEstimator>.
  */
 
 #ifndef CONTROLLER_H_
@@ -18,14 +21,25 @@
  * math.h:   Floating point math functions like fabsf()
  * Config.h: All configurable parameters of the segway, as for example its pinout. Note: all constants are prefixed by CFG_.
  * System.h: Header file for the System class (needed for error handling)
+ * MPU6050.h: Header file for the MPU6050 class (needed for the units of raw
+ *            sensor values)
+ * ControllerParams.h: Parameter sets the controller can be compiled for.
+ * FastMath.h: Fast approximations of math.h functions like fastAtan2()
+ * Estimator.h: Estimators of the angle the controller can be compiled with.
  */
 #include <stdint.h>
 #include <math.h>
 #include "Config.h"
 #include "System.h"
+#include "MPU6050.h"
+#include "ControllerParams.h"
+#include "FastMath.h"
+#include "Estimator.h"
 
 
 
+template <class Params,
+          template <class> class Estimator = ComplementaryEstimator>
 class Controller
 {
 public:
@@ -34,19 +48,28 @@ public:
     void init(System *sys, float maxSpeed);
     void resetSpeeds();
     void updateValuesRad(float steeringValue, float angleRate, float accelHor, float accelVer);
+    void updateValuesRaw(float steeringValue, int32_t rawAngleRate, int32_t rawAccelHor, int32_t rawAccelVer);
     float getLeftSpeed();
     float getRightSpeed();
+    float getAngle();
+    float getTorque();
     float getMaxSpeed();
     void setMaxSpeed(float speed);
+    void setSensorDelayUS(uint32_t delayUS);
+    void setUpdatePeriodUS(uint32_t periodUS);
+    uint32_t getEstimationCycles();
 
 private:
+    void updateValues(float steeringValue, float angleRateRad,
+                      float angleChangeRad, float accelHor, float accelVer);
     float integrate(float last, float current);
+    float scaleDT(float valueDT);
+    float arcTanRad(float a, float b);
     float arcTanDeg(float a, float b);
     float compFilter(float a, float b, float filterFactor);
 
     System* sys;
-    uint32_t freq = 0;
-    float angleRad = 0.0f;
+    Estimator<Params> estimator;
     float angleRate = 0.0f;
     float angleStableRad = 0.0f;
     float torque = 0.0f;
@@ -54,6 +77,23 @@ private:
     float leftSpeed = 0.0f, rightSpeed = 0.0f;
     float driveSpeed = 0.0f;
     float maxSpeed = 1.0f;
+    float sensorDelay = 0.0f;
+    float dtScale = 1.0f;
+    uint32_t estimationCycles = 0;
+    uint8_t arcTanProbe; // see System::addProbe
+
+    // Debug values (see System::addDebugChannel)
+    uint8_t angleChannel = System::NO_DEBUG_CHANNEL;
+    uint8_t accelTrustChannel = System::NO_DEBUG_CHANNEL;
+
+    // Conversion of raw angle rates (see Controller::updateValuesRaw) to
+    // rad/s and to the angle change in rad during one update period.
+    static constexpr float RAW_TO_ANGLE_RATE = MPU6050::ANGLE_RATE_PER_LSB;
+    static constexpr float RAW_TO_ANGLE_CHANGE = MPU6050::ANGLE_RATE_PER_LSB
+                                                 * Params::DT;
+
+    // Conversion of raw accelerations to g.
+    static constexpr float RAW_TO_ACCEL = MPU6050::ACCEL_PER_LSB;
 };
 
 
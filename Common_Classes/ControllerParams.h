@@ -0,0 +1,88 @@
+/*
+ * ControllerParams.h
+ *
+ * Parameter sets of the Controller class (see Controller.h). The controller
+ * is a template which is compiled once for each set. All factors depending
+ * on the update frequency are computed here at compile time, therefore the
+ * controller doesn't need any division at runtime.
+ * The values themselves are configured in Config.h.
+ */
+
+#ifndef CONTROLLERPARAMS_H_
+#define CONTROLLERPARAMS_H_
+
+/*
+ * stdint.h: Variable definitions for the C99 standard
+ * Config.h: All configurable parameters of the segway, as for example its pinout. Note: all constants are prefixed by CFG_.
+ */
+#include <stdint.h>
+#include "Config.h"
+
+
+template <uint32_t updateFreq>
+struct ControllerParams
+{
+    /*
+     * Gains common to all segways and the factors derived from them for the
+     * given update frequency. The parameter sets of the segways inherit
+     * from it and add the values which have been tuned for each of them.
+     */
+
+    static constexpr uint32_t UPDATE_FREQ = updateFreq;
+
+    // Duration of one update period in s.
+    static constexpr float DT = 1.0f / updateFreq;
+
+    static constexpr float ANGLE_GAIN = CFG_CTLR_ANGLE_GAIN;
+    static constexpr float RATE_GAIN = CFG_CTLR_RATE_GAIN;
+    static constexpr float OVERSPEED_GAIN = CFG_CTLR_OVERSPEED_GAIN;
+    static constexpr float OVERSPEED_INT_GAIN = CFG_CTLR_OVERSPEED_INT_GAIN;
+    static constexpr float LOW_PASS_FACT = CFG_CTLR_LOW_PASS_FACT;
+
+    // Adaptive weighting of the accelerometer: decrease of the weight per g
+    // of deviation from 1g, and acceleration of the drive in g per torque.
+    static constexpr float ACCEL_TRUST_SLOPE = 1.0f / CFG_CTLR_ACCEL_TOLERANCE;
+    static constexpr float DRIVE_ACCEL_GAIN = CFG_CTLR_SPEED_TO_ACCEL
+                                              * CFG_CTLR_DRIVE_GAIN;
+
+    // Change of the drive speed per torque and of the integrated overspeed
+    // during one update period.
+    static constexpr float DRIVE_GAIN_DT = CFG_CTLR_DRIVE_GAIN * DT;
+    static constexpr float OVERSPEED_DECAY_DT = CFG_CTLR_OVERSPEED_DECAY * DT;
+};
+
+
+struct TivSegParams : ControllerParams<CFG_CTLR_TIVSEG_UPDATE_FREQ>
+{
+    static constexpr float FILTER_FACT = CFG_CTLR_TIVSEG_FILTER_FACT;
+};
+
+
+struct MiniSegParams : ControllerParams<CFG_CTLR_MINISEG_UPDATE_FREQ>
+{
+    static constexpr float FILTER_FACT = CFG_CTLR_MINISEG_FILTER_FACT;
+};
+
+
+template <class Device, uint32_t updateFreq>
+struct HighRateParams : ControllerParams<updateFreq>
+{
+    /*
+     * Parameter set of a device (f.ex. TivSegParams) for a higher update
+     * frequency (CFG_CTLR_HIGH_RATE). The filter factors have been tuned
+     * per update period of the device. They are converted so that the time
+     * constants of the filters stay the same: the weight of each new value
+     * shrinks with the ratio of the update periods. This is the first order
+     * approximation of fact^ratio, which is accurate to a few percent of
+     * the time constant for the tuned factors.
+     */
+
+    static constexpr float RATIO = (float) Device::UPDATE_FREQ / updateFreq;
+
+    static constexpr float FILTER_FACT = 1.0f - (1.0f - Device::FILTER_FACT)
+                                                * RATIO;
+    static constexpr float LOW_PASS_FACT = Device::LOW_PASS_FACT * RATIO;
+};
+
+
+#endif /* CONTROLLERPARAMS_H_ */
@@ -0,0 +1,89 @@
+/*
+ * DebugFrame.h
+ *
+ * Binary format of the debug values (see System::setDebugBinary). Compared
+ * to the text format no printf is needed and each value takes 2 or 4 bytes
+ * instead of 5 to 12 characters. But each frame carries its own header and
+ * CRC (16 bytes) and the values aren't batched, so a frame with the debug
+ * values of the segway is only about 1.1 to 1.3 times smaller than the
+ * text line. Host_Tools/DebugDecode.cpp converts a capture to CSV or to the
+ * text format of the Arduino Serial Plotter.
+ *
+ * Frame format (little endian, floats IEEE 754 single precision):
+ *  - DebugFrameHeader
+ *  - payload (DebugFrameHeader::length bytes)
+ *  - CRC-16/CCITT (see debugFrameCRC) of the header and the payload
+ * Payload of a DEBUGFRAME_VALUES frame:
+ *  - the type (DEBUGFRAME_INT16, ...) of each channel contained, 2 bits
+ *    each, the first channel in the lowest bits, padded to full bytes
+ *  - the values of these channels in the order of the channel numbers
+ * Payload of a DEBUGFRAME_SCHEMA frame (sent whenever a channel is added,
+ * see System::addDebugChannel), for each channel contained:
+ *  - its type (DEBUGFRAME_INT32 or DEBUGFRAME_FLOAT, 1 byte)
+ *  - its decimation (uint16_t): it's contained in every decimation-th
+ *    value frame only
+ *  - its name, terminated by a 0
+ * The names are only sent in the schema frames.
+ * The sync word allows the host to find the frames and to resynchronize
+ * after lost bytes; the CRC rejects the rest.
+ */
+
+#ifndef DEBUGFRAME_H_
+#define DEBUGFRAME_H_
+
+
+/*
+ * stdint.h:                Variable definitions for the C99 standard
+ */
+#include <stdint.h>
+
+
+// Sync word ("DF" as bytes on the UART).
+const uint16_t DEBUGFRAME_SYNC = 0x4644;
+
+// Frame types
+const uint8_t DEBUGFRAME_VALUES = 'V';
+const uint8_t DEBUGFRAME_SCHEMA = 'S';
+
+// Types of the values
+const uint8_t DEBUGFRAME_INT16 = 1;
+const uint8_t DEBUGFRAME_INT32 = 2;
+const uint8_t DEBUGFRAME_FLOAT = 3;
+
+// Channels per frame (bits of DebugFrameHeader::mask).
+const uint32_t DEBUGFRAME_MAX_CHANNELS = 32;
+
+
+struct DebugFrameHeader
+{
+    uint16_t sync;              // DEBUGFRAME_SYNC
+    uint8_t type;               // DEBUGFRAME_VALUES or DEBUGFRAME_SCHEMA
+    uint8_t sequence;           // incremented with each frame
+    uint32_t cycles;            // System::getCycles when the frame was sent
+    uint32_t mask;              // bit i set: channel i is contained
+    uint16_t length;            // bytes of the payload
+};
+
+// Header without padding bytes.
+const uint32_t DEBUGFRAME_HEADER_SIZE = 14;
+
+
+inline uint16_t debugFrameCRC(uint16_t crc, const uint8_t *data,
+                              uint32_t length)
+{
+    /*
+     * Update the CRC-16/CCITT (polynomial 0x1021, start with 0xffff) with
+     * the given bytes. Computed bytewise without a table.
+     */
+
+    for (uint32_t i = 0; i < length; i++)
+    {
+        uint8_t x = (crc >> 8) ^ data[i];
+        x ^= x >> 4;
+        crc = (crc << 8) ^ ((uint16_t) x << 12) ^ ((uint16_t) x << 5) ^ x;
+    }
+    return crc;
+}
+
+
+#endif /* DEBUGFRAME_H_ */
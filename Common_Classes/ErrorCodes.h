@@ -39,6 +39,10 @@ enum ErrorCodes
     MPUHorEqualsWheelAxis,  // char hor
 
     // Add custom codes here
+    MPUWrongSampleRate,     // uint32_t freq
+    SchedulerWrongConfig,   // uint32_t freq
+    SysTooManyProbes,       // const char *name
+    MPUFifoWithDataReady,   // uint32_t fifoSamples
 
 };
 
@@ -0,0 +1,180 @@
+/*
+ * Estimator.cpp
+ *
+ * Estimators of the segway's tilt angle from the angle rate and the angle
+ * measured by the accelerometer (see Estimator.h).
+ */
+
+#include "Estimator.h"
+
+
+template <class Params>
+void ComplementaryEstimator<Params>::init()
+{
+    /*
+     * Nothing to prepare. Starts at an angle of 0.
+     */
+
+    angleRad = 0.0f;
+    angleRate = 0.0f;
+}
+
+template <class Params>
+void ComplementaryEstimator<Params>::update(float angleRateRad,
+                                            float angleChangeRad,
+                                            float angleAccelRad,
+                                            float accelTrust,
+                                            float /* dt */)
+{
+    /*
+     * Weights the integrated angle rate with Params::FILTER_FACT and the
+     * angle of the accelerometer with the rest. Factor by experiments.
+     *
+     * angleRateRad:   angle rate around the wheel axis in rad/s
+     * angleChangeRad: change of the angle in rad since the last update
+     *                 (integrated angle rate)
+     * angleAccelRad:  angle in rad measured by the accelerometer
+     * accelTrust:     scales the weight of the accelerometer angle
+     * dt:             not needed, the angle change contains it
+     */
+
+    float predicted = angleRad + angleChangeRad;
+    angleRad = predicted + accelTrust * (1.0f - Params::FILTER_FACT)
+                           * (angleAccelRad - predicted);
+    angleRate = angleRateRad;
+}
+
+template <class Params>
+float ComplementaryEstimator<Params>::getAngle()
+{
+    return angleRad;
+}
+
+template <class Params>
+float ComplementaryEstimator<Params>::getAngleRate()
+{
+    /*
+     * The complementary filter doesn't estimate the offset of the angle
+     * rate. Returns it as is.
+     */
+
+    return angleRate;
+}
+
+
+template <class Params>
+void KalmanEstimator<Params>::init()
+{
+    /*
+     * Compute the steady state gains by iterating the Riccati equation of
+     * the filter until they don't change anymore. Takes a few milliseconds,
+     * which is why it's done once here and not with each update.
+     *
+     * Model (dt = update period):
+     *     angle = angle + (angleRate - bias) * dt
+     *     bias  = bias
+     * Process noise: gyroscope noise (integrated over dt) on the angle,
+     * random walk of the offset on the bias.
+     * Measurement:   angle of the accelerometer.
+     */
+
+    const float DT = Params::DT;
+    const float angleNoise = (CFG_CTLR_KALMAN_GYRO_NOISE * DT)
+                             * (CFG_CTLR_KALMAN_GYRO_NOISE * DT);
+    const float biasNoise = CFG_CTLR_KALMAN_BIAS_NOISE
+                            * CFG_CTLR_KALMAN_BIAS_NOISE * DT;
+    const float accelNoise = CFG_CTLR_KALMAN_ACCEL_NOISE
+                             * CFG_CTLR_KALMAN_ACCEL_NOISE;
+
+    // Symmetric error covariance matrix [p00 p01; p01 p11]. Starts with a
+    // high uncertainty.
+    float p00 = 1.0f, p01 = 0.0f, p11 = 1.0f;
+
+    for (uint32_t i = 0; i < GAIN_ITERATIONS; i++)
+    {
+        // Prediction
+        float q00 = p00 - 2.0f * DT * p01 + DT * DT * p11 + angleNoise;
+        float q01 = p01 - DT * p11;
+        float q11 = p11 + biasNoise;
+
+        // Gains and correction
+        float newAngleGain = q00 / (q00 + accelNoise);
+        float newBiasGain = q01 / (q00 + accelNoise);
+        p00 = (1.0f - newAngleGain) * q00;
+        p01 = (1.0f - newAngleGain) * q01;
+        p11 = q11 - newBiasGain * q01;
+
+        if (newAngleGain == angleGain && newBiasGain == biasGain)
+        {
+            break;
+        }
+        angleGain = newAngleGain;
+        biasGain = newBiasGain;
+    }
+
+    angleRad = 0.0f;
+    angleRate = 0.0f;
+    biasRad = 0.0f;
+}
+
+template <class Params>
+void KalmanEstimator<Params>::update(float angleRateRad, float angleChangeRad,
+                                     float angleAccelRad, float accelTrust,
+                                     float dt)
+{
+    /*
+     * Predict the angle with the angle rate and correct angle and offset
+     * by the difference to the angle of the accelerometer.
+     *
+     * angleRateRad:   angle rate around the wheel axis in rad/s
+     * angleChangeRad: change of the angle in rad since the last update
+     *                 (integrated angle rate)
+     * angleAccelRad:  angle in rad measured by the accelerometer
+     * accelTrust:     scales the correction by the accelerometer
+     * dt:             time since the last update in s, the one the angle
+     *                 change was integrated over
+     */
+
+    float predicted = angleRad + angleChangeRad - biasRad * dt;
+    float innovation = accelTrust * (angleAccelRad - predicted);
+    angleRad = predicted + angleGain * innovation;
+    biasRad += biasGain * innovation;
+    angleRate = angleRateRad - biasRad;
+}
+
+template <class Params>
+float KalmanEstimator<Params>::getAngle()
+{
+    return angleRad;
+}
+
+template <class Params>
+float KalmanEstimator<Params>::getAngleRate()
+{
+    return angleRate;
+}
+
+template <class Params>
+float KalmanEstimator<Params>::getBias()
+{
+    /*
+     * Returns the estimated offset of the angle rate in rad/s.
+     */
+
+    return biasRad;
+}
+
+
+// The parameter sets the estimators are compiled for (see Controller.cpp).
+template class ComplementaryEstimator<TivSegParams>;
+template class ComplementaryEstimator<MiniSegParams>;
+template class KalmanEstimator<TivSegParams>;
+template class KalmanEstimator<MiniSegParams>;
+template class ComplementaryEstimator<
+    HighRateParams<TivSegParams, CFG_CTLR_HIGH_RATE_FREQ> >;
+template class ComplementaryEstimator<
+    HighRateParams<MiniSegParams, CFG_CTLR_HIGH_RATE_FREQ> >;
+template class KalmanEstimator<
+    HighRateParams<TivSegParams, CFG_CTLR_HIGH_RATE_FREQ> >;
+template class KalmanEstimator<
+    HighRateParams<MiniSegParams, CFG_CTLR_HIGH_RATE_FREQ> >;
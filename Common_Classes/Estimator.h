@@ -0,0 +1,85 @@
+/*
+ * Estimator.h
+ *
+ * Estimators of the segway's tilt angle from the angle rate and the angle
+ * measured by the accelerometer. The Controller class is a template on the
+ * estimator (selected in Config.h with CFG_CTLR_ESTIMATOR), therefore all
+ * estimators provide the same methods:
+ *  - init():        Prepare the estimator (called by Controller::init).
+ *  - update(angleRateRad, angleChangeRad, angleAccelRad, accelTrust, dt):
+ *                   Feed the sensor values of one update period of dt
+ *                   seconds. The correction by the accelerometer angle is
+ *                   scaled by accelTrust (0.0f to 1.0f).
+ *  - getAngle():    Estimated angle in rad.
+ *  - getAngleRate(): Angle rate in rad/s with the estimated offset removed.
+ * Like the controller they are compiled for a parameter set (see
+ * ControllerParams.h).
+ */
+
+#ifndef ESTIMATOR_H_
+#define ESTIMATOR_H_
+
+/*
+ * stdint.h: Variable definitions for the C99 standard
+ * Config.h: All configurable parameters of the segway, as for example its pinout. Note: all constants are prefixed by CFG_.
+ * ControllerParams.h: Parameter sets the estimators can be compiled for.
+ */
+#include <stdint.h>
+#include "Config.h"
+#include "ControllerParams.h"
+
+
+template <class Params>
+class ComplementaryEstimator
+{
+public:
+    /*
+     * Complementary filter with the fixed factor Params::FILTER_FACT.
+     * Based on http://www.ups.bplaced.de/Dokumentation/Runner%207.38.pdf
+     */
+    void init();
+    void update(float angleRateRad, float angleChangeRad, float angleAccelRad,
+                float accelTrust, float dt);
+    float getAngle();
+    float getAngleRate();
+
+private:
+    float angleRad = 0.0f;
+    float angleRate = 0.0f;
+};
+
+
+template <class Params>
+class KalmanEstimator
+{
+public:
+    /*
+     * Kalman filter with the states angle and gyroscope offset. The noise
+     * of the sensors is configured in Config.h (CFG_CTLR_KALMAN_*). The
+     * gains converge to constant values, which KalmanEstimator::init
+     * computes in advance. Hence each update only costs a few multiply-adds.
+     */
+    void init();
+    void update(float angleRateRad, float angleChangeRad, float angleAccelRad,
+                float accelTrust, float dt);
+    float getAngle();
+    float getAngleRate();
+    float getBias();
+
+private:
+    float angleRad = 0.0f;
+    float angleRate = 0.0f;
+    float biasRad = 0.0f;
+
+    // Steady state gains applied to the difference between the angle of
+    // the accelerometer and the predicted angle.
+    float angleGain = 0.0f;
+    float biasGain = 0.0f;
+
+    // Iterations of the Riccati equation in KalmanEstimator::init. The gains
+    // have converged long before.
+    const static uint32_t GAIN_ITERATIONS = 20000;
+};
+
+
+#endif /* ESTIMATOR_H_ */
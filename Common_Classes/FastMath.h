@@ -0,0 +1,67 @@
+/*
+ * FastMath.h
+ *
+ * Approximations of math.h functions which are too slow for the control
+ * loop. On the TM4C123 the float functions of the runtime library are
+ * computed in software with several hundred cycles per call, while these
+ * approximations only need a few multiply-adds on the FPU.
+ * The functions are defined in the header so that the compiler can inline
+ * them.
+ */
+
+#ifndef FASTMATH_H_
+#define FASTMATH_H_
+
+/*
+ * math.h: Floating point math functions like fabsf()
+ */
+#include <math.h>
+
+
+inline float fastAtan2(float y, float x)
+{
+    /*
+     * Returns atan2(y, x) in rad like atan2f (range -pi to pi).
+     * The arctangent is computed for the ratio of the smaller to the bigger
+     * of both absolute values (0 to 1) with a 9th order polynomial
+     * (Abramowitz and Stegun, 4.4.47). The result is then mirrored to the
+     * right octant.
+     * Max. error: 1.2e-5 rad (0.0007deg) over the whole circle, measured
+     * with Host_Tools/AtanBench.cpp. Costs one division.
+     *
+     * y: Numerator (f.ex. horizontal acceleration)
+     * x: Denominator (f.ex. vertical acceleration)
+     */
+
+    float absX = fabsf(x);
+    float absY = fabsf(y);
+
+    // Undefined, atan2f returns 0 as well.
+    if (absX == 0.0f && absY == 0.0f)
+    {
+        return 0.0f;
+    }
+
+    bool steep = absY > absX;
+    float z = steep ? absX / absY : absY / absX;
+    float z2 = z * z;
+    float angle = z * (0.9998660f + z2 * (-0.3302995f + z2 * (0.1801410f
+                  + z2 * (-0.0851330f + z2 * 0.0208351f))));
+
+    if (steep)
+    {
+        angle = 1.57079633f - angle;
+    }
+    if (x < 0.0f)
+    {
+        angle = 3.14159265f - angle;
+    }
+    if (y < 0.0f)
+    {
+        angle = -angle;
+    }
+    return angle;
+}
+
+
+#endif /* FASTMATH_H_ */
@@ -0,0 +1,236 @@
+/*
+ * FlightRecorder.cpp
+ *
+ * Black box keeping the last updates of the segway (see FlightRecorder.h).
+ */
+
+#include "FlightRecorder.h"
+
+
+FlightRecorder::FlightRecorder()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void FlightRecorder::init(uint32_t clockFreq, uint32_t updateFreq)
+{
+    /*
+     * Clear the recording and start recording.
+     *
+     * clockFreq:  CPU clock [Hz], the unit of FlightRecord::cycles.
+     * updateFreq: Rate [Hz] at which records are added.
+     */
+
+    header.sync = FLIGHTRECORDER_SYNC;
+    header.version = FLIGHTRECORDER_VERSION;
+    header.recordSize = sizeof(FlightRecord);
+    header.clockFreq = clockFreq;
+    header.updateFreq = updateFreq;
+    head = 0;
+    dumping = false;
+    rearm();
+}
+
+void FlightRecorder::add(const FlightRecord &record)
+{
+    /*
+     * Record one update. Always written to the slot at head; head only
+     * advances while the recorder runs or until the records after a freeze
+     * are complete. Hence a frozen recording is never overwritten, without
+     * a branch here.
+     */
+
+    records[head & (SIZE - 1)] = record;
+    uint32_t advance = (remaining != 0);
+    head += advance;
+    remaining -= advance & frozen;
+}
+
+void FlightRecorder::freeze(uint16_t reason, uint32_t errorCode,
+                            uint32_t cycles, uint32_t afterTrigger)
+{
+    /*
+     * Stop recording to keep the updates before the event. Only the first
+     * freeze counts until FlightRecorder::rearm.
+     *
+     * reason:       FLIGHTRECORDER_FALL, _ERROR or _REQUEST.
+     * errorCode:    ErrorCodes of System::error, else 0.
+     * cycles:       System::getCycles at the event.
+     * afterTrigger: Number of records still added after the event, f.ex.
+     *               to see how the segway fell.
+     */
+
+    if (frozen)
+    {
+        return;
+    }
+
+    header.reason = reason;
+    header.errorCode = errorCode;
+    header.triggerCycles = cycles;
+    afterTriggerRequested = afterTrigger;
+    remaining = afterTrigger;
+    frozen = 1;
+}
+
+void FlightRecorder::rearm()
+{
+    /*
+     * Continue recording after a freeze. The frozen records are overwritten
+     * by the next ones.
+     */
+
+    header.reason = FLIGHTRECORDER_RUNNING;
+    header.errorCode = 0;
+    header.triggerCycles = 0;
+    afterTriggerRequested = 0;
+    frozen = 0;
+    remaining = 1;
+}
+
+bool FlightRecorder::isFrozen()
+{
+    /*
+     * Returns true if FlightRecorder::freeze has been called.
+     */
+
+    return frozen;
+}
+
+void FlightRecorder::startDump(uint32_t cycles)
+{
+    /*
+     * Start sending the recording (see FlightRecorder::sendDump). If the
+     * recorder is still running it's frozen now (FLIGHTRECORDER_REQUEST).
+     * If it's still adding the records after a freeze, it stops now: the
+     * records being sent must not be overwritten. The rider might have
+     * stepped off anyway, then no more updates are recorded.
+     *
+     * cycles: System::getCycles.
+     */
+
+    freeze(FLIGHTRECORDER_REQUEST, 0, cycles);
+    header.afterTrigger = afterTriggerRequested - remaining;
+    remaining = 0;
+
+    uint32_t count = (head < SIZE - 1) ? head : SIZE - 1;
+    header.count = count;
+    dumpFirst = head - count;
+    dumpOffset = 0;
+    dumpCRC = 0xffff;
+    dumping = true;
+}
+
+bool FlightRecorder::isDumping()
+{
+    /*
+     * Returns true while a dump hasn't been sent completely.
+     */
+
+    return dumping;
+}
+
+bool FlightRecorder::sendDump(UARTBuffer *buffer, uint32_t uartBase)
+{
+    /*
+     * Continue the dump started by FlightRecorder::startDump. With a UART
+     * buffer only as many bytes as it has space for are queued, hence this
+     * has to be called periodically until it returns true. Without one
+     * (buffer = 0) the whole dump is sent at once, which takes about 0.5s
+     * at 115200 baud.
+     *
+     * buffer:   Enabled UART buffer or 0.
+     * uartBase: UART to send with if there's no buffer, f.ex. UART0_BASE.
+     */
+
+    while (dumping)
+    {
+        const uint8_t *data;
+        uint32_t length = getDumpChunk(dumpOffset, &data);
+        if (!length)
+        {
+            dumping = false;
+            break;
+        }
+
+        if (buffer)
+        {
+            uint32_t free = buffer->getFree();
+            if (!free)
+            {
+                return false;
+            }
+            if (length > free)
+            {
+                length = free;
+            }
+            buffer->write(data, length);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < length; i++)
+            {
+                UARTCharPut(uartBase, data[i]);
+            }
+        }
+        dumpCRC = debugFrameCRC(dumpCRC, data, length);
+        dumpOffset += length;
+    }
+    return true;
+}
+
+uint32_t FlightRecorder::getDumpChunk(uint32_t offset, const uint8_t **data)
+{
+    /*
+     * Returns the number of bytes of the dump which are stored contiguously
+     * from the given offset on and points data to them. 0 at the end.
+     */
+
+    const uint32_t recordSize = sizeof(FlightRecord);
+
+    if (offset < sizeof(header))
+    {
+        *data = (const uint8_t *) &header + offset;
+        return sizeof(header) - offset;
+    }
+    offset -= sizeof(header);
+
+    // Up to the end of the recording or of the ring buffer.
+    uint32_t recordBytes = header.count * recordSize;
+    if (offset < recordBytes)
+    {
+        uint32_t index = offset / recordSize;
+        uint32_t slot = (dumpFirst + index) & (SIZE - 1);
+        uint32_t length = (SIZE - slot) * recordSize;
+        if (length > recordBytes - index * recordSize)
+        {
+            length = recordBytes - index * recordSize;
+        }
+        uint32_t skip = offset % recordSize;
+        *data = (const uint8_t *) &records[slot] + skip;
+        return length - skip;
+    }
+    offset -= recordBytes;
+
+    // The CRC covers everything before it.
+    if (offset < 2)
+    {
+        if (offset == 0)
+        {
+            dumpCRCBytes[0] = dumpCRC & 0xff;
+            dumpCRCBytes[1] = dumpCRC >> 8;
+        }
+        *data = &dumpCRCBytes[offset];
+        return 2 - offset;
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * FlightRecorder.h
+ *
+ * Black box of the segway: keeps the last FlightRecorder::SIZE updates
+ * (sensor values, estimated angle, torque, duty cycles, battery voltage and
+ * timing) in a ring buffer in RAM. When the segway falls or System::error
+ * halts it, the recorder is frozen so the updates leading to it are kept.
+ * The recording is sent via UART on request (see System::handleRequests)
+ * and converted to a timeline by Host_Tools/RecorderDecode.cpp.
+ * Writing a record (FlightRecorder::add) is a copy into the buffer without
+ * any branch; freezing only stops advancing the write position.
+ *
+ * Dump format (little endian):
+ *  - FlightRecorderHeader
+ *  - FlightRecorderHeader::count FlightRecords, the oldest first
+ *  - CRC-16/CCITT (see debugFrameCRC) of the header and the records
+ */
+
+#ifndef FLIGHTRECORDER_H_
+#define FLIGHTRECORDER_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * driverlib/uart.h:        UART API of DriverLib (blocking dump).
+ * DebugFrame.h:            CRC of the dump.
+ * UARTBuffer.h:            Dump in background via the UART buffer.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/uart.h"
+#include "DebugFrame.h"
+#include "UARTBuffer.h"
+
+
+// Sync word ("FRCB" as bytes on the UART).
+const uint32_t FLIGHTRECORDER_SYNC = 0x42435246;
+
+// Incremented with each change of FlightRecorderHeader or FlightRecord.
+const uint16_t FLIGHTRECORDER_VERSION = 1;
+
+// Reasons of the freeze (FlightRecorderHeader::reason)
+const uint16_t FLIGHTRECORDER_RUNNING = 0;  // not frozen
+const uint16_t FLIGHTRECORDER_FALL    = 1;  // the segway tilted too far
+const uint16_t FLIGHTRECORDER_ERROR   = 2;  // System::error
+const uint16_t FLIGHTRECORDER_REQUEST = 3;  // dump requested while running
+
+
+struct FlightRecorderHeader
+{
+    uint32_t sync;              // FLIGHTRECORDER_SYNC
+    uint16_t version;           // FLIGHTRECORDER_VERSION
+    uint16_t recordSize;        // sizeof(FlightRecord)
+    uint32_t clockFreq;         // [Hz] unit of the cycles
+    uint16_t updateFreq;        // [Hz] CFG_CTLR_UPDATE_FREQ
+    uint16_t count;             // records following the header
+    uint16_t reason;            // FLIGHTRECORDER_*
+    uint16_t afterTrigger;      // last records recorded after the freeze
+    uint32_t errorCode;         // ErrorCodes if reason is _ERROR
+    uint32_t triggerCycles;     // System::getCycles at the freeze
+};
+
+
+struct FlightRecord
+{
+    uint32_t cycles;            // System::getCycles at the update's start
+    int16_t angleRate;          // raw sensor values (MPU6050::getRawAngleRate
+    int16_t accelHor;           // and the like)
+    int16_t accelVer;
+    int16_t angle;              // estimated angle [0.01 deg]
+    int16_t torque;             // [1/10000 duty cycle] (Controller::getTorque)
+    int16_t leftDuty;           // [1/10000]
+    int16_t rightDuty;          // [1/10000]
+    int16_t steering;           // [1/10000]
+    uint16_t battery;           // voltage at the ADC pin [mV]
+    uint16_t lastUpdateUS;      // duration of the previous update [us]
+};
+
+
+class FlightRecorder
+{
+public:
+    FlightRecorder();
+    virtual ~FlightRecorder();
+    void init(uint32_t clockFreq, uint32_t updateFreq);
+    void add(const FlightRecord &record);
+    void freeze(uint16_t reason, uint32_t errorCode, uint32_t cycles,
+                uint32_t afterTrigger = 0);
+    void rearm();
+    bool isFrozen();
+    void startDump(uint32_t cycles);
+    bool isDumping();
+    bool sendDump(UARTBuffer *buffer, uint32_t uartBase);
+
+    // Must be a power of 2 (the indices are masked).
+    const static uint32_t SIZE = 256;
+
+private:
+    uint32_t getDumpChunk(uint32_t offset, const uint8_t **data);
+
+    FlightRecorderHeader header;
+    FlightRecord records[SIZE];
+
+    // Records are written to records[head % SIZE]. The slot at head is
+    // never part of the recording, hence at most SIZE - 1 are kept.
+    uint32_t head = 0;
+    uint32_t remaining = 1;     // records until the freeze takes effect
+    uint32_t frozen = 0;        // 1 after FlightRecorder::freeze
+    uint32_t afterTriggerRequested = 0;
+
+    // State of the dump (see FlightRecorder::startDump)
+    bool dumping = false;
+    uint32_t dumpOffset = 0;
+    uint32_t dumpFirst = 0;     // index of the oldest record
+    uint16_t dumpCRC = 0;
+    uint8_t dumpCRCBytes[2];
+};
+
+
+#endif /* FLIGHTRECORDER_H_ */
@@ -250,6 +250,35 @@ void GPIO::setPulldown(bool enabled)
     refreshConfig();
 }
 
+void GPIO::enableInterrupt(uint32_t intType, void (*ISR)(void))
+{
+    /*
+     * Call the given ISR on a change of this (input) pin.
+     * Note: There's only one ISR per port. Registering an ISR for another pin
+     *       of the same port replaces the previous one.
+     *
+     * intType: Event causing the interrupt. Use the constants provided by the
+     *          TivaWare API (driverlib/gpio.h, f.ex. GPIO_RISING_EDGE).
+     * ISR:     Function to be called. It must call
+     *          GPIO::clearInterruptFlag.
+     */
+
+    GPIOIntTypeSet(portBase, pin, intType);
+    GPIOIntRegister(portBase, ISR);
+    clearInterruptFlag();
+    GPIOIntEnable(portBase, pin);
+}
+
+void GPIO::clearInterruptFlag()
+{
+    /*
+     * Clear the interrupt flag of this pin so that the ISR isn't called
+     * again immediately.
+     */
+
+    GPIOIntClear(portBase, pin);
+}
+
 void GPIO::refreshConfig()
 {
     /*
@@ -46,6 +46,8 @@ public:
     void setCurrent(uint32_t current);
     void setPullup(bool enabled);
     void setPulldown(bool enabled);
+    void enableInterrupt(uint32_t intType, void (*ISR)(void));
+    void clearInterruptFlag();
 
 private:
     System *sys;
@@ -8,6 +8,10 @@
 #include "MPU6050.h"
 
 
+MPU6050 *MPU6050::asyncInstance = 0;
+constexpr float MPU6050::ANGLE_RATE_PER_LSB;
+constexpr float MPU6050::ACCEL_PER_LSB;
+
 MPU6050::MPU6050()
 {
     /*
@@ -41,6 +45,8 @@ void MPU6050::init(System *sys, uint32_t I2CBase, bool addressBit,
 
     // Create private reference to the given System object.
     this->sys = sys;
+    readAllProbe = sys->addProbe("MPU6050::readAll");
+    readFIFOProbe = sys->addProbe("MPU6050::readFIFO");
 
     // Save I2C Module base address
     this->i2cBase = I2CBase;
@@ -76,6 +82,12 @@ void MPU6050::init(System *sys, uint32_t I2CBase, bool addressBit,
     // (set fast-mode (400kb/s) to true).
     I2CMasterInitExpClk(i2cBase, sys->getClockFreq(), true);
 
+    // Register the ISR for asynchronous transfers. The master interrupt
+    // itself is only enabled while such a transfer is running (see
+    // MPU6050::startReadAll).
+    asyncInstance = this;
+    I2CMasterIntRegister(i2cBase, i2cISR);
+
     /*
      * Check whether communicating with the MPU6050 works.
      *
@@ -100,10 +112,13 @@ void MPU6050::init(System *sys, uint32_t I2CBase, bool addressBit,
 
     // Configure the MPU6050 to disable external Frame Synchronization, to let
     // the accelerometer run unfiltered at 1kHz and the gyroscope at 8kHz.
-    setRegister(MPU_REG_CONFIG, 0x00);
+    // See MPU6050::setLowPass to enable filtering.
+    dlpfConfig = 0;
+    setRegister(MPU_REG_CONFIG, dlpfConfig);
 
     // Set the gyroscope sample rate divider to 1.
     setRegister(MPU_REG_SMPLRT_DIV, 0x00);
+    sampleRate = 8000;
 
     // Configure the gyro to the appropriate full scale range and do not
     // perform a self-test.
@@ -306,14 +321,490 @@ void MPU6050::accelVerInvertSign(bool invertSign)
     }
 }
 
+void MPU6050::setLowPass(uint32_t bandwidth)
+{
+    /*
+     * Configure the digital low pass filter of the sensor. The filter with
+     * the highest bandwidth which does not exceed the given one is used.
+     * Filtering in the sensor costs no CPU time but delays the measurements
+     * (see MPU6050::getAngleRateDelayUS and MPU6050::getAccelDelayUS).
+     * Note: Enabling the filter lowers the gyroscope output rate to 1kHz.
+     *       The sample rate is adjusted to stay as close as possible to the
+     *       previous one.
+     *
+     * bandwidth: Desired (gyroscope) bandwidth in Hz. Values of 256Hz and
+     *            above disable the filter, values below 5Hz result in the
+     *            lowest possible bandwidth of 5Hz.
+     */
+
+    // Start with the lowest bandwidth and use the next higher one as long as
+    // it does not exceed the desired bandwidth.
+    uint8_t config = DLPF_COUNT - 1;
+    while (config > 0 && DLPF_GYRO_BANDWIDTH[config - 1] <= bandwidth)
+    {
+        config--;
+    }
+
+    dlpfConfig = config;
+    setRegister(MPU_REG_CONFIG, dlpfConfig);
+
+    // The sample rate divider is based on the gyroscope output rate which
+    // might have changed.
+    if (sampleRate)
+    {
+        setSampleRate(sampleRate);
+    }
+}
+
+uint32_t MPU6050::getLowPassBandwidth()
+{
+    /*
+     * Returns the bandwidth of the low pass filter of the gyroscope in Hz.
+     */
+
+    return DLPF_GYRO_BANDWIDTH[dlpfConfig];
+}
+
+uint32_t MPU6050::getAngleRateDelayUS()
+{
+    /*
+     * Returns the delay of the angle rate caused by the low pass filter in
+     * microseconds.
+     */
+
+    return DLPF_GYRO_DELAY[dlpfConfig];
+}
+
+uint32_t MPU6050::getAccelDelayUS()
+{
+    /*
+     * Returns the delay of the accelerations caused by the low pass filter
+     * in microseconds.
+     */
+
+    return DLPF_ACCEL_DELAY[dlpfConfig];
+}
+
+void MPU6050::setSampleRate(uint32_t freq)
+{
+    /*
+     * Set the rate at which the sensor registers (and the FIFO) are updated.
+     * It is derived from the gyroscope output rate, which is 8kHz with
+     * disabled digital low pass filter and 1kHz otherwise (see MPU-6050
+     * Register Map page 12). Therefore not every frequency is possible. The
+     * next higher possible one is used.
+     * Note: Rates below 32Hz can't be derived from 8kHz. In this case the
+     *       digital low pass filter is enabled with its highest bandwidth
+     *       (188Hz) to lower the gyroscope output rate to 1kHz.
+     *
+     * freq: Desired sample rate in Hz.
+     */
+
+    uint32_t gyroRate = 1000;
+    if (dlpfConfig == 0 || dlpfConfig == 7)
+    {
+        gyroRate = 8000;
+        if (freq && gyroRate / freq > 256)
+        {
+            dlpfConfig = 1;
+            setRegister(MPU_REG_CONFIG, dlpfConfig);
+            gyroRate = 1000;
+        }
+    }
+
+    // The register stores the divider - 1 as an 8 bit value.
+    uint32_t div = 0;
+    if (freq)
+    {
+        div = gyroRate / freq;
+    }
+    if (freq == 0 || div > 256)
+    {
+        sys->error(MPUWrongSampleRate, &freq);
+    }
+
+    // Sampling faster than the gyroscope output rate is not possible.
+    if (div < 1)
+    {
+        div = 1;
+    }
+
+    setRegister(MPU_REG_SMPLRT_DIV, div - 1);
+    sampleRate = gyroRate / div;
+}
+
+uint32_t MPU6050::getSampleRate()
+{
+    /*
+     * Returns the rate in Hz at which the sensor registers are updated.
+     */
+
+    return sampleRate;
+}
+
+void MPU6050::enableFIFO(uint32_t samplesPerRead, uint32_t readFreq)
+{
+    /*
+     * Let the sensor store all gyroscope and accelerometer samples in its
+     * FIFO, so that MPU6050::readFIFO can read all the samples since the last
+     * call at once instead of a single sample. The sample rate is set
+     * accordingly.
+     *
+     * samplesPerRead: Number of samples the FIFO shall contain each time
+     *                 MPU6050::readFIFO is called.
+     * readFreq:       Frequency at which MPU6050::readFIFO is called.
+     */
+
+    // The FIFO must not overflow, even if one read is a bit late.
+    uint32_t freq = samplesPerRead * readFreq;
+    if (2 * samplesPerRead * FIFO_ENTRY_BYTES > FIFO_SIZE)
+    {
+        sys->error(MPUWrongSampleRate, &freq);
+    }
+    setSampleRate(freq);
+    fifoEnabled = true;
+
+    // Store all values in the FIFO and start with an empty FIFO.
+    setRegister(MPU_REG_FIFO_EN, MPU_FIFO_EN_ALL);
+    setRegister(MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_EN
+                                   | MPU_USER_CTRL_FIFO_RESET);
+}
+
+void MPU6050::enableDataReadyInterrupt(uint32_t freq)
+{
+    /*
+     * Let the sensor generate a pulse on its INT pin each time a new sample
+     * is available. This allows to read each sample as soon as it's ready
+     * instead of reading it at a random time after it's been measured. The
+     * interrupt is cleared by any read.
+     * If the FIFO is enabled (see MPU6050::enableFIFO), its sample rate is
+     * kept and the interrupt comes with each sample stored in the FIFO.
+     *
+     * freq: Rate at which new samples shall be generated (ignored if the
+     *       FIFO is enabled).
+     */
+
+    if (!fifoEnabled)
+    {
+        setSampleRate(freq);
+    }
+    setRegister(MPU_REG_INT_PIN_CFG, MPU_INT_PIN_CFG_RD_CLEAR);
+    setRegister(MPU_REG_INT_ENABLE, MPU_INT_ENABLE_DATA_RDY);
+}
+
+void MPU6050::readAll()
+{
+    /*
+     * Read all sensor values (accelerometer, temperature and gyroscope) in
+     * one single burst transfer and store them. The getters below return the
+     * values of this sample, hence this method must be called once per
+     * control cycle before using any of them.
+     * Note: The MPU6050 automatically increments the register address after
+     *       each byte, therefore a single transfer starting at ACCEL_XOUT_H
+     *       is sufficient to read all of them (MPU-6050 datasheet page 36).
+     *       Compared to reading each register separately this saves the
+     *       overhead of 5 additional transactions.
+     */
+
+    ProbeScope probe(sys, readAllProbe);
+
+    if (transferState == TRANSFER_IDLE)
+    {
+        getRegisters(MPU_REG_ACCEL_XOUT_H, sample, SAMPLE_BYTES);
+        updateOffsets();
+        return;
+    }
+
+    /*
+     * An asynchronous transfer has been started by MPU6050::startReadAll.
+     * Use its result instead of starting a new transfer. If it's not
+     * finished yet, the rest of it is done by polling. This works
+     * independently of the interrupt priorities (f.ex. if this method is
+     * called from an ISR which can't be interrupted by the I2C ISR).
+     */
+    I2CMasterIntDisable(i2cBase);
+    while (transferState != TRANSFER_DONE)
+    {
+        waitWithTimeoutUS(1000);
+        I2CMasterIntClear(i2cBase);
+        advanceTransfer();
+    }
+    memcpy(sample, transferBuffer, SAMPLE_BYTES);
+    transferState = TRANSFER_IDLE;
+    updateOffsets();
+}
+
+void MPU6050::startReadAll(void (*callback)(void))
+{
+    /*
+     * Start reading all sensor values like MPU6050::readAll does, but return
+     * immediately. The transfer is driven by the I2C master interrupt, so the
+     * CPU is not blocked while the bus is busy. The next call of
+     * MPU6050::readAll uses the result of this transfer (and waits for it if
+     * necessary).
+     * Example: Start the transfer at the end of one control cycle and use it
+     *          at the beginning of the next one. Note that the sample is then
+     *          as old as the time between these two calls.
+     *
+     * callback: Optional function which is called by the I2C ISR as soon as
+     *           the transfer is finished. Default is no callback.
+     */
+
+    // Only one transfer can run at the same time. A finished transfer which
+    // has not been used yet is simply replaced by the new one.
+    if (transferState != TRANSFER_IDLE && transferState != TRANSFER_DONE)
+    {
+        return;
+    }
+
+    transferCallback = callback;
+    transferState = TRANSFER_ADDRESS;
+
+    I2CMasterIntClear(i2cBase);
+    I2CMasterIntEnable(i2cBase);
+
+    // Send the address of the first register. Everything else is done in
+    // MPU6050::advanceTransfer each time the master is done.
+    I2CMasterSlaveAddrSet(i2cBase, address, false);
+    I2CMasterDataPut(i2cBase, MPU_REG_ACCEL_XOUT_H);
+    I2CMasterControl(i2cBase, I2C_MASTER_CMD_SINGLE_SEND);
+}
+
+bool MPU6050::isSampleReady()
+{
+    /*
+     * Returns whether the transfer started by MPU6050::startReadAll is
+     * finished, meaning that MPU6050::readAll won't have to wait.
+     */
+
+    return (transferState == TRANSFER_DONE);
+}
+
+uint32_t MPU6050::readFIFO()
+{
+    /*
+     * Read all samples stored in the FIFO since the last call (see
+     * MPU6050::enableFIFO) and store their average. Like with
+     * MPU6050::readAll, the getters then return the values of this sample.
+     * Averaging all samples since the last call filters out vibrations
+     * which otherwise would be aliased by sampling only once per control
+     * cycle.
+     * Returns the number of samples that have been averaged. 0 means that
+     * the FIFO could not be used and a single sample has been read instead.
+     */
+
+    ProbeScope probe(sys, readFIFOProbe);
+
+    // An overflow (f.ex. because the FIFO hasn't been read during standby)
+    // means the oldest samples are lost and the FIFO isn't aligned to its
+    // entries anymore. Start from scratch.
+    if (getRegister(MPU_REG_INT_STATUS) & MPU_INT_STATUS_FIFO_OFLOW)
+    {
+        setRegister(MPU_REG_USER_CTRL, MPU_USER_CTRL_FIFO_EN
+                                       | MPU_USER_CTRL_FIFO_RESET);
+        readAll();
+        return 0;
+    }
+
+    uint8_t countBytes[2];
+    getRegisters(MPU_REG_FIFO_COUNTH, countBytes, 2);
+    uint32_t entries = ((countBytes[0] << 8) | countBytes[1])
+                       / FIFO_ENTRY_BYTES;
+
+    if (entries == 0)
+    {
+        readAll();
+        return 0;
+    }
+
+    // Sum of all values (in the order of the registers)
+    int32_t sums[SAMPLE_BYTES / 2] = {0};
+
+    // Read the FIFO in bursts as large as the buffer permits. Usually the
+    // FIFO contains no more than one burst.
+    uint32_t remaining = entries;
+    while (remaining)
+    {
+        uint32_t burstEntries = remaining;
+        if (burstEntries > FIFO_BURST_ENTRIES)
+        {
+            burstEntries = FIFO_BURST_ENTRIES;
+        }
+
+        // The register address is not incremented when reading FIFO_R_W.
+        getRegisters(MPU_REG_FIFO_R_W, fifoBuffer,
+                     burstEntries * FIFO_ENTRY_BYTES);
+
+        for (uint32_t i = 0; i < burstEntries * FIFO_ENTRY_BYTES; i += 2)
+        {
+            int16_t value = (fifoBuffer[i] << 8) | fifoBuffer[i + 1];
+            sums[(i % FIFO_ENTRY_BYTES) / 2] += value;
+        }
+        remaining -= burstEntries;
+    }
+
+    // Store the averages like MPU6050::readAll stores a single sample.
+    for (uint8_t i = 0; i < SAMPLE_BYTES / 2; i++)
+    {
+        int16_t average = sums[i] / (int32_t) entries;
+        sample[2 * i]     = average >> 8;
+        sample[2 * i + 1] = average & 0xff;
+    }
+    updateOffsets();
+
+    return entries;
+}
+
+void MPU6050::calibrateGyro(uint32_t samples)
+{
+    /*
+     * Measure the offset of all gyroscope axes by averaging the given number
+     * of samples. The offset is removed from all following angle rates.
+     * Note: The sensor must not move during the calibration!
+     *
+     * samples: Number of samples to average. The calibration takes as many
+     *          sample periods (see MPU6050::setSampleRate).
+     */
+
+    if (samples == 0)
+    {
+        return;
+    }
+
+    float sums[3] = {0.0f, 0.0f, 0.0f};
+    float temperatureSum = 0.0f;
+    for (uint32_t i = 0; i < samples; i++)
+    {
+        // Wait for the next sample.
+        sys->delayUS(1000000 / sampleRate);
+        readAll();
+
+        for (uint8_t axis = 0; axis < 3; axis++)
+        {
+            sums[axis] += getSampleValue(MPU_REG_GYRO_XOUT_H + 2 * axis);
+        }
+        temperatureSum += getTemperature();
+    }
+
+    // The offsets are valid at the temperature during the calibration.
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        gyroBias[axis] = sums[axis] / samples;
+    }
+    calTemperature = temperatureSum / samples;
+    updateOffsets();
+}
+
+void MPU6050::trackGyroBias(float factor, float standstillRate)
+{
+    /*
+     * Follow slow changes of the gyroscope offsets (f.ex. when the sensor
+     * warms up) using the last sample. Call this method after reading a
+     * sample while the sensor is not moving. Samples where any axis measures
+     * more than the given angle rate are considered as movement and ignored.
+     *
+     * factor:         Weight of the current sample (0.0f - 1.0f). The lower,
+     *                 the slower and smoother the tracking.
+     * standstillRate: Maximum angle rate in /s which is still considered
+     *                 as standstill.
+     */
+
+    float threshold = standstillRate * (1 << 15) / GYRO_RANGE;
+    float deviations[3];
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        deviations[axis] = getSampleValue(MPU_REG_GYRO_XOUT_H + 2 * axis)
+                           - gyroOffsets[axis];
+        if (fabsf(deviations[axis]) > threshold)
+        {
+            return;
+        }
+    }
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        gyroBias[axis] += factor * deviations[axis];
+    }
+    updateOffsets();
+}
+
+float MPU6050::getAngleRateBias()
+{
+    /*
+     * Return the offset in /s which is removed from the angle rate.
+     */
+
+    uint8_t axis = (angleRateRegister - MPU_REG_GYRO_XOUT_H) / 2;
+    return (angleRateSign * gyroOffsets[axis] * GYRO_RANGE) / (1 << 15);
+}
+
+void MPU6050::setTempCompensation(const float gyroCoeffs[3],
+                                  const float accelCoeffs[3])
+{
+    /*
+     * Compensate the temperature dependency of the sensor offsets with a
+     * linear model. The coefficients can be determined by logging the
+     * temperature and the sensor values at rest while the sensor warms up.
+     * The gyroscope offsets are relative to the temperature during
+     * MPU6050::calibrateGyro, the accelerometer offsets relative to 25C if
+     * no calibration has been done.
+     * Default is no compensation (all coefficients 0).
+     *
+     * gyroCoeffs:  Change of the gyroscope offsets of the axes x, y and z in
+     *              /s per C.
+     * accelCoeffs: Change of the accelerometer offsets of the axes x, y and
+     *              z in g per C.
+     */
+
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        gyroTempCoeffs[axis]  = gyroCoeffs[axis] * (1 << 15) / GYRO_RANGE;
+        accelTempCoeffs[axis] = accelCoeffs[axis] * (1 << 15) / ACCEL_RANGE;
+    }
+    updateOffsets();
+}
+
+float MPU6050::getTemperature()
+{
+    /*
+     * Return the temperature of the sensor in C (see MPU-6050 Register Map
+     * page 30).
+     * Note: uses the sample stored by the last call of MPU6050::readAll.
+     */
+
+    return getSampleValue(MPU_REG_TEMP_OUT_H) / 340.0f + 36.53f;
+}
+
+void MPU6050::updateOffsets()
+{
+    /*
+     * Calculate the offsets of all axes at the temperature of the current
+     * sample. Called once per sample so that the getters only need to
+     * subtract them.
+     */
+
+    float temperatureDiff = getTemperature() - calTemperature;
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        gyroOffsets[axis] = gyroBias[axis]
+                            + gyroTempCoeffs[axis] * temperatureDiff;
+        accelOffsets[axis] = accelTempCoeffs[axis] * temperatureDiff;
+        gyroOffsetsRaw[axis] = lroundf(gyroOffsets[axis]);
+        accelOffsetsRaw[axis] = lroundf(accelOffsets[axis]);
+    }
+}
+
 float MPU6050::getAngleRate()
 {
     /*
-     * Return the angle rate in /s from the corresponding gyro.
+     * Return the angle rate in /s from the corresponding gyro without its
+     * offset (see MPU6050::calibrateGyro and
+     * MPU6050::setTempCompensation).
+     * Note: uses the sample stored by the last call of MPU6050::readAll.
      */
 
-    int16_t rawAngleRate = (getRegister(angleRateRegister) << 8)
-                           | getRegister(angleRateRegister + 1);
+    uint8_t axis = (angleRateRegister - MPU_REG_GYRO_XOUT_H) / 2;
+    float rawAngleRate = getSampleValue(angleRateRegister) - gyroOffsets[axis];
     return (angleRateSign * rawAngleRate * GYRO_RANGE) / (1 << 15);
 }
 
@@ -321,11 +812,12 @@ float MPU6050::getAccelHor()
 {
     /*
      * Return the horizontal acceleration in g from the corresponding
-     * accelerometer.
+     * accelerometer without its temperature dependent offset.
+     * Note: uses the sample stored by the last call of MPU6050::readAll.
      */
 
-    int16_t rawAccelHor = (getRegister(accelHorRegister) << 8)
-                          | getRegister(accelHorRegister + 1);
+    uint8_t axis = (accelHorRegister - MPU_REG_ACCEL_XOUT_H) / 2;
+    float rawAccelHor = getSampleValue(accelHorRegister) - accelOffsets[axis];
     return (accelHorSign * rawAccelHor * ACCEL_RANGE) / (1 << 15);
 }
 
@@ -333,14 +825,71 @@ float MPU6050::getAccelVer()
 {
     /*
      * Return the vertical acceleration in g from the corresponding
-     * accelerometer.
+     * accelerometer without its temperature dependent offset.
+     * Note: uses the sample stored by the last call of MPU6050::readAll.
      */
 
-    int16_t rawAccelVer = (getRegister(accelVerRegister) << 8)
-                          | getRegister(accelHorRegister + 1);
+    uint8_t axis = (accelVerRegister - MPU_REG_ACCEL_XOUT_H) / 2;
+    float rawAccelVer = getSampleValue(accelVerRegister) - accelOffsets[axis];
     return (accelVerSign * rawAccelVer * ACCEL_RANGE) / (1 << 15);
 }
 
+int32_t MPU6050::getRawAngleRate()
+{
+    /*
+     * Return the angle rate like MPU6050::getAngleRate but without
+     * converting it from sensor units. Multiply by ANGLE_RATE_PER_LSB to get
+     * rad/s. This allows to fold this factor into other constants.
+     */
+
+    uint8_t axis = (angleRateRegister - MPU_REG_GYRO_XOUT_H) / 2;
+    int32_t rawAngleRate = getSampleValue(angleRateRegister)
+                           - gyroOffsetsRaw[axis];
+    return (angleRateSign < 0.0f) ? -rawAngleRate : rawAngleRate;
+}
+
+int32_t MPU6050::getRawAccelHor()
+{
+    /*
+     * Return the horizontal acceleration like MPU6050::getAccelHor but
+     * without converting it from sensor units. Multiply by ACCEL_PER_LSB to
+     * get g.
+     */
+
+    uint8_t axis = (accelHorRegister - MPU_REG_ACCEL_XOUT_H) / 2;
+    int32_t rawAccelHor = getSampleValue(accelHorRegister)
+                          - accelOffsetsRaw[axis];
+    return (accelHorSign < 0.0f) ? -rawAccelHor : rawAccelHor;
+}
+
+int32_t MPU6050::getRawAccelVer()
+{
+    /*
+     * Return the vertical acceleration like MPU6050::getAccelVer but
+     * without converting it from sensor units. Multiply by ACCEL_PER_LSB to
+     * get g.
+     */
+
+    uint8_t axis = (accelVerRegister - MPU_REG_ACCEL_XOUT_H) / 2;
+    int32_t rawAccelVer = getSampleValue(accelVerRegister)
+                          - accelOffsetsRaw[axis];
+    return (accelVerSign < 0.0f) ? -rawAccelVer : rawAccelVer;
+}
+
+int16_t MPU6050::getSampleValue(uint8_t reg)
+{
+    /*
+     * Return the 16 bit value of the given register pair from the last
+     * sample.
+     *
+     * reg: Address of the MSB register (xxx_H) of the value. The LSB is
+     *      stored right after it.
+     */
+
+    uint8_t i = reg - MPU_REG_ACCEL_XOUT_H;
+    return (sample[i] << 8) | sample[i + 1];
+}
+
 void MPU6050::setRegister(uint8_t reg, uint8_t val)
 {
     /*
@@ -361,7 +910,7 @@ void MPU6050::setRegister(uint8_t reg, uint8_t val)
     I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_SEND_START);
 
     // Wait until MCU is done transferring.
-    while (I2CMasterBusy(i2cBase));
+    waitWithTimeoutUS(1000);
 
     // Put value to be written in the data register
     I2CMasterDataPut(i2cBase, val);
@@ -370,7 +919,7 @@ void MPU6050::setRegister(uint8_t reg, uint8_t val)
     I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_SEND_FINISH);
 
     // Wait until MCU is done transferring.
-    while (I2CMasterBusy(i2cBase));
+    waitWithTimeoutUS(1000);
 }
 
 uint32_t MPU6050::getRegister(uint8_t reg)
@@ -409,6 +958,63 @@ uint32_t MPU6050::getRegister(uint8_t reg)
     return I2CMasterDataGet(i2cBase);
 }
 
+void MPU6050::getRegisters(uint8_t reg, uint8_t *data, uint32_t count)
+{
+    /*
+     * Read count consecutive registers from the MPU in one burst transfer.
+     *
+     * reg:   Address of the first register to be read
+     * data:  Array in which the values of the registers are stored. Must have
+     *        space for at least count values.
+     * count: Number of registers to be read.
+     */
+
+    // A burst with a single byte is not possible. Use the simple method.
+    if (count == 1)
+    {
+        data[0] = getRegister(reg);
+        return;
+    }
+
+    // specify that we are writing (a register address) to the slave device
+    I2CMasterSlaveAddrSet(i2cBase, address, false);
+
+    // specify first register to be read
+    I2CMasterDataPut(i2cBase, reg);
+
+    // send control byte and register address byte to slave device
+    I2CMasterControl(i2cBase, I2C_MASTER_CMD_SINGLE_SEND);
+
+    // wait for MCU to finish transaction with a timeout of 1000us
+    waitWithTimeoutUS(1000);
+
+    // specify that we are going to read from slave device
+    I2CMasterSlaveAddrSet(i2cBase, address, true);
+
+    // The first byte is read with a start condition, all the following ones
+    // are acknowledged by the master and the last one ends with a stop.
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i == 0)
+        {
+            I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_START);
+        }
+        else if (i == count - 1)
+        {
+            I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
+        }
+        else
+        {
+            I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_CONT);
+        }
+
+        // wait for MCU to finish transaction with a timeout of 1000us
+        waitWithTimeoutUS(1000);
+
+        data[i] = I2CMasterDataGet(i2cBase);
+    }
+}
+
 void MPU6050::waitWithTimeoutUS(uint32_t timeoutUS)
 {
     /*
@@ -417,15 +1023,75 @@ void MPU6050::waitWithTimeoutUS(uint32_t timeoutUS)
      *
      * timeoutUS: Optional timeout in us. Default is 1000us.
      */
-    uint32_t timeUS = 0;
-    const uint32_t timeStepUS = 10;
+    uint32_t deadline = sys->getDeadlineUS(timeoutUS);
     while (I2CMasterBusy(i2cBase))
     {
-        if (timeUS >= timeoutUS)
+        if (sys->deadlinePassed(deadline))
+        {
+            sys->error(MPUCommunicationError);
+        }
+    }
+}
+
+void MPU6050::advanceTransfer()
+{
+    /*
+     * Continue the asynchronous transfer started by MPU6050::startReadAll.
+     * Must be called each time the I2C master finished one step (I2C ISR or
+     * polling in MPU6050::readAll).
+     */
+
+    switch (transferState)
+    {
+    case TRANSFER_ADDRESS:
+        // Without a timeout, a missing acknowledge would go unnoticed.
+        if (I2CMasterErr(i2cBase) != I2C_MASTER_ERR_NONE)
         {
             sys->error(MPUCommunicationError);
         }
-        sys->delayUS(timeStepUS);
-        timeUS += timeStepUS;
+
+        // Register address sent, now read all the values.
+        I2CMasterSlaveAddrSet(i2cBase, address, true);
+        I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_START);
+        transferIndex = 0;
+        transferState = TRANSFER_RECEIVE;
+        break;
+    case TRANSFER_RECEIVE:
+        transferBuffer[transferIndex] = I2CMasterDataGet(i2cBase);
+        transferIndex++;
+
+        if (transferIndex == SAMPLE_BYTES)
+        {
+            // All values received.
+            I2CMasterIntDisable(i2cBase);
+            transferState = TRANSFER_DONE;
+            if (transferCallback)
+            {
+                transferCallback();
+            }
+        }
+        else if (transferIndex == SAMPLE_BYTES - 1)
+        {
+            I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_FINISH);
+        }
+        else
+        {
+            I2CMasterControl(i2cBase, I2C_MASTER_CMD_BURST_RECEIVE_CONT);
+        }
+        break;
+    default:
+        // No transfer running. Nothing to do.
+        break;
     }
 }
+
+void MPU6050::i2cISR()
+{
+    /*
+     * ISR of the I2C master. Called each time the master finished one step
+     * of an asynchronous transfer.
+     */
+
+    I2CMasterIntClear(asyncInstance->i2cBase);
+    asyncInstance->advanceTransfer();
+}
@@ -12,6 +12,8 @@
 /*
  * stdbool.h:               Boolean definitions for the C99 standard
  * stdint.h:                Variable definitions for the C99 standard
+ * string.h:                Memory functions like memcpy.
+ * math.h:                  Floating point math functions like fabsf()
  * inc/hw_memmap.h:         Macros defining the memory map of the Tiva C Series
  *                          device. This includes defines such as peripheral
  *                          base address locations such as GPIO_PORTF_BASE.
@@ -27,6 +29,8 @@
  */
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <math.h>
 #include "inc/hw_memmap.h"
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
@@ -47,23 +51,110 @@ public:
     void angleRateInvertSign(bool invertSign);
     void accelHorInvertSign(bool invertSign);
     void accelVerInvertSign(bool invertSign);
+    void setLowPass(uint32_t bandwidth);
+    uint32_t getLowPassBandwidth();
+    uint32_t getAngleRateDelayUS();
+    uint32_t getAccelDelayUS();
+    void setSampleRate(uint32_t freq);
+    uint32_t getSampleRate();
+    void enableFIFO(uint32_t samplesPerRead, uint32_t readFreq);
+    void enableDataReadyInterrupt(uint32_t freq);
+    void readAll();
+    uint32_t readFIFO();
+    void calibrateGyro(uint32_t samples);
+    void trackGyroBias(float factor, float standstillRate);
+    float getAngleRateBias();
+    void setTempCompensation(const float gyroCoeffs[3],
+                             const float accelCoeffs[3]);
+    float getTemperature();
+    void startReadAll(void (*callback)(void) = 0);
+    bool isSampleReady();
     float getAngleRate();
     float getAccelHor();
     float getAccelVer();
+    int32_t getRawAngleRate();
+    int32_t getRawAccelHor();
+    int32_t getRawAccelVer();
+
+    // Measurement ranges and the resulting values of one LSB of the raw
+    // values (see MPU6050::getRawAngleRate and the like).
+    const static uint16_t GYRO_RANGE = 250; // [deg/s]
+    const static uint8_t ACCEL_RANGE = 2;   // [g]
+    static constexpr float ANGLE_RATE_PER_LSB = GYRO_RANGE
+                                                * 3.14159265358979f / 180.0f
+                                                / (1 << 15); // [rad/s]
+    static constexpr float ACCEL_PER_LSB = (float) ACCEL_RANGE
+                                           / (1 << 15);     // [g]
 private:
     uint32_t getRegister(uint8_t reg);
+    void getRegisters(uint8_t reg, uint8_t *data, uint32_t count);
+    int16_t getSampleValue(uint8_t reg);
+    void updateOffsets();
     void setRegister(uint8_t reg, uint8_t val);
     void waitWithTimeoutUS(uint32_t timeoutUS = 1000);
+    void advanceTransfer();
+    static void i2cISR();
     System *sys;
+    uint8_t readAllProbe, readFIFOProbe; // see System::addProbe
     uint32_t i2cBase, address;
     uint8_t i2cModuleNum;
     float angleRateSign = 1.0f;
     float accelHorSign = 1.0f;
     float accelVerSign = 1.0f;
     uint8_t angleRateRegister, accelHorRegister, accelVerRegister;
+    uint8_t dlpfConfig = 0;
+
+    // Offset of the gyroscope axes x, y and z in raw sensor units at the
+    // calibration temperature.
+    float gyroBias[3] = {0.0f, 0.0f, 0.0f};
+    float calTemperature = 25.0f; // [C]
+
+    // Change of the offsets in raw sensor units per C.
+    float gyroTempCoeffs[3] = {0.0f, 0.0f, 0.0f};
+    float accelTempCoeffs[3] = {0.0f, 0.0f, 0.0f};
+
+    // Offsets at the temperature of the current sample (see
+    // MPU6050::updateOffsets). The rounded values are used for the raw
+    // sensor values.
+    float gyroOffsets[3] = {0.0f, 0.0f, 0.0f};
+    float accelOffsets[3] = {0.0f, 0.0f, 0.0f};
+    int32_t gyroOffsetsRaw[3] = {0, 0, 0};
+    int32_t accelOffsetsRaw[3] = {0, 0, 0};
+    uint32_t sampleRate = 0;
+    bool fifoEnabled = false;   // see MPU6050::enableFIFO
+
+    // Last sample read by MPU6050::readAll: all sensor registers from
+    // ACCEL_XOUT_H up to GYRO_ZOUT_L (accelerometer, temperature, gyroscope).
+    const static uint8_t SAMPLE_BYTES = 14;
+    uint8_t sample[SAMPLE_BYTES] = {0};
+
+    // State of the interrupt driven transfer started by
+    // MPU6050::startReadAll. The received bytes are stored in transferBuffer
+    // and only copied to sample by MPU6050::readAll.
+    enum TransferState
+    {
+        TRANSFER_IDLE,
+        TRANSFER_ADDRESS,
+        TRANSFER_RECEIVE,
+        TRANSFER_DONE
+    };
+    volatile TransferState transferState = TRANSFER_IDLE;
+    volatile uint8_t transferIndex = 0;
+    uint8_t transferBuffer[SAMPLE_BYTES] = {0};
+    void (*transferCallback)(void) = 0;
+
+    // Buffer for reading the FIFO. Each entry consists of the same values
+    // as the sample read by MPU6050::readAll. If the FIFO contains more
+    // entries, it's read in several bursts.
+    const static uint8_t FIFO_ENTRY_BYTES = SAMPLE_BYTES;
+    const static uint8_t FIFO_BURST_ENTRIES = 16;
+    const static uint16_t FIFO_SIZE = 1024;
+    uint8_t fifoBuffer[FIFO_BURST_ENTRIES * FIFO_ENTRY_BYTES];
+
+    // The I2C ISR is a plain function, it needs to know which object it
+    // belongs to. Only one sensor can use asynchronous transfers.
+    static MPU6050 *asyncInstance;
     char axis;
-    const uint16_t GYRO_RANGE = 250; // [deg/s]
-    const uint8_t ACCEL_RANGE = 2;   // [g]
     const uint8_t I2C_PERIPH  = 0,
                   GPIO_PERIPH = 1,
                   GPIO_BASE   = 2,
@@ -71,6 +162,16 @@ private:
                   SDA_PIN     = 4,
                   SCL_PIN_CFG = 5,
                   SDA_PIN_CFG = 6;
+
+    // Properties of the digital low pass filter settings DLPF_CFG 0-6 (see
+    // MPU-6050 Register Map page 13). Bandwidths in Hz, delays in us.
+    const static uint8_t DLPF_COUNT = 7;
+    const uint16_t DLPF_GYRO_BANDWIDTH[7] = {256, 188, 98, 42, 20, 10, 5};
+    const uint16_t DLPF_GYRO_DELAY[7] = {980, 1900, 2800, 4800, 8300, 13400,
+                                         18600};
+    const uint16_t DLPF_ACCEL_DELAY[7] = {0, 2000, 3000, 4900, 8500, 13800,
+                                          19000};
+
     const uint32_t I2C_CONSTANTS[4][7] =
                  {{SYSCTL_PERIPH_I2C0, SYSCTL_PERIPH_GPIOB, GPIO_PORTB_BASE,
                    GPIO_PIN_2, GPIO_PIN_3, GPIO_PB2_I2C0SCL, GPIO_PB3_I2C0SDA},
@@ -86,8 +187,23 @@ private:
     const uint8_t MPU_REG_CONFIG       = 0x1a;
     const uint8_t MPU_REG_GYRO_CONFIG  = 0x1b;
     const uint8_t MPU_REG_ACCEL_CONFIG = 0x1c;
-    const uint8_t MPU_REG_WHO_AM_I     = 0x75;
+    const uint8_t MPU_REG_FIFO_EN      = 0x23;
+    const uint8_t MPU_REG_INT_PIN_CFG  = 0x37;
+    const uint8_t MPU_REG_INT_ENABLE   = 0x38;
+    const uint8_t MPU_REG_INT_STATUS   = 0x3a;
+    const uint8_t MPU_REG_USER_CTRL    = 0x6a;
     const uint8_t MPU_REG_PWR_MGMT_1   = 0x6b;
+    const uint8_t MPU_REG_FIFO_COUNTH  = 0x72;
+    const uint8_t MPU_REG_FIFO_R_W     = 0x74;
+    const uint8_t MPU_REG_WHO_AM_I     = 0x75;
+
+    // Bits of the registers above
+    const uint8_t MPU_FIFO_EN_ALL         = 0xf8; // TEMP, XG, YG, ZG, ACCEL
+    const uint8_t MPU_INT_PIN_CFG_RD_CLEAR  = 0x10;
+    const uint8_t MPU_INT_ENABLE_DATA_RDY   = 0x01;
+    const uint8_t MPU_INT_STATUS_FIFO_OFLOW = 0x10;
+    const uint8_t MPU_USER_CTRL_FIFO_EN    = 0x40;
+    const uint8_t MPU_USER_CTRL_FIFO_RESET = 0x04;
 
     // Addresses of the registers with the MSB part (xxx_H) of the sensor values
     // The LSB part is always stored in xxx_H + 1
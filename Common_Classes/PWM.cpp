@@ -49,6 +49,7 @@ void PWM::init(System* sys,uint32_t portBase, uint32_t pin1, uint32_t pin2, bool
     // Speichern von system, frequency, pin1, pin2, portbase und bool invert
 
         pwmSys = sys;
+        setDutyProbe = sys->addProbe("PWM::setDuty");
         pwmFreq = freq;
         pwmPin1 = pin1;
         pwmPin2 = pin2;
@@ -156,6 +157,7 @@ void PWM::setFreq(uint32_t freq){
 
 void PWM::setDuty(float duty)
 {
+   ProbeScope probe(pwmSys, setDutyProbe);
 
    newDuty = duty;
    //Compare value = (Period-1)*duty also ist der Compare value gleich null wenn die periode gleich 1 ist
@@ -194,7 +196,7 @@ void PWM::setDuty(float duty)
 
               //Rckwrtsgang fr -1 <= duty <=-0.1
 
-              PWMPulseWidthSet(pwmBase, pwmPinOutR, newDuty * PWMGenPeriodGet(pwmBase, pwmGen));
+              PWMPulseWidthSet(pwmBase, pwmPinOutR, -newDuty * PWMGenPeriodGet(pwmBase, pwmGen));
               pwmSys->delayCycles(12);
 
               PWMOutputState(pwmBase, pwmPinOutBitV, false);
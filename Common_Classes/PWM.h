@@ -63,6 +63,9 @@ private:
 
         float newDuty;
 
+        // Profiling probe (see System::addProbe)
+        uint8_t setDutyProbe;
+
 };
 
 #endif /* PWM_H_ */
@@ -0,0 +1,169 @@
+/*
+ * RideLog.cpp
+ *
+ * Binary log of the controller's inputs and outputs (see RideLog.h).
+ */
+
+#include "RideLog.h"
+
+
+RideLog::RideLog()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+RideLog::~RideLog()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void RideLog::init(System *sys, uint32_t uartBase)
+{
+    /*
+     * Prepare the log. The UART must already be configured (System::init
+     * configures UART0 with 115200 baud).
+     *
+     * sys:      Pointer to the current System instance.
+     * uartBase: UART to send the log with, f.ex. UART0_BASE.
+     */
+
+    this->sys = sys;
+    this->uartBase = uartBase;
+    started = false;
+    pendingFlags = 0;
+    head = tail = 0;
+}
+
+void RideLog::start(uint32_t updateFreq, float maxSpeed,
+                    uint32_t sensorDelayUS)
+{
+    /*
+     * Send the header. Must be called once before the first update of the
+     * controller, with the values the controller has been initialized with.
+     */
+
+    RideLogHeader header;
+    header.sync = RIDELOG_HEADER_SYNC;
+    header.version = RIDELOG_VERSION;
+    header.updateFreq = updateFreq;
+    header.clockFreq = sys->getClockFreq();
+    header.maxSpeed = maxSpeed;
+    header.sensorDelayUS = sensorDelayUS;
+    write(&header, sizeof(header));
+    started = true;
+}
+
+void RideLog::markReset()
+{
+    /*
+     * Note that Controller::resetSpeeds has been called. Stored with the
+     * next record.
+     */
+
+    pendingFlags |= RIDELOG_RESET;
+}
+
+void RideLog::add(bool raw, uint32_t periodUS, float steering,
+                  float angleRate, float accelHor, float accelVer,
+                  float leftSpeed, float rightSpeed)
+{
+    /*
+     * Add the record of one controller update. Called from the update in
+     * the balance task. If the buffer is full the record is dropped and the
+     * next one is flagged with RIDELOG_OVERFLOW.
+     *
+     * raw:                 Whether the inputs are raw sensor values
+     *                      (Controller::updateValuesRaw).
+     * periodUS:            Period handed to Controller::setUpdatePeriodUS
+     *                      before the update.
+     * steering ... accelVer: Inputs handed to the controller.
+     * leftSpeed, rightSpeed: Controller::getLeftSpeed, getRightSpeed.
+     */
+
+    if (!started)
+    {
+        return;
+    }
+
+    uint32_t next = (head + 1) % BUFFER_SIZE;
+    if (next == tail)
+    {
+        pendingFlags |= RIDELOG_OVERFLOW;
+        return;
+    }
+
+    RideLogRecord &record = buffer[head];
+    record.sync = RIDELOG_RECORD_SYNC;
+    record.cycles = sys->getCycles();
+    record.flags = pendingFlags | (raw ? RIDELOG_RAW_VALUES : 0);
+    record.periodUS = periodUS;
+    record.steering = steering;
+    record.angleRate = angleRate;
+    record.accelHor = accelHor;
+    record.accelVer = accelVer;
+    record.leftSpeed = leftSpeed;
+    record.rightSpeed = rightSpeed;
+    pendingFlags = 0;
+    head = next;
+}
+
+void RideLog::send()
+{
+    /*
+     * Send the buffered records. With the UART buffer of System (see
+     * System::enableUARTBuffer) only as many records as it has space for
+     * are queued, the others wait for the next call. If the updates add
+     * more records than the UART can send, the ring buffer runs full and
+     * RideLog::add drops them (RIDELOG_OVERFLOW). Without the UART buffer
+     * this blocks until all records are in the UART's FIFO (3.5ms per record
+     * at 115200 baud), therefore it must be called from a task of low
+     * priority.
+     */
+
+    UARTBuffer *uartBuffer = getUARTBuffer();
+    while (tail != head)
+    {
+        if (uartBuffer && uartBuffer->getFree() < sizeof(RideLogRecord))
+        {
+            return;
+        }
+        write(&buffer[tail], sizeof(RideLogRecord));
+        tail = (tail + 1) % BUFFER_SIZE;
+    }
+}
+
+UARTBuffer *RideLog::getUARTBuffer()
+{
+    /*
+     * Returns the UART buffer of System if it's enabled and belongs to the
+     * UART of the log, else 0.
+     */
+
+    return (uartBase == UART0_BASE) ? sys->getUARTBuffer() : 0;
+}
+
+void RideLog::write(const void *data, uint32_t length)
+{
+    /*
+     * Send bytes unchanged, either via the UART buffer or by waiting for
+     * the UART. UARTwrite of UARTStdio can't be used as it converts \n to
+     * \r\n.
+     */
+
+    UARTBuffer *uartBuffer = getUARTBuffer();
+    if (uartBuffer)
+    {
+        uartBuffer->write(data, length);
+        return;
+    }
+
+    const uint8_t *bytes = (const uint8_t *) data;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        UARTCharPut(uartBase, bytes[i]);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * RideLog.h
+ *
+ * Records the inputs and outputs of each controller update (see
+ * Controller::updateValuesRad and Controller::updateValuesRaw) and sends
+ * them as binary records via the USB UART. Captured to a file on the PC,
+ * the log can be replayed through the Controller class
+ * (Host_Tools/RideReplay.cpp) to check that a change of the controller
+ * doesn't change its behavior.
+ * The records are added by the update to a buffer and sent by
+ * RideLog::send, which is called by a task with a lower priority (see
+ * Segway::addTasks), via the UART buffer of System if it's enabled.
+ * The UART can't transmit the debug values at the same time. At 115200
+ * baud it carries about 280 records per second, at higher update
+ * frequencies records are lost (RIDELOG_OVERFLOW, see CFG_RIDELOG_ENABLE).
+ *
+ * Stream format (little endian, all floats IEEE 754 single precision):
+ *  - one RideLogHeader when the log starts
+ *  - one RideLogRecord per controller update
+ * Each begins with a sync word so that the host can find the beginning of
+ * the log and resynchronize after lost bytes.
+ */
+
+#ifndef RIDELOG_H_
+#define RIDELOG_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * driverlib/uart.h:        Defines and macros for the UART API of DriverLib.
+ * System.h:                Access to current CPU clock and other functions.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "driverlib/uart.h"
+#include "System.h"
+
+
+// Sync words ("RLGH" and "RLGR" as bytes on the UART).
+const uint32_t RIDELOG_HEADER_SYNC = 0x48474c52;
+const uint32_t RIDELOG_RECORD_SYNC = 0x52474c52;
+
+// Incremented with each change of RideLogHeader or RideLogRecord.
+const uint16_t RIDELOG_VERSION = 2;
+
+// Flags of a record
+const uint32_t RIDELOG_RAW_VALUES = 0x01;   // updateValuesRaw was used
+const uint32_t RIDELOG_RESET      = 0x02;   // resetSpeeds before the update
+const uint32_t RIDELOG_OVERFLOW   = 0x04;   // records lost before this one
+
+
+struct RideLogHeader
+{
+    uint32_t sync;              // RIDELOG_HEADER_SYNC
+    uint16_t version;           // RIDELOG_VERSION
+    uint16_t updateFreq;        // [Hz] CFG_CTLR_UPDATE_FREQ
+    uint32_t clockFreq;         // [Hz] unit of RideLogRecord::cycles
+    float maxSpeed;             // Controller::init
+    uint32_t sensorDelayUS;     // Controller::setSensorDelayUS
+};
+
+
+struct RideLogRecord
+{
+    uint32_t sync;              // RIDELOG_RECORD_SYNC
+    uint32_t cycles;            // System::getCycles at the update
+    uint32_t flags;             // RIDELOG_*
+    uint32_t periodUS;          // Controller::setUpdatePeriodUS
+    float steering;             // inputs of the controller (raw values are
+    float angleRate;            // stored as floats, which is exact)
+    float accelHor;
+    float accelVer;
+    float leftSpeed;            // outputs of the controller
+    float rightSpeed;
+};
+
+
+class RideLog
+{
+public:
+    RideLog();
+    virtual ~RideLog();
+    void init(System *sys, uint32_t uartBase);
+    void start(uint32_t updateFreq, float maxSpeed, uint32_t sensorDelayUS);
+    void markReset();
+    void add(bool raw, uint32_t periodUS, float steering, float angleRate,
+             float accelHor, float accelVer, float leftSpeed,
+             float rightSpeed);
+    void send();
+
+private:
+    UARTBuffer *getUARTBuffer();
+    void write(const void *data, uint32_t length);
+
+    System *sys;
+    uint32_t uartBase;
+    bool started = false;
+    uint32_t pendingFlags = 0;
+
+    // Ring buffer of the records not sent yet. Written by RideLog::add
+    // (balance task), read by RideLog::send (ride log task). Both are tasks
+    // of the Scheduler in the main loop and never interrupt each other,
+    // only add moves head and only send moves tail.
+    const static uint32_t BUFFER_SIZE = 16;
+    RideLogRecord buffer[BUFFER_SIZE];
+    uint32_t head = 0;              // next record to write
+    uint32_t tail = 0;              // next record to send
+};
+
+
+#endif /* RIDELOG_H_ */
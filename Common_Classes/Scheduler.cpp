@@ -0,0 +1,342 @@
+/*
+ * Scheduler.cpp
+ *
+ * Small cooperative scheduler running periodic tasks at different rates
+ * (see Scheduler.h).
+ */
+
+#include "Scheduler.h"
+
+
+Scheduler::Scheduler()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+Scheduler::~Scheduler()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void Scheduler::init(System *sys, uint32_t timerBase, void (*ISR)(void),
+                     uint32_t tickFreq)
+{
+    /*
+     * Configure the timer generating the tick. The scheduler doesn't run
+     * until Scheduler::start is called.
+     *
+     * sys:       Pointer to the current System instance.
+     * timerBase: Timer used for the tick, f.ex. TIMER0_BASE.
+     * ISR:       Interrupt handler of the timer. It must call
+     *            Scheduler::tick.
+     * tickFreq:  Frequency of the tick in Hz. All tasks run at this
+     *            frequency divided by an integer.
+     */
+
+    this->sys = sys;
+    this->tickFreq = tickFreq;
+    taskCount = 0;
+    timer.init(sys, timerBase, ISR, tickFreq);
+}
+
+uint8_t Scheduler::addTask(void (*function)(void *), void *context,
+                           uint32_t freq, uint8_t priority, bool external)
+{
+    /*
+     * Register a periodic task and return its number (needed for
+     * Scheduler::getOverruns and the like). The first release is one period
+     * after Scheduler::start.
+     *
+     * function: Task to run. Gets the given context as parameter, which
+     *           allows to use (static) member functions, f.ex.
+     *           void Foo::task(void *foo) { ((Foo *) foo)->update(); }
+     * context:  Pointer handed to the function.
+     * freq:     Frequency of the task in Hz. The period is rounded to a
+     *           multiple of the tick. Tasks faster than the tick run in each
+     *           tick.
+     * priority: If several tasks are due, the one with the highest priority
+     *           runs first (equal priorities in the order of registration).
+     * external: The tick doesn't release the task, only Scheduler::release
+     *           does. freq is its nominal frequency then, which the jitter
+     *           and the deadline misses refer to.
+     */
+
+    if (taskCount >= MAX_TASKS || freq == 0)
+    {
+        sys->error(SchedulerWrongConfig, &freq);
+    }
+
+    uint32_t period = (tickFreq + freq / 2) / freq;
+    if (period < 1)
+    {
+        period = 1;
+    }
+
+    Task &task = tasks[taskCount];
+    task.function = function;
+    task.context = context;
+    task.period = period;
+    task.countdown = period;
+    task.priority = priority;
+    task.external = external;
+    task.pending = false;
+    task.overruns = 0;
+    task.periodCycles = period * (sys->getClockFreq() / tickFreq);
+    task.releaseCycles = 0;
+    task.startCycles = 0;
+    task.interval = task.periodCycles;
+    task.maxJitter = 0;
+    task.deadlineMisses = 0;
+    task.jitterProbe = NO_PROBE;
+
+    return taskCount++;
+}
+
+void Scheduler::start()
+{
+    /*
+     * Start the tick, which releases the periodic tasks (see
+     * Scheduler::addTask). Can be called again after Scheduler::stop.
+     */
+
+    // The time until the first start isn't an interval.
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        tasks[i].startCycles = 0;
+    }
+    timer.start();
+}
+
+void Scheduler::stop()
+{
+    /*
+     * Stop the tick. Tasks which have already been released still run in
+     * Scheduler::run.
+     */
+
+    timer.stop();
+}
+
+void Scheduler::tick()
+{
+    /*
+     * Release all tasks which are due. Must be called by the ISR of the
+     * timer (see Scheduler::init).
+     */
+
+    timer.clearInterruptFlag();
+    uint32_t now = sys->getCycles();
+
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        Task &task = tasks[i];
+        if (task.external)
+        {
+            continue;
+        }
+        if (--task.countdown == 0)
+        {
+            task.countdown = task.period;
+            if (task.pending)
+            {
+                // The last release hasn't been served yet.
+                task.overruns++;
+            }
+            task.pending = true;
+            task.releaseCycles = now;
+        }
+    }
+}
+
+void Scheduler::release(uint8_t task)
+{
+    /*
+     * Release the given task now instead of waiting for the tick. Meant to
+     * be called by an interrupt (f.ex. of a sensor with a new sample); the
+     * task then runs in Scheduler::run like any other. As with the tick, a
+     * release is lost and counted as overrun if the task is still waiting.
+     *
+     * task: Number returned by Scheduler::addTask, usually of an external
+     *       task.
+     */
+
+    Task &t = tasks[task];
+    if (t.pending)
+    {
+        t.overruns++;
+    }
+    // The time first, Scheduler::run reads it once pending is set.
+    t.releaseCycles = sys->getCycles();
+    t.pending = true;
+}
+
+bool Scheduler::run()
+{
+    /*
+     * Run the released task with the highest priority, if any. Returns
+     * whether a task ran. Must be called continuously from the main loop.
+     * Returning after each task ensures that a task which becomes due in
+     * the meantime waits for one task at most.
+     */
+
+    Task *next = 0;
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        if (tasks[i].pending && (!next || tasks[i].priority > next->priority))
+        {
+            next = &tasks[i];
+        }
+    }
+
+    if (!next)
+    {
+        return false;
+    }
+
+    // Cleared before running so that a release during the task is kept.
+    next->pending = false;
+    uint32_t release = next->releaseCycles;
+
+    // The interval between two starts is the period the task actually
+    // experiences (f.ex. the time step of the controller).
+    uint32_t start = sys->getCycles();
+    if (next->startCycles)
+    {
+        next->interval = start - next->startCycles;
+        uint32_t jitter = (next->interval > next->periodCycles)
+                          ? next->interval - next->periodCycles
+                          : next->periodCycles - next->interval;
+        if (jitter > next->maxJitter)
+        {
+            next->maxJitter = jitter;
+        }
+        if (next->jitterProbe != NO_PROBE)
+        {
+            sys->recordProbe(next->jitterProbe, jitter);
+        }
+    }
+    next->startCycles = start;
+
+    next->function(next->context);
+
+    // Deadline is the next release.
+    if (sys->getCycles() - release > next->periodCycles)
+    {
+        next->deadlineMisses++;
+    }
+    return true;
+}
+
+uint32_t Scheduler::getTickFreq()
+{
+    return tickFreq;
+}
+
+uint32_t Scheduler::getTaskFreq(uint8_t task)
+{
+    /*
+     * Returns the actual frequency of the given task in Hz (rounded down).
+     */
+
+    return tickFreq / tasks[task].period;
+}
+
+uint32_t Scheduler::getOverruns(uint8_t task)
+{
+    /*
+     * Returns how often the given task was due again before it had run,
+     * i.e. how many of its releases were lost.
+     */
+
+    return tasks[task].overruns;
+}
+
+uint32_t Scheduler::getTotalOverruns()
+{
+    /*
+     * Returns the sum of the overruns of all tasks.
+     */
+
+    uint32_t overruns = 0;
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        overruns += tasks[i].overruns;
+    }
+    return overruns;
+}
+
+uint32_t Scheduler::getDeadlineMisses(uint8_t task)
+{
+    /*
+     * Returns how often the given task finished after it was due again. A
+     * task with misses delays the others and, if it's the balance task,
+     * the controller works with a longer time step than assumed.
+     */
+
+    return tasks[task].deadlineMisses;
+}
+
+uint32_t Scheduler::getTotalDeadlineMisses()
+{
+    /*
+     * Returns the sum of the deadline misses of all tasks.
+     */
+
+    uint32_t misses = 0;
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        misses += tasks[i].deadlineMisses;
+    }
+    return misses;
+}
+
+uint32_t Scheduler::getIntervalUS(uint8_t task)
+{
+    /*
+     * Returns the time between the last two starts of the given task in
+     * microseconds. Nominally this is 1 / Scheduler::getTaskFreq.
+     */
+
+    return tasks[task].interval / (sys->getClockFreq() / 1000000);
+}
+
+uint32_t Scheduler::getJitterUS(uint8_t task)
+{
+    /*
+     * Returns the maximum deviation of the time between two starts of the
+     * given task from its period in microseconds since Scheduler::start or
+     * Scheduler::resetTiming.
+     */
+
+    return tasks[task].maxJitter / (sys->getClockFreq() / 1000000);
+}
+
+void Scheduler::setJitterProbe(uint8_t task, uint8_t probe)
+{
+    /*
+     * Record the jitter of the given task (in CPU cycles) in a profiling
+     * probe, which gives its distribution (see System::addProbe and
+     * System::sendProbes).
+     * Example:
+     *     scheduler.setJitterProbe(task, sys.addProbe("Task_jitter"));
+     */
+
+    tasks[task].jitterProbe = probe;
+}
+
+void Scheduler::resetTiming()
+{
+    /*
+     * Clear the maximum jitter and the deadline misses of all tasks.
+     */
+
+    for (uint_fast8_t i = 0; i < taskCount; i++)
+    {
+        tasks[i].maxJitter = 0;
+        tasks[i].deadlineMisses = 0;
+    }
+}
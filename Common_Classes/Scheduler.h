@@ -0,0 +1,102 @@
+/*
+ * Scheduler.h
+ *
+ * Small cooperative scheduler running periodic tasks at different rates.
+ * A timer (see Timer.h) generates the tick. The tick interrupt only releases
+ * the tasks which are due; they're executed by Scheduler::run in the main
+ * loop, the one with the highest priority first. A running task is never
+ * interrupted by another one, hence tasks don't need to protect the data
+ * they share.
+ * If a task is still waiting when it's due again, the release is lost and
+ * counted as overrun (see Scheduler::getOverruns). A task which finishes
+ * after its next release missed its deadline (see
+ * Scheduler::getDeadlineMisses). The start times are recorded to measure
+ * the actual period and its jitter (see Scheduler::getJitterUS).
+ * A task can be released by an interrupt instead of the tick (f.ex. by the
+ * data ready interrupt of a sensor, see Scheduler::release). It still runs
+ * from Scheduler::run only, hence the above holds for it as well.
+ * Example (main.cpp):
+ *     void schedulerISR() { scheduler.tick(); }
+ *     ...
+ *     scheduler.init(&sys, TIMER0_BASE, schedulerISR, 1000);
+ *     scheduler.addTask(blinkTask, 0, 2, 0);
+ *     scheduler.start();
+ *     while (1) { scheduler.run(); }
+ * All tasks are stored in a fixed table; no memory is allocated.
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * System.h:                Access to current CPU clock and other functions.
+ * Timer.h:                 Timer generating the tick.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "System.h"
+#include "Timer.h"
+
+
+class Scheduler
+{
+public:
+    Scheduler();
+    virtual ~Scheduler();
+    void init(System *sys, uint32_t timerBase, void (*ISR)(void),
+              uint32_t tickFreq);
+    uint8_t addTask(void (*function)(void *), void *context, uint32_t freq,
+                    uint8_t priority, bool external = false);
+    void start();
+    void stop();
+    void tick();
+    void release(uint8_t task);
+    bool run();
+    uint32_t getTickFreq();
+    uint32_t getTaskFreq(uint8_t task);
+    uint32_t getOverruns(uint8_t task);
+    uint32_t getTotalOverruns();
+    uint32_t getDeadlineMisses(uint8_t task);
+    uint32_t getTotalDeadlineMisses();
+    uint32_t getIntervalUS(uint8_t task);
+    uint32_t getJitterUS(uint8_t task);
+    void setJitterProbe(uint8_t task, uint8_t probe);
+    void resetTiming();
+
+    const static uint8_t MAX_TASKS = 8;
+
+private:
+    struct Task
+    {
+        void (*function)(void *);
+        void *context;
+        uint32_t period;            // in ticks
+        uint32_t countdown;         // ticks until the next release
+        uint8_t priority;
+        bool external;              // released by Scheduler::release only
+        volatile bool pending;      // released but not started yet
+        volatile uint32_t overruns; // lost releases
+
+        // Timing in CPU cycles (see System::getCycles)
+        uint32_t periodCycles;
+        volatile uint32_t releaseCycles; // time of the last release
+        uint32_t startCycles;       // time of the last start
+        uint32_t interval;          // time between the last two starts
+        uint32_t maxJitter;         // max. deviation of interval from period
+        uint32_t deadlineMisses;    // finished after the next release
+        uint8_t jitterProbe;        // see Scheduler::setJitterProbe
+    };
+
+    const static uint8_t NO_PROBE = 0xff;
+
+    System *sys;
+    Timer timer;
+    uint32_t tickFreq = 0;
+    Task tasks[MAX_TASKS];
+    uint8_t taskCount = 0;
+};
+
+#endif /* SCHEDULER_H_ */
@@ -51,6 +51,10 @@ void Segway::init(System *sys)
 
     // Create private reference to the given System object.
     this->sys = sys;
+    sys->setDebugBinary(CFG_DEBUG_BINARY);
+    sys->setProfiling(CFG_PROFILING);
+    updateProbe = sys->addProbe("Segway::update");
+    addDebugChannels();
 
     // Initialize all objects with the given parameters and the parameters from
     // the Config header file.
@@ -96,6 +100,40 @@ void Segway::init(System *sys)
     sensor.accelVerInvertSign(CFG_SENSOR_INVERT_VER);
     sensor.angleRateInvertSign(CFG_SENSOR_INVERT_ANGLE_RATE);
 
+    // Let the sensor filter its measurements according to the update
+    // frequency (if enabled).
+    if (CFG_SENSOR_LOW_PASS)
+    {
+        sensor.setLowPass(CFG_SENSOR_LOW_PASS);
+    }
+    sensor.setSampleRate(CFG_SENSOR_SAMPLE_FREQ);
+    if (CFG_CTLR_DELAY_COMPENSATION)
+    {
+        controller.setSensorDelayUS(sensor.getAngleRateDelayUS());
+    }
+
+    // Measure the gyroscope offset while the segway is still at rest and
+    // compensate its change when the sensor warms up.
+    const float gyroTempCoeffs[3] = CFG_SENSOR_GYRO_TEMP_COEFFS;
+    const float accelTempCoeffs[3] = CFG_SENSOR_ACCEL_TEMP_COEFFS;
+    sensor.calibrateGyro(CFG_SENSOR_GYRO_CAL_SAMPLES);
+    sensor.setTempCompensation(gyroTempCoeffs, accelTempCoeffs);
+
+    // Oversample the sensor and average all samples of one update period.
+    if (CFG_SENSOR_FIFO_SAMPLES)
+    {
+        sensor.enableFIFO(CFG_SENSOR_FIFO_SAMPLES, CFG_CTLR_UPDATE_FREQ);
+    }
+
+    // With the FIFO the data ready interrupt comes with each sample, it
+    // can't trigger the updates (see Segway::enableDataReadyTrigger).
+    // Config.h rejects the combination already.
+    if (CFG_SENSOR_FIFO_SAMPLES && CFG_SENSOR_DATA_READY_TRIGGER)
+    {
+        uint32_t fifoSamples = CFG_SENSOR_FIFO_SAMPLES;
+        sys->error(MPUFifoWithDataReady, &fifoSamples);
+    }
+
     // This Enable Motors Pin is only needed for compatibility with the TivSeg
     // Hardware. It is not used at any other place in the code.
     enableMotors.write(CFG_EM_ACTIVE_STATE);
@@ -103,6 +141,17 @@ void Segway::init(System *sys)
     // We use floats, therefore we want to profit from the FPU.
     sys->enableFPU();
 
+    // The ride log replaces the debug values on the USB UART.
+    if (CFG_RIDELOG_ENABLE)
+    {
+        sys->setDebugging(false);
+        rideLog.init(sys, CFG_RIDELOG_UART_BASE);
+        rideLog.start(CFG_CTLR_UPDATE_FREQ,
+                      CFG_CTLR_MAX_SPEED,
+                      CFG_CTLR_DELAY_COMPENSATION
+                      ? sensor.getAngleRateDelayUS() : 0);
+    }
+
     /*Warten bis Lenkung kalibriert ist*/
     while(calibrated == false)
     {
@@ -111,6 +160,16 @@ void Segway::init(System *sys)
         calibrated = true;
     }
 
+    // Record the updates from now on.
+    if (CFG_RECORDER_ENABLE)
+    {
+        recorder.init(sys->getClockFreq(), CFG_CTLR_UPDATE_FREQ);
+        sys->setFlightRecorder(&recorder);
+    }
+
+    // Profile the operation only, not the calibration.
+    sys->resetProbes();
+
     // Initializing done, segway is ready but not active yet.
     standby = true;
 }
@@ -119,9 +178,30 @@ void Segway::update()
 {
     /*
      * Read all sensor inputs, hand them to the controller and apply the
-     * resulting motor duty cycles.
+     * resulting motor duty cycles. Runs at CFG_CTLR_UPDATE_FREQ (balance
+     * task, see Segway::addTasks). The steering, the battery monitoring and
+     * the debug values are separate tasks with lower rates.
      */
 
+    ProbeScope probe(sys, updateProbe);
+    uint32_t start = sys->getCycles();
+
+    if (CFG_CYCLE_BUDGET)
+    {
+        updateStart = stageStart = sys->getCycles();
+    }
+
+    // The controller integrates with the actual time step (see
+    // Controller::setUpdatePeriodUS).
+    if (CFG_CTLR_MEASURED_DT)
+    {
+        uint32_t now = sys->getCycles();
+        updatePeriodUS = (now - lastUpdateStart)
+                         / (sys->getClockFreq() / 1000000);
+        controller.setUpdatePeriodUS(updatePeriodUS);
+        lastUpdateStart = now;
+    }
+
     // Get state of the foot switch.
     bool footSwitchPressed = (footSwitch.read() == CFG_FS_ACTIVE_STATE);
 
@@ -140,6 +220,14 @@ void Segway::update()
             // start driving.
             standby = false;
         }
+        else if (CFG_SENSOR_GYRO_TRACKING > 0.0f)
+        {
+            // Nobody is on the segway. Use the time to follow the drift of
+            // the gyroscope offset (as long as the segway is not moved).
+            readSensor();
+            sensor.trackGyroBias(CFG_SENSOR_GYRO_TRACKING,
+                                 CFG_SENSOR_GYRO_STANDSTILL);
+        }
     }
     else
     {
@@ -148,19 +236,33 @@ void Segway::update()
             // User is still standing on the foot switch and we're not in
             // standby but in driving mode.
 
-            // Variables for debugging purpose only
+            // The following getters use this sample.
+            readSensor();
+            endStage(STAGE_SENSOR);
 
-            float steeringValue = steering.getValue();
-
-            // Get current angle rate in rad from the gyro
-            float angleRateRad = sensor.getAngleRate() * 3.14159265358979f / 180.0f;
+            float angleRateRad = 0.0f, accelHor = 0.0f, accelVer = 0.0f;
+            if (CFG_CTLR_RAW_SENSOR_VALUES)
+            {
+                // Feed the new sensor data in sensor units into the
+                // controller.
+                controller.updateValuesRaw(steeringValue,
+                                           sensor.getRawAngleRate(),
+                                           sensor.getRawAccelHor(),
+                                           sensor.getRawAccelVer());
+            }
+            else
+            {
+                // Get current angle rate in rad from the gyro
+                angleRateRad = sensor.getAngleRate() * 3.14159265358979f / 180.0f;
 
-            // Get current accelerations in g from the accelerometer
-            float accelHor = sensor.getAccelHor();
-            float accelVer = sensor.getAccelVer();
+                // Get current accelerations in g from the accelerometer
+                accelHor = sensor.getAccelHor();
+                accelVer = sensor.getAccelVer();
 
-            // Feed the new sensor data into the controller
-            controller.updateValuesRad(steeringValue, angleRateRad, accelHor, accelVer);
+                // Feed the new sensor data into the controller
+                controller.updateValuesRad(steeringValue, angleRateRad, accelHor, accelVer);
+            }
+            endControllerStages();
 
             float leftMotorDuty = controller.getLeftSpeed();
             float rightMotorDuty = controller.getRightSpeed();
@@ -168,16 +270,32 @@ void Segway::update()
             // Apply the new duty cycles to the motors
             leftMotor.setDuty(leftMotorDuty);
             rightMotor.setDuty(rightMotorDuty);
+            endStage(STAGE_PWM);
+
+            if (CFG_RECORDER_ENABLE)
+            {
+                recordUpdate(start, leftMotorDuty, rightMotorDuty);
+            }
 
-            // Monitor the most important values. Note: The current tilt angle
-            // is calculated and monitored inside the Controller class.
-            sys->setDebugVal("Ue", steering.getUe()*100);
-            sys->setDebugVal("Steering_Value_[%]", steeringValue * 100);
-            sys->setDebugVal("Left_Speed_[%]" , leftMotorDuty * 100);
-            sys->setDebugVal("Right_Speed_[%]" , rightMotorDuty * 100);
+            if (CFG_RIDELOG_ENABLE)
+            {
+                if (CFG_CTLR_RAW_SENSOR_VALUES)
+                {
+                    rideLog.add(true, updatePeriodUS, steeringValue,
+                                sensor.getRawAngleRate(),
+                                sensor.getRawAccelHor(),
+                                sensor.getRawAccelVer(),
+                                leftMotorDuty, rightMotorDuty);
+                }
+                else
+                {
+                    rideLog.add(false, updatePeriodUS, steeringValue,
+                                angleRateRad, accelHor, accelVer,
+                                leftMotorDuty, rightMotorDuty);
+                }
+            }
 
-            //Akkuspannung plotten um Batteriespannungsberwachung zu testen
-            sys->setDebugVal("Akkuspannung" , batteryVoltage.readVolt() * 100);
+            endStage(STAGE_TELEMETRY);
         }
         else
         {
@@ -187,6 +305,7 @@ void Segway::update()
             // Stop the motors and reset all speeds to 0 as the segway is not
             // moving in standby.
             controller.resetSpeeds();
+            rideLog.markReset();
             leftMotor.setDuty(0);
             rightMotor.setDuty(0);
 
@@ -194,45 +313,472 @@ void Segway::update()
         }
     }
 
-    // Successfully passed the update method.
-    updateFlag = true;
-}
+    // Let the I2C master read the sample for the next update in background.
+    // This is done in standby as well so that the sample is never older
+    // than one update period.
+    if (CFG_SENSOR_ASYNC_READ && !CFG_SENSOR_FIFO_SAMPLES)
+    {
+        sensor.startReadAll();
+    }
 
+    if (CFG_CYCLE_BUDGET)
+    {
+        uint32_t cycles = sys->getCycles() - updateStart;
+        if (cycles > maxUpdateCycles)
+        {
+            maxUpdateCycles = cycles;
+        }
+    }
+
+    // Stored with the next record of the black box.
+    if (CFG_RECORDER_ENABLE)
+    {
+        lastUpdateUS = (sys->getCycles() - start)
+                       / (sys->getClockFreq() / 1000000);
+    }
+}
 
-void Segway::backgroundTasks()
+void Segway::endStage(Stage stage)
 {
     /*
-     * While the Segway::update() method runs the time-critical controller
-     * related code, this method can run in background for monitoring tasks.
-     * Some tasks need to sync with the ISR/Segway::update method. That's what
-     * the segwayUpdateFlag is for.
+     * End of a stage of Segway::update (CFG_CYCLE_BUDGET). Keeps the maximum
+     * of the cycles since the end of the last stage.
      */
 
-    if (updateFlag == true)
+    if (CFG_CYCLE_BUDGET)
+    {
+        uint32_t now = sys->getCycles();
+        uint32_t cycles = now - stageStart;
+        if (cycles > maxStageCycles[stage])
         {
-            /*Whrend Spannung unter 2,1 V ist wird nach oben gezhlt*/
-            if (batteryVoltage.readVolt() < CFG_BATT_MIN/10)
-            {
-                counter = counter + 1;
-            }
+            maxStageCycles[stage] = cycles;
+        }
+        stageStart = now;
+    }
+}
 
-            /*ansonsten wird Zhler = 0 gesetzt*/
-            else
-            {
-            counter = 0;
-            }
+void Segway::endControllerStages()
+{
+    /*
+     * Like Segway::endStage for the controller update, which is split into
+     * the estimation of the angle and the control (see
+     * Controller::getEstimationCycles).
+     */
 
-            /* Nach 5sec werden Motoren ausgeschaltet*/
-            if (counter > 50)
-            {
-                controller.resetSpeeds();
-                leftMotor.setDuty(0);
-                rightMotor.setDuty(0);
+    if (CFG_CYCLE_BUDGET)
+    {
+        uint32_t estimation = controller.getEstimationCycles();
+        uint32_t now = sys->getCycles();
+        uint32_t control = now - stageStart - estimation;
+        if (estimation > maxStageCycles[STAGE_ESTIMATION])
+        {
+            maxStageCycles[STAGE_ESTIMATION] = estimation;
+        }
+        if (control > maxStageCycles[STAGE_CONTROL])
+        {
+            maxStageCycles[STAGE_CONTROL] = control;
+        }
+        stageStart = now;
+    }
+}
 
-                standby = true;
-            }
+void Segway::addDebugChannels()
+{
+    /*
+     * Register the debug values sent by the telemetry task. With
+     * CFG_CYCLE_BUDGET the cycles of the stages replace the values of the
+     * ride. Temperature and battery voltage change slowly, hence the binary
+     * frames contain them only at CFG_DEBUG_SLOW_FREQ.
+     */
 
-        updateFlag = false;
+    uint32_t slow = CFG_DEBUG_FREQ / CFG_DEBUG_SLOW_FREQ;
 
+    if (CFG_CYCLE_BUDGET)
+    {
+        const char *names[STAGE_COUNT] = {"Sensor_[cycles]",
+                                          "Estimation_[cycles]",
+                                          "Control_[cycles]",
+                                          "PWM_[cycles]",
+                                          "Telemetry_[cycles]"};
+        for (uint32_t i = 0; i < STAGE_COUNT; i++)
+        {
+            stageChannels[i] = sys->addDebugChannel(names[i]);
         }
+        loadChannel = sys->addDebugChannel("Load_[0.1%]");
+    }
+    else
+    {
+        ueChannel = sys->addDebugChannel("Ue");
+        steeringChannel = sys->addDebugChannel("Steering_Value_[%]",
+                                               DEBUGFRAME_FLOAT);
+        leftSpeedChannel = sys->addDebugChannel("Left_Speed_[%]",
+                                                DEBUGFRAME_FLOAT);
+        rightSpeedChannel = sys->addDebugChannel("Right_Speed_[%]",
+                                                 DEBUGFRAME_FLOAT);
+        temperatureChannel = sys->addDebugChannel("Sensor_Temp_[0.1C]",
+                                                  DEBUGFRAME_FLOAT, slow);
+        batteryChannel = sys->addDebugChannel("Akkuspannung",
+                                              DEBUGFRAME_INT32, slow);
+    }
+
+    overrunsChannel = sys->addDebugChannel("Overruns");
+    deadlineMissesChannel = sys->addDebugChannel("Deadline_misses");
+    jitterChannel = sys->addDebugChannel("Jitter_[us]");
+    periodChannel = sys->addDebugChannel("Period_[us]");
+}
+
+void Segway::showCycleBudget()
+{
+    /*
+     * Show the maximum CPU cycles of each stage and the maximum load of the
+     * CPU by Segway::update (in 0.1% of the update period) as debug values.
+     * The maxima start over afterwards.
+     * The telemetry stage is the ride log; the debug values are sent by
+     * their own task.
+     */
+
+    for (uint32_t i = 0; i < STAGE_COUNT; i++)
+    {
+        sys->setDebugVal(stageChannels[i], maxStageCycles[i]);
+        maxStageCycles[i] = 0;
+    }
+
+    uint32_t periodCycles = sys->getClockFreq() / CFG_CTLR_UPDATE_FREQ;
+    sys->setDebugVal(loadChannel,
+                     (uint64_t) maxUpdateCycles * 1000 / periodCycles);
+    maxUpdateCycles = 0;
+}
+
+
+void Segway::recordUpdate(uint32_t start, float leftDuty, float rightDuty)
+{
+    /*
+     * Add the update to the black box (see FlightRecorder.h) and freeze it
+     * CFG_RECORDER_AFTER_FALL updates after the segway tilted more than
+     * CFG_RECORDER_FALL_ANGLE.
+     *
+     * start:    System::getCycles at the start of the update.
+     * leftDuty, rightDuty: Duty cycles applied to the motors.
+     */
+
+    float angle = controller.getAngle();
+
+    FlightRecord record;
+    record.cycles = start;
+    record.angleRate = sensor.getRawAngleRate();
+    record.accelHor = sensor.getRawAccelHor();
+    record.accelVer = sensor.getRawAccelVer();
+    record.angle = toRecordValue(angle * (18000.0f / 3.14159265358979f));
+    record.torque = toRecordValue(controller.getTorque() * 10000.0f);
+    record.leftDuty = toRecordValue(leftDuty * 10000.0f);
+    record.rightDuty = toRecordValue(rightDuty * 10000.0f);
+    record.steering = toRecordValue(steeringValue * 10000.0f);
+    record.battery = batteryMV;
+    record.lastUpdateUS = lastUpdateUS;
+    recorder.add(record);
+
+    if (fabsf(angle) > CFG_RECORDER_FALL_ANGLE * (3.14159265358979f / 180.0f))
+    {
+        recorder.freeze(FLIGHTRECORDER_FALL, 0, start,
+                        CFG_RECORDER_AFTER_FALL);
+    }
+}
+
+int16_t Segway::toRecordValue(float value)
+{
+    /*
+     * Round to the int16_t of a FlightRecord, limited to its range.
+     */
+
+    return lrintf(fminf(fmaxf(value, -32768.0f), 32767.0f));
+}
+
+void Segway::readSensor()
+{
+    /*
+     * Read all sensor values at once (or the average of all samples since
+     * the last update if the sensor's FIFO is used).
+     */
+
+    if (CFG_SENSOR_FIFO_SAMPLES)
+    {
+        sensor.readFIFO();
+    }
+    else
+    {
+        sensor.readAll();
+    }
+}
+
+void Segway::enableDataReadyTrigger(void (*ISR)(void))
+{
+    /*
+     * Use the data ready interrupt of the sensor to trigger the updates. This
+     * way each sample is used right after it's been measured. The sensor
+     * generates the samples at CFG_CTLR_UPDATE_FREQ.
+     * The interrupt only releases the balance task, the update itself runs
+     * in the main loop like all other tasks (see Scheduler::release). If the
+     * interrupts stop, the balance task is released by the tick again (see
+     * Segway::runSensorWatchdogTask).
+     * Does nothing if CFG_SENSOR_DATA_READY_TRIGGER is false. The scheduler
+     * then triggers all updates.
+     * Call after Segway::addTasks.
+     * Example (main.cpp):
+     *     void sensorISR() { segway.handleDataReady(); }
+     *     ...
+     *     segway.init(&sys);
+     *     segway.addTasks(&scheduler);
+     *     segway.enableDataReadyTrigger(sensorISR);
+     *
+     * ISR: Function to be called on a rising edge of the sensor's INT pin.
+     *      It must call Segway::handleDataReady.
+     */
+
+    if (!CFG_SENSOR_DATA_READY_TRIGGER)
+    {
+        return;
+    }
+    if (!scheduler)
+    {
+        sys->error(SchedulerWrongConfig);
+    }
+
+    sensor.enableDataReadyInterrupt(CFG_CTLR_UPDATE_FREQ);
+    sensorInterrupt.init(sys,
+                         CFG_SENSOR_INT_PORT,
+                         CFG_SENSOR_INT_PIN,
+                         GPIO_DIR_MODE_IN);
+    sensorInterrupt.enableInterrupt(GPIO_RISING_EDGE, ISR);
+}
+
+void Segway::handleDataReady()
+{
+    /*
+     * Data ready interrupt of the sensor (see Segway::enableDataReadyTrigger).
+     * Releases the balance task, which reads the new sample.
+     */
+
+    sensorInterrupt.clearInterruptFlag();
+    dataReadyCycles = sys->getCycles();
+    scheduler->release(balanceTask);
+}
+
+void Segway::addTasks(Scheduler *scheduler)
+{
+    /*
+     * Register the tasks of the segway. Each part runs only as often as it
+     * needs to:
+     *  - balance:   Segway::update at CFG_CTLR_UPDATE_FREQ
+     *  - steering:  CFG_STEERING_FREQ
+     *  - battery:   CFG_BATT_FREQ
+     *  - telemetry: debug values at CFG_DEBUG_FREQ
+     *  - ride log:  sends the records at CFG_CTLR_UPDATE_FREQ (only if
+     *               CFG_RIDELOG_ENABLE)
+     * With CFG_SENSOR_DATA_READY_TRIGGER the data ready interrupt releases
+     * the balance task (see Segway::enableDataReadyTrigger) and a watchdog
+     * at CFG_CTLR_UPDATE_FREQ takes over if it stops.
+     * The steering is read at the start of the tick and is at most one
+     * steering period old when the update uses it.
+     * The scheduler must tick at CFG_CTLR_UPDATE_FREQ. Call after
+     * Segway::init.
+     * Example (main.cpp):
+     *     void schedulerISR() { scheduler.tick(); }
+     *     ...
+     *     scheduler.init(&sys, CFG_MAIN_TIMER_BASE, schedulerISR,
+     *                    CFG_CTLR_UPDATE_FREQ);
+     *     segway.init(&sys);
+     *     segway.addTasks(&scheduler);
+     *     scheduler.start();
+     *     while (1) { scheduler.run(); }
+     *
+     * scheduler: Initialized Scheduler instance.
+     */
+
+    this->scheduler = scheduler;
+
+    balanceTask = scheduler->addTask(runBalanceTask, this,
+                                     CFG_CTLR_UPDATE_FREQ, PRIORITY_BALANCE,
+                                     CFG_SENSOR_DATA_READY_TRIGGER);
+    scheduler->setJitterProbe(balanceTask,
+                              sys->addProbe("Balance_jitter"));
+    if (CFG_SENSOR_DATA_READY_TRIGGER)
+    {
+        scheduler->addTask(runSensorWatchdogTask, this, CFG_CTLR_UPDATE_FREQ,
+                           PRIORITY_BALANCE);
+    }
+    scheduler->addTask(runSteeringTask, this, CFG_STEERING_FREQ,
+                       PRIORITY_STEERING);
+    batteryTask = scheduler->addTask(runBatteryTask, this, CFG_BATT_FREQ,
+                                     PRIORITY_BATTERY);
+    scheduler->addTask(runTelemetryTask, this, CFG_DEBUG_FREQ,
+                       PRIORITY_TELEMETRY);
+    if (CFG_RIDELOG_ENABLE)
+    {
+        scheduler->addTask(runRideLogTask, this, CFG_CTLR_UPDATE_FREQ,
+                           PRIORITY_TELEMETRY);
+    }
+
+    // The battery must be low for CFG_BATT_TIMEOUT seconds.
+    batteryTimeout = CFG_BATT_TIMEOUT * scheduler->getTaskFreq(batteryTask);
+}
+
+void Segway::runBalanceTask(void *segway)
+{
+    /*
+     * Update of the controller. Released by the tick or, with
+     * CFG_SENSOR_DATA_READY_TRIGGER, by the data ready interrupt.
+     */
+
+    Segway *self = (Segway *) segway;
+    self->updateCount++;
+    self->update();
+}
+
+void Segway::runSensorWatchdogTask(void *segway)
+{
+    /*
+     * Release the balance task if the sensor sent no data ready interrupt
+     * for more than 1.5 update periods (CFG_SENSOR_DATA_READY_TRIGGER).
+     * While the interrupts arrive this does nothing, so the tick and the
+     * sensor (which have different clocks) never both trigger an update
+     * in the same period.
+     */
+
+    Segway *self = (Segway *) segway;
+    System *sys = self->sys;
+
+    uint32_t period = sys->getClockFreq() / CFG_CTLR_UPDATE_FREQ;
+    if (sys->getCycles() - self->dataReadyCycles > period + period / 2)
+    {
+        self->watchdogReleases++;
+        self->scheduler->release(self->balanceTask);
+    }
+}
+
+uint32_t Segway::getUpdateCount()
+{
+    /*
+     * Returns the number of runs of the balance task since the start, f.ex.
+     * to check that the updates go on without the data ready interrupts.
+     */
+
+    return updateCount;
+}
+
+uint32_t Segway::getWatchdogReleases()
+{
+    /*
+     * Returns how often the sensor watchdog released the balance task
+     * because the data ready interrupt was missing (see
+     * Segway::runSensorWatchdogTask).
+     */
+
+    return watchdogReleases;
+}
+
+void Segway::runSteeringTask(void *segway)
+{
+    /*
+     * Read the steering. Done in standby as well so that the value is
+     * recent when someone steps on the segway.
+     */
+
+    Segway *self = (Segway *) segway;
+    self->steeringValue = self->steering.getValue();
+}
+
+void Segway::runBatteryTask(void *segway)
+{
+    /*
+     * Stop the segway if the battery voltage stays too low for
+     * CFG_BATT_TIMEOUT seconds.
+     */
+
+    Segway *self = (Segway *) segway;
+    float voltage = self->batteryVoltage.readVolt();
+    self->batteryMV = voltage * 1000.0f;
+
+    /*Whrend Spannung unter 2,1 V ist wird nach oben gezhlt*/
+    if (voltage < CFG_BATT_MIN/10)
+    {
+        self->batteryLowCount++;
+    }
+
+    /*ansonsten wird Zhler = 0 gesetzt*/
+    else
+    {
+        self->batteryLowCount = 0;
+    }
+
+    /* Nach CFG_BATT_TIMEOUT Sekunden werden Motoren ausgeschaltet*/
+    if (self->batteryLowCount >= self->batteryTimeout)
+    {
+        self->controller.resetSpeeds();
+        self->rideLog.markReset();
+        self->leftMotor.setDuty(0);
+        self->rightMotor.setDuty(0);
+
+        self->standby = true;
+    }
+}
+
+void Segway::runTelemetryTask(void *segway)
+{
+    /*
+     * Update the debug values while driving and send them to the computer.
+     */
+
+    Segway *self = (Segway *) segway;
+    System *sys = self->sys;
+
+    if (!self->standby && CFG_CYCLE_BUDGET)
+    {
+        self->showCycleBudget();
+    }
+    else if (!self->standby)
+    {
+        // Monitor the most important values. Note: The current tilt angle
+        // is calculated and monitored inside the Controller class.
+        sys->setDebugVal(self->ueChannel, self->steering.getUe()*100);
+        sys->setDebugValFloat(self->steeringChannel, self->steeringValue * 100);
+        sys->setDebugValFloat(self->leftSpeedChannel, self->controller.getLeftSpeed() * 100);
+        sys->setDebugValFloat(self->rightSpeedChannel, self->controller.getRightSpeed() * 100);
+
+        // Needed to determine the temperature coefficients of the sensor.
+        sys->setDebugValFloat(self->temperatureChannel, self->sensor.getTemperature() * 10);
+
+        //Akkuspannung plotten um Batteriespannungsberwachung zu testen
+        // (last value of the battery task, the ADC isn't read again)
+        sys->setDebugVal(self->batteryChannel, self->batteryMV / 10);
+    }
+
+    // Releases of any task lost because the others took too long.
+    sys->setDebugVal(self->overrunsChannel, self->scheduler->getTotalOverruns());
+
+    // Timing of the updates. The distribution of the jitter is part of the
+    // profiling statistics (see System::handleRequests).
+    Scheduler *scheduler = self->scheduler;
+    sys->setDebugVal(self->deadlineMissesChannel,
+                     scheduler->getTotalDeadlineMisses());
+    sys->setDebugVal(self->jitterChannel,
+                     scheduler->getJitterUS(self->balanceTask));
+    sys->setDebugVal(self->periodChannel,
+                     scheduler->getIntervalUS(self->balanceTask));
+
+    sys->sendDebugVals();
+
+    // Not while the ride log uses the UART.
+    if (!CFG_RIDELOG_ENABLE)
+    {
+        sys->handleRequests();
+    }
+}
+
+void Segway::runRideLogTask(void *segway)
+{
+    /*
+     * Send the records of the ride log collected by the updates.
+     */
+
+    ((Segway *) segway)->rideLog.send();
 }
@@ -25,6 +25,12 @@
  * ADC.h:        Header file for the ADC class
  * MPU6050.h:    Header file for the MPU6050 class
  * Steering.h:   Header file for the Steering class
+ * RideLog.h:    Header file for the RideLog class (binary log of the
+ *               controller's inputs and outputs)
+ * FlightRecorder.h: Header file for the FlightRecorder class (black box of
+ *               the last updates)
+ * Scheduler.h:  Header file for the Scheduler class running the tasks of the
+ *               segway at their rates
  */
 #include <stdbool.h>
 #include <stdint.h>
@@ -37,6 +43,9 @@
 #include "MPU6050.h"
 #include "Steering.h"
 #include "Timer.h"
+#include "RideLog.h"
+#include "FlightRecorder.h"
+#include "Scheduler.h"
 
 class Segway
 {
@@ -45,23 +54,106 @@ public:
     virtual ~Segway();
     void init(System *sys);
     void update();
-    void backgroundTasks();
+    void enableDataReadyTrigger(void (*ISR)(void));
+    void handleDataReady();
+    void addTasks(Scheduler *scheduler);
+    uint32_t getUpdateCount();
+    uint32_t getWatchdogReleases();
 
 private:
+    // Stages of Segway::update whose CPU cycles are measured
+    // (CFG_CYCLE_BUDGET).
+    enum Stage
+    {
+        STAGE_SENSOR,
+        STAGE_ESTIMATION,
+        STAGE_CONTROL,
+        STAGE_PWM,
+        STAGE_TELEMETRY,
+        STAGE_COUNT
+    };
+
+    void addDebugChannels();
+    void readSensor();
+    void recordUpdate(uint32_t start, float leftDuty, float rightDuty);
+    static int16_t toRecordValue(float value);
+    void endStage(Stage stage);
+    void endControllerStages();
+    void showCycleBudget();
+
+    // Tasks run by the scheduler (see Segway::addTasks). The parameter is
+    // the Segway instance.
+    static void runBalanceTask(void *segway);
+    static void runSensorWatchdogTask(void *segway);
+    static void runSteeringTask(void *segway);
+    static void runBatteryTask(void *segway);
+    static void runTelemetryTask(void *segway);
+    static void runRideLogTask(void *segway);
+
+    // Priorities of the tasks. The steering runs before the balance task
+    // if both are due in the same tick, so the update gets the new value.
+    const static uint8_t PRIORITY_STEERING = 4;
+    const static uint8_t PRIORITY_BALANCE = 3;
+    const static uint8_t PRIORITY_BATTERY = 1;
+    const static uint8_t PRIORITY_TELEMETRY = 0;
+
     System* sys;
+    Scheduler* scheduler = 0;
+    uint8_t updateProbe; // see System::addProbe
+
+    // Debug values (see System::addDebugChannel and Segway::addDebugChannels)
+    uint8_t ueChannel, steeringChannel, leftSpeedChannel, rightSpeedChannel;
+    uint8_t temperatureChannel, batteryChannel;
+    uint8_t overrunsChannel, deadlineMissesChannel, jitterChannel;
+    uint8_t periodChannel;
+    uint8_t stageChannels[STAGE_COUNT], loadChannel;
 
-    Controller controller;
-    GPIO footSwitch, enableMotors;
+    Controller<CFG_CTLR_PARAMS, CFG_CTLR_ESTIMATOR> controller;
+    GPIO footSwitch, enableMotors, sensorInterrupt;
     Steering steering;
     PWM leftMotor, rightMotor;
     ADC batteryVoltage;
     MPU6050 sensor;
+    RideLog rideLog;
+    FlightRecorder recorder;
+
+    uint8_t balanceTask = 0, batteryTask = 0;
+
+    // Runs of the balance task and releases of it by the sensor watchdog
+    // (see Segway::getUpdateCount).
+    uint32_t updateCount = 0;
+    uint32_t watchdogReleases = 0;
+
+    // Checks of the battery with too low voltage in a row and the number
+    // after which the segway stops.
+    uint32_t batteryLowCount = 0;
+    uint32_t batteryTimeout = 0;
+
+    // Latest value of the steering task
+    float steeringValue = 0.0f;
+
+    // Values of the black box which aren't measured by the update
+    // (see Segway::recordUpdate).
+    uint16_t batteryMV = 0;
+    uint16_t lastUpdateUS = 0;
+
+    // Maximum cycles of each stage and of the whole update since they've
+    // been shown (see Segway::showCycleBudget).
+    uint32_t maxStageCycles[STAGE_COUNT] = {0};
+    uint32_t maxUpdateCycles = 0;
+    uint32_t updateStart = 0, stageStart = 0;
+    uint32_t lastUpdateStart = 0; // CFG_CTLR_MEASURED_DT
+
+    // Period handed to the controller (see Controller::setUpdatePeriodUS),
+    // stored in the ride log.
+    uint32_t updatePeriodUS = 1000000 / CFG_CTLR_UPDATE_FREQ;
 
-    uint32_t counter = 0;
 
+    // Time of the last data ready interrupt (CFG_SENSOR_DATA_READY_TRIGGER,
+    // see Segway::runSensorWatchdogTask).
+    volatile uint32_t dataReadyCycles = 0;
 
     // Flags
-    bool updateFlag = false;
 
     bool standby = true;
 
@@ -61,6 +61,15 @@ void System::init(uint32_t clk)
 
     // Store the CPU clock
     clockFrequency = clk;
+    cyclesPerUS = clk / 1000000;
+
+    /*
+     * Start the cycle counter of the DWT unit. It's incremented with each
+     * clock cycle and used as time base (see System::getCycles).
+     */
+    HWREG(DEMCR_REG)     |= DEMCR_TRCENA;
+    HWREG(DWT_CYCCNT_REG) = 0;
+    HWREG(DWT_CTRL_REG)  |= DWT_CYCCNTENA;
 
     /*
      * Set the clock divisor which applies to all PWM modules ("TivaWare(TM)
@@ -73,20 +82,7 @@ void System::init(uint32_t clk)
     /*
      * Use the USB UART to send debugging data.
      */
-
-     // Enable peripherals
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
-
-    // Wait until peripheral is enabled "TivaWare(TM) Treiberbibliothek"
-    // page 502, "TivaC Launchpad Workshop" page 78)
-    delayCycles(5);
-
-    // Configure UART and use it with UARTStdio
-    GPIOPinConfigure(GPIO_PA0_U0RX);
-    GPIOPinConfigure(GPIO_PA1_U0TX);
-    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
-    UARTStdioConfig(0, 115200, getClockFreq());
+    initUART();
 
     /*
      *  Unlock the two Pins PF0 and PD7. Because those can be used for an NMI
@@ -123,6 +119,9 @@ void System::error(ErrorCodes errorCode, void *faultOrigin0,
      * In case of an error other classes call this method and provide optional
      * debugging informations. It disables interrupts, stops all the
      * peripherals of the uC and enters an infinite loop.
+     * The black box (see System::setFlightRecorder) is frozen first. Only
+     * the USB UART is restarted afterwards, to send the black box when "b"
+     * is received.
      *
      * errorCode:   optional error parameter giving informations about the
      *              origin of the fault. Default is UnknownError
@@ -133,6 +132,12 @@ void System::error(ErrorCodes errorCode, void *faultOrigin0,
     // Disable Interrupts
     IntMasterDisable();
 
+    // Keep the updates which led to the error.
+    if (flightRecorder)
+    {
+        flightRecorder->freeze(FLIGHTRECORDER_ERROR, errorCode, getCycles());
+    }
+
     // Stop all peripherals
     for (uint_fast8_t i = 0; i < PERIPH_COUNT; i++)
     {
@@ -140,7 +145,40 @@ void System::error(ErrorCodes errorCode, void *faultOrigin0,
         SysCtlPeripheralDisable(ALL_PERIPHS[i]);
     }
 
-    while (42);
+    if (flightRecorder)
+    {
+        initUART();
+    }
+    while (42)
+    {
+        if (flightRecorder && UARTCharGetNonBlocking(UART0_BASE) == 'b')
+        {
+            flightRecorder->startDump(getCycles());
+            flightRecorder->sendDump(0, UART0_BASE);
+        }
+    }
+}
+
+void System::initUART()
+{
+    /*
+     * Configure the USB UART (UART0) with 115200 baud and use it with
+     * UARTStdio. Also used by System::error to send the black box.
+     */
+
+     // Enable peripherals
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+
+    // Wait until peripheral is enabled "TivaWare(TM) Treiberbibliothek"
+    // page 502, "TivaC Launchpad Workshop" page 78)
+    delayCycles(5);
+
+    // Configure UART and use it with UARTStdio
+    GPIOPinConfigure(GPIO_PA0_U0RX);
+    GPIOPinConfigure(GPIO_PA1_U0TX);
+    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+    UARTStdioConfig(0, 115200, getClockFreq());
 }
 
 uint32_t System::getClockFreq()
@@ -249,6 +287,55 @@ void System::delayUS(uint32_t us)
     delayCycles(us);
 }
 
+uint32_t System::getCycles()
+{
+    /*
+     * Returns the number of clock cycles since System::init. The counter
+     * overflows after 2^32 cycles (107s at 40MHz). Time differences are
+     * nevertheless correct as long as they are calculated with unsigned
+     * integers and are shorter than that.
+     */
+
+    return HWREG(DWT_CYCCNT_REG);
+}
+
+uint32_t System::getDeadlineUS(uint32_t us)
+{
+    /*
+     * Returns the value of the cycle counter the given amount of
+     * microseconds from now. Use System::deadlinePassed to check whether
+     * this time has come.
+     * Example:
+     *     uint32_t deadline = sys->getDeadlineUS(1000);
+     *     while (busy())
+     *     {
+     *         if (sys->deadlinePassed(deadline))
+     *         {
+     *             // Timeout
+     *         }
+     *     }
+     *
+     * us: Time from now in microseconds. Must be less than half the overflow
+     *     period of the cycle counter (53s at 40MHz).
+     */
+
+    return getCycles() + us * cyclesPerUS;
+}
+
+bool System::deadlinePassed(uint32_t deadline)
+{
+    /*
+     * Returns whether the cycle counter reached the given deadline (see
+     * System::getDeadlineUS).
+     *
+     * deadline: Value returned by System::getDeadlineUS.
+     */
+
+    // The signed difference is correct even if the counter overflowed in
+    // between.
+    return ((int32_t) (getCycles() - deadline) >= 0);
+}
+
 void System::setDebugging(bool debug)
 {
     /*
@@ -258,20 +345,40 @@ void System::setDebugging(bool debug)
     debugEnabled = debug;
 }
 
-void System::setDebugVal(const char* name, int32_t value)
+void System::setDebugBinary(bool binary)
+{
+    /*
+     * Send the debug values as binary frames (see DebugFrame.h) instead of
+     * text. The frames need far less CPU time (no printf) but only about
+     * 1.1 to 1.3 times fewer bytes (see DebugFrame.h), hence the UART
+     * carries only slightly more values per second. Host_Tools/DebugDecode.cpp
+     * converts them to CSV or to the text format (f.ex. for the Serial
+     * Plotter).
+     * By default the text format is used.
+     */
+
+    debugBinary = binary;
+    debugNewLabel = true;
+}
+
+uint8_t System::addDebugChannel(const char *name, uint8_t type,
+                                uint32_t decimation)
 {
     /*
-     * Set up to <systemMaxDebugVals> values to monitor via USB UART (Serial
-     * Monitor or Serial Plotter).
+     * Register a value to monitor via USB UART (Serial Monitor, Serial
+     * Plotter or Host_Tools/DebugDecode) and return its handle for
+     * System::setDebugVal. Call this once during initialization; setting
+     * the value via the handle then costs a few instructions.
+     * Up to MAX_DEBUG_CHANNELS channels can be registered. If there's no
+     * space left, NO_DEBUG_CHANNEL is returned (setting it does nothing)
+     * and "Too_many_debug_values" is added to the labels of the text format.
+     * Registering a name a second time returns the same handle.
      * Example:
-     *   You have two functions that use debugging. Function foo watches 1
-     *   value, function bar watches 2 values. Of course you do not want to
-     *   overwrite the values from foo inside bar and vice-versa.
-     *   Therefore you write inside foo:
-     *      fooSys->setDebugVal("My Foo Value", fooValue);
-     *   And inside bar:
-     *      barSys->setDebugVal("My first Bar Value",  barValue1);
-     *      barSys->setDebugVal("My second Bar Value", barValue2);
+     *     // init
+     *     angleChannel = sys->addDebugChannel("Angle_[0.1deg]",
+     *                                         DEBUGFRAME_FLOAT);
+     *     // update
+     *     sys->setDebugValFloat(angleChannel, angle * 10.0f);
      * Notes:
      *   * If you use the Arduino Serial Plotter your Arduino IDE needs to be
      *     v1.8.10 or newer.
@@ -286,95 +393,720 @@ void System::setDebugVal(const char* name, int32_t value)
      *     Value_1\tValue_2\tValue_3\tValue_4\n
      *     Value_1\tValue_2\tValue_3\tValue_4\n
      *     ...
+     *     or binary frames (see System::setDebugBinary).
      *
-     * name:  String with name that shall be shown in Serial Plotter legend.
-     *        Must not contain ","  "\t"  " " or "\n".
-     * value: Integer value to transmit.
+     * name:       String with name that shall be shown in Serial Plotter
+     *             legend. Must not contain ","  "\t"  " " or "\n". Only the
+     *             pointer is stored, hence it must remain valid (f.ex. a
+     *             string literal).
+     * type:       DEBUGFRAME_INT32 or DEBUGFRAME_FLOAT. Values set with the
+     *             other type are converted.
+     * decimation: The channel is only contained in every decimation-th
+     *             binary frame (1: in all of them). For slowly changing
+     *             values. The text format always contains all channels.
      */
 
-    if (debugEnabled)
+    for (uint_fast8_t i = 0; i < debugChannelCount; i++)
     {
-        /*
-         * Check if this variable is already being watched and if not, check
-         * if there's space for a new variable. In either case the
-         * corresponding value is updated.
-         */
-        for(uint_fast8_t i = 0; i < maxDebugVals; i++)
+        if (debugChannels[i].name == name)
         {
-            if (debugNames[i] == name)
-            {
-                debugVals[i]  = value;
-                return;
-            }
-            else if (debugNames[i] == debugUnused)
-            {
-                debugVals[i]  = value;
-                debugNames[i] = name;
-                debugNewLabel = true;
-                return;
-            }
+            return i;
         }
+    }
 
-        /*
-         * If we did not reach a return statement in the for loop we have a
-         * new variable but no space for it and want to set the according flag.
-         * This must be done only once otherwise System::sendDebugValues will
-         * send labels only (because systemDebugNewLabel would always be true).
-         */
+    if (debugChannelCount >= MAX_DEBUG_CHANNELS)
+    {
         if (!tooManyDebugVals)
         {
             tooManyDebugVals = true;
             debugNewLabel = true;
         }
+        return NO_DEBUG_CHANNEL;
+    }
+
+    if (decimation < 1)
+    {
+        decimation = 1;
+    }
+    else if (decimation > UINT16_MAX)
+    {
+        decimation = UINT16_MAX;
+    }
+
+    DebugChannel &c = debugChannels[debugChannelCount];
+    c.name = name;
+    c.type = (type == DEBUGFRAME_FLOAT) ? DEBUGFRAME_FLOAT : DEBUGFRAME_INT32;
+    c.value.i = 0;
+    c.decimation = decimation;
+    c.countdown = 1;
+    debugNewLabel = true;
+    return debugChannelCount++;
+}
+
+void System::setDebugVal(uint8_t channel, int32_t value)
+{
+    /*
+     * Set the value of a channel registered with System::addDebugChannel.
+     */
+
+    if (channel < debugChannelCount)
+    {
+        DebugChannel &c = debugChannels[channel];
+        if (c.type == DEBUGFRAME_FLOAT)
+        {
+            c.value.f = value;
+        }
+        else
+        {
+            c.value.i = value;
+        }
     }
 }
 
+void System::setDebugValFloat(uint8_t channel, float value)
+{
+    /*
+     * Same as System::setDebugVal, but for a float value. The binary frames
+     * transmit it unchanged, the text format only its integer part.
+     */
+
+    if (channel < debugChannelCount)
+    {
+        DebugChannel &c = debugChannels[channel];
+        if (c.type == DEBUGFRAME_FLOAT)
+        {
+            c.value.f = value;
+        }
+        else
+        {
+            c.value.i = value;
+        }
+    }
+}
+
+void System::setDebugVal(const char* name, int32_t value)
+{
+    /*
+     * Set a value by its name. The channel is registered on the first call
+     * (see System::addDebugChannel). Each call searches the channels,
+     * hence this is meant for quick tests; use the handles in code which
+     * runs periodically.
+     */
+
+    setDebugVal(addDebugChannel(name, DEBUGFRAME_INT32), value);
+}
+
+void System::setDebugValFloat(const char* name, float value)
+{
+    /*
+     * Same as System::setDebugVal, but for a float value.
+     */
+
+    setDebugValFloat(addDebugChannel(name, DEBUGFRAME_FLOAT), value);
+}
+
 void System::sendDebugVals()
 {
     /*
-     * If debugging is enabled, send data to PC via UART. Unused values are
-     * skipped.
+     * If debugging is enabled, send data to PC via UART. Only the
+     * registered channels are sent (see System::addDebugChannel).
      * This method should be called periodically (f.ex. 10Hz Timer interrupt)
      */
 
-    if (debugEnabled)
+    // The dump of the black box (see System::handleRequests) isn't
+    // interrupted.
+    if (debugEnabled && !(flightRecorder && flightRecorder->isDumping()))
     {
-        if (debugNewLabel)
+        if (debugBinary)
         {
-            /*
-             * Labels are only transmitted if there's a new one. The result
-             * in the Arduino serial plotter will be the same but it requires
-             * far less time to transmit the values compared to sending the
-             * labels at each value update.
-             * See https://github.com/arduino/Arduino/blob/master/build/shared/
-             * ArduinoSerialPlotterProtocol.md
-             */
-            for (uint_fast8_t i = 0; i < maxDebugVals; i++)
-            {
-                if (debugNames[i] != debugUnused)
-                {
-                    UARTprintf("%s\t", debugNames[i]);
-                }
-            }
-            if (tooManyDebugVals)
-            {
-                UARTprintf("%s", "Too_many_debug_values");
-            }
-            UARTprintf("\n");
-            debugNewLabel = false;
+            sendDebugFrames();
+        }
+        else
+        {
+            sendDebugText();
         }
-        
+    }
+}
+
+void System::sendDebugText()
+{
+    /*
+     * Text format of System::sendDebugVals. Each line is assembled in
+     * debugFrame and sent at once (see System::sendDebugOutput).
+     */
+
+    if (debugNewLabel)
+    {
         /*
-         * Normal operation. Send values only.
+         * Labels are only transmitted if there's a new one. The result
+         * in the Arduino serial plotter will be the same but it requires
+         * far less time to transmit the values compared to sending the
+         * labels at each value update.
+         * See https://github.com/arduino/Arduino/blob/master/build/shared/
+         * ArduinoSerialPlotterProtocol.md
          */
-        for (uint_fast8_t i = 0; i < maxDebugVals; i++)
+        debugFrameLength = 0;
+        for (uint_fast8_t i = 0; i < debugChannelCount; i++)
+        {
+            const char *name = debugChannels[i].name;
+            addDebugFrameBytes(name, strlen(name));
+            addDebugFrameBytes("\t", 1);
+        }
+        if (tooManyDebugVals)
         {
-            if (debugNames[i] != debugUnused)
+            addDebugFrameBytes("Too_many_debug_values", 21);
+        }
+        addDebugFrameBytes("\n", 1);
+
+        // Repeated with the next values if the buffer was full.
+        debugNewLabel = !sendDebugOutput(true);
+    }
+
+    /*
+     * Normal operation. Send values only.
+     */
+    debugFrameLength = 0;
+    for (uint_fast8_t i = 0; i < debugChannelCount; i++)
+    {
+        DebugChannel &c = debugChannels[i];
+        int32_t value = c.value.i;
+        if (c.type == DEBUGFRAME_FLOAT)
+        {
+            value = c.value.f;
+        }
+        addDebugTextInt(value);
+        addDebugFrameBytes("\t", 1);
+    }
+    addDebugFrameBytes("\n", 1);
+    sendDebugOutput(true);
+}
+
+void System::addDebugTextInt(int32_t value)
+{
+    /*
+     * Append the value in decimal with at least 4 characters, padded with
+     * zeros (like "%04d" of printf).
+     */
+
+    char digits[12];
+    uint32_t count = 0;
+    uint32_t magnitude = (value < 0) ? -(uint32_t) value : value;
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude);
+
+    uint32_t width = (value < 0) ? 3 : 4;
+    if (value < 0)
+    {
+        addDebugFrameBytes("-", 1);
+    }
+    while (width > count)
+    {
+        addDebugFrameBytes("0", 1);
+        width--;
+    }
+    while (count)
+    {
+        addDebugFrameBytes(&digits[--count], 1);
+    }
+}
+
+void System::addDebugTextUInt(uint32_t value)
+{
+    /*
+     * Append the value in decimal without padding (like "%u" of printf).
+     */
+
+    char digits[10];
+    uint32_t count = 0;
+    do
+    {
+        digits[count++] = '0' + value % 10;
+        value /= 10;
+    } while (value);
+
+    while (count)
+    {
+        addDebugFrameBytes(&digits[--count], 1);
+    }
+}
+
+void System::sendDebugFrames()
+{
+    /*
+     * Binary format of System::sendDebugVals (see DebugFrame.h). The names,
+     * types and decimations of all channels are sent as a schema frame
+     * whenever a channel has been added. The value frames contain only the
+     * channels which are due (see System::addDebugChannel).
+     */
+
+    if (debugNewLabel)
+    {
+        uint32_t all = 0;
+        beginDebugFrame();
+        for (uint_fast8_t i = 0; i < debugChannelCount; i++)
+        {
+            DebugChannel &c = debugChannels[i];
+            all |= 1u << i;
+            addDebugFrameBytes(&c.type, 1);
+            addDebugFrameBytes(&c.decimation, 2);
+            addDebugFrameBytes(c.name, strlen(c.name) + 1);
+        }
+
+        // Repeated with the next values if the buffer was full.
+        debugNewLabel = !sendDebugFrame(DEBUGFRAME_SCHEMA, all);
+    }
+
+    uint32_t mask = 0;
+    uint32_t count = 0;
+    for (uint_fast8_t i = 0; i < debugChannelCount; i++)
+    {
+        DebugChannel &c = debugChannels[i];
+        if (--c.countdown == 0)
+        {
+            c.countdown = c.decimation;
+            mask |= 1u << i;
+            count++;
+        }
+    }
+    if (!mask)
+    {
+        return;
+    }
+
+    /*
+     * The types (2 bits per value) are followed by the values. Integers
+     * which fit into 16 bits are sent as such.
+     */
+    beginDebugFrame();
+    uint8_t *types = &debugFrame[debugFrameLength];
+    uint32_t typeBytes = (count + 3) / 4;
+    for (uint32_t i = 0; i < typeBytes; i++)
+    {
+        types[i] = 0;
+    }
+    debugFrameLength += typeBytes;
+
+    uint32_t n = 0;
+    for (uint_fast8_t i = 0; i < debugChannelCount; i++)
+    {
+        if (!(mask & (1u << i)))
+        {
+            continue;
+        }
+
+        DebugChannel &c = debugChannels[i];
+        uint8_t type = c.type;
+        int32_t value = c.value.i;
+        if (type == DEBUGFRAME_INT32 && value == (int16_t) value)
+        {
+            int16_t shortValue = value;
+            type = DEBUGFRAME_INT16;
+            addDebugFrameBytes(&shortValue, 2);
+        }
+        else
+        {
+            // Float or int32, both 4 bytes
+            addDebugFrameBytes(&c.value, 4);
+        }
+        types[n / 4] |= type << (2 * (n % 4));
+        n++;
+    }
+    sendDebugFrame(DEBUGFRAME_VALUES, mask);
+}
+
+void System::beginDebugFrame()
+{
+    /*
+     * Start a new frame. The header is filled in by System::sendDebugFrame.
+     */
+
+    debugFrameLength = DEBUGFRAME_HEADER_SIZE;
+}
+
+void System::addDebugFrameBytes(const void *data, uint32_t length)
+{
+    /*
+     * Append bytes to the payload of the current frame. Bytes which don't
+     * fit (leaving space for the CRC) are dropped.
+     */
+
+    if (debugFrameLength + length > DEBUG_FRAME_SIZE - 2)
+    {
+        length = DEBUG_FRAME_SIZE - 2 - debugFrameLength;
+    }
+    memcpy(&debugFrame[debugFrameLength], data, length);
+    debugFrameLength += length;
+}
+
+bool System::sendDebugFrame(uint8_t type, uint32_t mask)
+{
+    /*
+     * Complete the current frame with its header and CRC and send it.
+     * Returns false if it was dropped (see System::sendDebugOutput).
+     */
+
+    DebugFrameHeader header;
+    header.sync = DEBUGFRAME_SYNC;
+    header.type = type;
+    header.sequence = debugFrameSequence++;
+    header.cycles = getCycles();
+    header.mask = mask;
+    header.length = debugFrameLength - DEBUGFRAME_HEADER_SIZE;
+    memcpy(debugFrame, &header, DEBUGFRAME_HEADER_SIZE);
+
+    uint16_t crc = debugFrameCRC(0xffff, debugFrame, debugFrameLength);
+    debugFrame[debugFrameLength++] = crc & 0xff;
+    debugFrame[debugFrameLength++] = crc >> 8;
+
+    return sendDebugOutput(false);
+}
+
+bool System::sendDebugOutput(bool text)
+{
+    /*
+     * Send the contents of debugFrame. With the UART buffer (see
+     * System::enableUARTBuffer) they're only queued; if there's no space
+     * they're dropped and false is returned. Otherwise this waits until all
+     * bytes are in the UART's FIFO.
+     * UARTwrite of UARTStdio converts \n to \r\n, hence it's only used for
+     * text. The buffer sends all bytes unchanged (the Serial Plotter only
+     * needs the \n).
+     */
+
+    if (uartBuffered)
+    {
+        return uartBuffer.write(debugFrame, debugFrameLength);
+    }
+
+    if (text)
+    {
+        UARTwrite((const char *) debugFrame, debugFrameLength);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < debugFrameLength; i++)
+        {
+            UARTCharPut(UART0_BASE, debugFrame[i]);
+        }
+    }
+    return true;
+}
+
+void System::enableUARTBuffer(void (*ISR)(void))
+{
+    /*
+     * Send the debug values via a ring buffer drained by the transmit
+     * interrupt of UART0 (see UARTBuffer.h) instead of waiting for the
+     * UART. Sending a frame or line then only costs a memcpy; if the buffer
+     * is full the data is dropped and counted (see
+     * System::getUARTOverflows). Lost binary frames are detected by the
+     * decoder via their sequence numbers.
+     * Example (main.cpp):
+     *     void uartISR() { sys.handleUARTInterrupt(); }
+     *     ...
+     *     sys.init(CFG_SYS_FREQ);
+     *     sys.enableUARTBuffer(uartISR);
+     *
+     * ISR: Interrupt handler of UART0. It must call
+     *      System::handleUARTInterrupt.
+     */
+
+    uartBuffer.init(UART0_BASE, ISR);
+    uartBuffered = true;
+}
+
+void System::handleUARTInterrupt()
+{
+    /*
+     * Refill the UART's FIFO from the buffer (see System::enableUARTBuffer).
+     */
+
+    uartBuffer.handleInterrupt();
+}
+
+uint32_t System::getUARTOverflows()
+{
+    /*
+     * Returns the number of debug frames or lines dropped because the UART
+     * buffer was full (see System::enableUARTBuffer).
+     */
+
+    return uartBuffer.getOverflows();
+}
+
+UARTBuffer *System::getUARTBuffer()
+{
+    /*
+     * Returns the transmit buffer of UART0 for other binary output sent
+     * instead of the debug values (f.ex. the ride log), or 0 if it isn't
+     * enabled (see System::enableUARTBuffer).
+     */
+
+    return uartBuffered ? &uartBuffer : 0;
+}
+
+void System::setProfiling(bool enabled)
+{
+    /*
+     * Enable or disable the profiling probes (see System::addProbe). By
+     * default profiling is disabled and the probes cost nothing but a check
+     * of this flag.
+     */
+
+    profilingEnabled = enabled;
+}
+
+bool System::getProfiling()
+{
+    return profilingEnabled;
+}
+
+uint8_t System::addProbe(const char *name)
+{
+    /*
+     * Register a profiling probe and return its number. Probes measure the
+     * execution time of a code section in clock cycles with the cycle
+     * counter (see System::getCycles), usually with a ProbeScope (see
+     * System.h). For each probe the number of measurements, minimum, mean
+     * and maximum as well as a histogram with power of 2 bins are kept.
+     * The statistics are sent by System::sendProbes.
+     * Registering a name again returns the existing probe, hence several
+     * instances of a class can share one.
+     * Note: On the host (see Host_Tools) the cycle counter is the virtual
+     *       one, i.e. only the time spent waiting for the emulated
+     *       peripherals is counted.
+     *
+     * name: String shown in the output of System::sendProbes. Must not
+     *       contain "\t" or "\n".
+     */
+
+    for (uint_fast8_t i = 0; i < probeCount; i++)
+    {
+        if (!strcmp(probes[i].name, name))
+        {
+            return i;
+        }
+    }
+
+    if (probeCount >= maxProbes)
+    {
+        error(SysTooManyProbes, (void *) name);
+    }
+
+    probes[probeCount].name = name;
+    clearProbe(probes[probeCount]);
+    return probeCount++;
+}
+
+void System::recordProbe(uint8_t probe, uint32_t cycles)
+{
+    /*
+     * Add a measurement to the statistics of the given probe. Usually
+     * called by ProbeScope.
+     *
+     * probe:  Number returned by System::addProbe.
+     * cycles: Measured execution time in clock cycles.
+     */
+
+    Probe &p = probes[probe];
+
+    p.count++;
+    p.totalCycles += cycles;
+    if (cycles < p.minCycles)
+    {
+        p.minCycles = cycles;
+    }
+    if (cycles > p.maxCycles)
+    {
+        p.maxCycles = cycles;
+    }
+
+    // Index of the highest bit set (binary search). 0 and 1 go to bin 0.
+    uint_fast8_t bin = 0;
+    for (uint_fast8_t shift = 16; shift; shift >>= 1)
+    {
+        if (cycles >> shift)
+        {
+            cycles >>= shift;
+            bin += shift;
+        }
+    }
+    p.histogram[bin]++;
+}
+
+void System::resetProbes()
+{
+    /*
+     * Clear the statistics of all probes. The probes stay registered.
+     */
+
+    for (uint_fast8_t i = 0; i < probeCount; i++)
+    {
+        clearProbe(probes[i]);
+    }
+}
+
+void System::clearProbe(Probe &p)
+{
+    p.count = 0;
+    p.totalCycles = 0;
+    p.minCycles = UINT32_MAX;
+    p.maxCycles = 0;
+    for (uint_fast8_t bin = 0; bin < PROBE_BINS; bin++)
+    {
+        p.histogram[bin] = 0;
+    }
+}
+
+void System::sendProbes()
+{
+    /*
+     * Start sending the statistics of all probes via UART (independently of
+     * System::setDebugging). All times are in clock cycles. Format:
+     *     Probe\tCount\tMin\tMean\tMax\tHistogram\n
+     *     Name\tCount\tMin\tMean\tMax\tBin:Count Bin:Count ...\n
+     *     ...
+     * Only non-empty bins are listed; bin i counts the measurements from
+     * 2^i to 2^(i+1)-1 cycles.
+     * With the UART buffer (see System::enableUARTBuffer) only the lines it
+     * has space for are queued, System::handleRequests sends the others
+     * with its next calls. Then this costs no more than a debug frame per
+     * line and can be requested while driving. Without the buffer this
+     * waits until all lines are sent (about 25ms for the probes of the
+     * segway at 115200 baud).
+     */
+
+    probeLine = 0;
+    sendProbeLines();
+}
+
+bool System::isSendingProbes()
+{
+    /*
+     * Returns true while the lines of System::sendProbes are being sent.
+     */
+
+    return probeLine >= 0;
+}
+
+void System::sendProbeLines()
+{
+    /*
+     * Send the next lines of the report started by System::sendProbes. Each
+     * line is assembled in debugFrame and queued only as a whole. Stops if
+     * the UART buffer has no space for it.
+     */
+
+    while (probeLine >= 0)
+    {
+        debugFrameLength = 0;
+        if (probeLine == 0)
+        {
+            const char *titles = "Probe\tCount\tMin\tMean\tMax\tHistogram";
+            addDebugFrameBytes(titles, strlen(titles));
+        }
+        else
+        {
+            Probe &p = probes[probeLine - 1];
+            addDebugFrameBytes(p.name, strlen(p.name));
+            addDebugFrameBytes("\t", 1);
+            addDebugTextUInt(p.count);
+            if (p.count)
             {
-                UARTprintf("%04d\t", debugVals[i]);
+                addDebugFrameBytes("\t", 1);
+                addDebugTextUInt(p.minCycles);
+                addDebugFrameBytes("\t", 1);
+                addDebugTextUInt((uint32_t) (p.totalCycles / p.count));
+                addDebugFrameBytes("\t", 1);
+                addDebugTextUInt(p.maxCycles);
+                addDebugFrameBytes("\t", 1);
+                for (uint_fast8_t bin = 0; bin < PROBE_BINS; bin++)
+                {
+                    if (p.histogram[bin])
+                    {
+                        addDebugTextUInt(bin);
+                        addDebugFrameBytes(":", 1);
+                        addDebugTextUInt(p.histogram[bin]);
+                        addDebugFrameBytes(" ", 1);
+                    }
+                }
             }
         }
-        UARTprintf("\n");
-        
+        addDebugFrameBytes("\n", 1);
+
+        // Try again with the next call rather than counting an overflow.
+        if (uartBuffered && uartBuffer.getFree() < debugFrameLength)
+        {
+            return;
+        }
+        sendDebugOutput(true);
+
+        probeLine++;
+        if (probeLine > probeCount)
+        {
+            probeLine = -1;
+        }
+    }
+}
+
+void System::handleRequests()
+{
+    /*
+     * Handle the commands received via UART (Serial Monitor):
+     *     p: send the statistics of all probes (see System::sendProbes)
+     *     r: reset them (see System::resetProbes)
+     *     b: send the black box (see System::setFlightRecorder)
+     *     a: rearm the black box after it has been frozen
+     * Doesn't wait for input, hence it can be called periodically, f.ex.
+     * together with System::sendDebugVals. The statistics and a dump of the
+     * black box are sent in parts by the following calls if the UART buffer
+     * is enabled (see System::enableUARTBuffer), else at once (about 25ms
+     * and 0.5s).
+     */
+
+    int32_t c;
+    while ((c = UARTCharGetNonBlocking(UART0_BASE)) >= 0)
+    {
+        if (c == 'p' && !isSendingProbes())
+        {
+            sendProbes();
+        }
+        else if (c == 'r')
+        {
+            resetProbes();
+        }
+        else if (c == 'b' && flightRecorder && !flightRecorder->isDumping())
+        {
+            flightRecorder->startDump(getCycles());
+        }
+        else if (c == 'a' && flightRecorder && !flightRecorder->isDumping())
+        {
+            flightRecorder->rearm();
+        }
+    }
+
+    if (isSendingProbes())
+    {
+        sendProbeLines();
+    }
+    if (flightRecorder && flightRecorder->isDumping())
+    {
+        flightRecorder->sendDump(getUARTBuffer(), UART0_BASE);
     }
 }
+
+void System::setFlightRecorder(FlightRecorder *recorder)
+{
+    /*
+     * Use the given black box: it's frozen by System::error and sent on
+     * request (see System::handleRequests). The owner adds the records.
+     * Example (Segway::init):
+     *     recorder.init(sys->getClockFreq(), CFG_CTLR_UPDATE_FREQ);
+     *     sys->setFlightRecorder(&recorder);
+     */
+
+    flightRecorder = recorder;
+}
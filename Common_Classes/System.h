@@ -14,6 +14,7 @@
 /*
  * stdbool.h:               Boolean definitions for the C99 standard
  * stdint.h:                Variable definitions for the C99 standard
+ * string.h:                strcmp for the names of the profiling probes.
  * inc/hw_types.h:          Macros for hardware access, both direct and via the
  *                          bit-band region.
  * inc/hw_memmap.h:         Macros defining the memory map of the Tiva C Series
@@ -31,12 +32,19 @@
  *                          routines.
  * driverlib/gpio.h:        Defines and macros for GPIO API of DriverLib. This
  *                          includes API functions such as GPIOPinWrite.
+ * driverlib/uart.h:        Defines and macros for the UART API of DriverLib.
+ *                          This includes API functions such as
+ *                          UARTCharGetNonBlocking.
  * uartstdio.h:             Utility driver to provide simple UART console
  *                          functions.
  * ErrorCodes.h:            Enum with error codes for the error method.
+ * DebugFrame.h:            Binary format of the debug values.
+ * UARTBuffer.h:            Interrupt driven transmit buffer of the UART.
+ * FlightRecorder.h:        Black box frozen by System::error.
  */
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #include "inc/hw_types.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_gpio.h"
@@ -45,8 +53,12 @@
 #include "driverlib/interrupt.h"
 #include "driverlib/fpu.h"
 #include "driverlib/gpio.h"
+#include "driverlib/uart.h"
 #include "uartstdio.h"
 #include "ErrorCodes.h"
+#include "DebugFrame.h"
+#include "UARTBuffer.h"
+#include "FlightRecorder.h"
 
 
 class System
@@ -65,31 +77,118 @@ public:
     uint32_t getPWMClockDiv();
     void delayCycles(uint32_t cycles);
     void delayUS(uint32_t us);
+    uint32_t getCycles();
+    uint32_t getDeadlineUS(uint32_t us);
+    bool deadlinePassed(uint32_t deadline);
     void setDebugging(bool debug);
+    void setDebugBinary(bool binary);
+    uint8_t addDebugChannel(const char *name,
+                            uint8_t type = DEBUGFRAME_INT32,
+                            uint32_t decimation = 1);
+    void setDebugVal(uint8_t channel, int32_t value);
+    void setDebugValFloat(uint8_t channel, float value);
     void setDebugVal(const char* name, int32_t value);
+    void setDebugValFloat(const char* name, float value);
     void sendDebugVals();
+    void enableUARTBuffer(void (*ISR)(void));
+    void handleUARTInterrupt();
+    uint32_t getUARTOverflows();
+    UARTBuffer *getUARTBuffer();
+    void setProfiling(bool enabled);
+    bool getProfiling();
+    uint8_t addProbe(const char *name);
+    void recordProbe(uint8_t probe, uint32_t cycles);
+    void resetProbes();
+    void sendProbes();
+    bool isSendingProbes();
+    void setFlightRecorder(FlightRecorder *recorder);
+    void handleRequests();
+
+    const static uint8_t PROBE_BINS = 32;
+    const static uint8_t MAX_DEBUG_CHANNELS = DEBUGFRAME_MAX_CHANNELS;
+    const static uint8_t NO_DEBUG_CHANNEL = 0xff;
 
 private:
+    void initUART();
+    void sendDebugText();
+    void addDebugTextInt(int32_t value);
+    void addDebugTextUInt(uint32_t value);
+    void sendDebugFrames();
+    void beginDebugFrame();
+    void addDebugFrameBytes(const void *data, uint32_t length);
+    bool sendDebugFrame(uint8_t type, uint32_t mask);
+    bool sendDebugOutput(bool text);
+    void sendProbeLines();
+
     bool debugEnabled = true;
+    bool debugBinary = false;
     bool debugNewLabel = false;
-    const static uint32_t maxDebugVals = 8;
-    const char debugUnused[1] = "";
-    int32_t debugVals[maxDebugVals];
-    const char* debugNames[maxDebugVals] = {
-        debugUnused,
-        debugUnused,
-        debugUnused,
-        debugUnused,
-        debugUnused,
-        debugUnused,
-        debugUnused,
-        debugUnused
+    union DebugVal
+    {
+        int32_t i;
+        float f;
+    };
+    // Channel registered with System::addDebugChannel
+    struct DebugChannel
+    {
+        const char *name;
+        DebugVal value;
+        uint8_t type;           // DEBUGFRAME_INT32 or _FLOAT
+        uint16_t decimation;    // sent in every decimation-th frame
+        uint16_t countdown;     // frames until it's sent again
     };
+    DebugChannel debugChannels[MAX_DEBUG_CHANNELS];
+    uint8_t debugChannelCount = 0;
     bool tooManyDebugVals = false;
 
+    // Frame or text line being assembled (see System::setDebugBinary).
+    // Large enough for the schema of all channels with names of up to 27
+    // characters.
+    const static uint32_t DEBUG_FRAME_SIZE = 1024;
+    uint8_t debugFrame[DEBUG_FRAME_SIZE];
+    uint32_t debugFrameLength = 0;
+    uint8_t debugFrameSequence = 0;
+
+    // Transmit buffer of UART0 (see System::enableUARTBuffer)
+    UARTBuffer uartBuffer;
+    bool uartBuffered = false;
+
+    // Black box (see System::setFlightRecorder)
+    FlightRecorder *flightRecorder = 0;
+
+    // Statistics of a profiling probe (see System::addProbe).
+    struct Probe
+    {
+        const char *name;
+        uint32_t count;
+        uint64_t totalCycles;
+        uint32_t minCycles;
+        uint32_t maxCycles;
+        uint32_t histogram[PROBE_BINS]; // bin i: 2^i <= cycles < 2^(i+1)
+    };
+    bool profilingEnabled = false;
+    const static uint8_t maxProbes = 16;
+    Probe probes[maxProbes];
+    uint8_t probeCount = 0;
+    void clearProbe(Probe &p);
+
+    // Next line of the report being sent (0: the column titles, i + 1:
+    // probe i), -1 if none (see System::sendProbes).
+    int16_t probeLine = -1;
+
     uint32_t clockFrequency = 0;
+    uint32_t cyclesPerUS = 0;
     uint32_t pwmClockDiv = 0;
 
+    // Registers of the cycle counter of the Data Watchpoint and Trace unit
+    // (DWT) and the bits enabling it (ARMv7-M Architecture Reference Manual
+    // C1.6.5 and C1.8.7).
+    const uint32_t DEMCR_REG      = 0xe000edfc;
+    const uint32_t DEMCR_TRCENA   = 0x01000000;
+    const uint32_t DWT_CTRL_REG   = 0xe0001000;
+    const uint32_t DWT_CYCCNTENA  = 0x00000001;
+    const uint32_t DWT_CYCCNT_REG = 0xe0001004;
+
     // All PWM Clock dividors
     const uint32_t PWM_CLOCK_DIV_COUNT = 8;
     const uint32_t PWM_CLOCK_DIV_MAPPING[8] = {
@@ -158,4 +257,45 @@ private:
 };
 
 
+class ProbeScope
+{
+    /*
+     * Measures the cycles from its construction to the end of the enclosing
+     * scope and records them in the given probe (see System::addProbe).
+     * Example:
+     *     void Foo::update()
+     *     {
+     *         ProbeScope probe(sys, updateProbe);
+     *         ...
+     *     }
+     * Costs only a check of System::getProfiling if profiling is disabled.
+     */
+public:
+    ProbeScope(System *sys, uint8_t probe)
+    {
+        this->sys = sys;
+        this->probe = probe;
+        active = sys->getProfiling();
+        if (active)
+        {
+            start = sys->getCycles();
+        }
+    }
+
+    ~ProbeScope()
+    {
+        if (active)
+        {
+            sys->recordProbe(probe, sys->getCycles() - start);
+        }
+    }
+
+private:
+    System *sys;
+    uint8_t probe;
+    bool active;
+    uint32_t start = 0;
+};
+
+
 #endif /* SYSTEM_H_ */
@@ -0,0 +1,182 @@
+/*
+ * UARTBuffer.cpp
+ *
+ * Transmit ring buffer of a UART drained by its transmit interrupt (see
+ * UARTBuffer.h).
+ */
+
+#include "UARTBuffer.h"
+
+
+static inline void dataMemoryBarrier()
+{
+    /*
+     * Complete all memory accesses before the following ones (DMB, like
+     * __DMB of CMSIS, which isn't part of TivaWare). The host tools are
+     * built with the compiler of the PC.
+     */
+
+#if defined(__TI_ARM__) || defined(__ICCARM__)
+    __asm(" dmb");
+#elif defined(__arm__)
+    __asm volatile (" dmb" : : : "memory");
+#else
+    __sync_synchronize();
+#endif
+}
+
+UARTBuffer::UARTBuffer()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+UARTBuffer::~UARTBuffer()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void UARTBuffer::init(uint32_t uartBase, void (*ISR)(void))
+{
+    /*
+     * Enable the transmit interrupt of the UART. It's raised when the
+     * transmit FIFO drops to 1/8 (2 of 16 bytes), so it's refilled before
+     * it runs empty and the UART sends without gaps.
+     *
+     * uartBase: UART to send with, f.ex. UART0_BASE.
+     * ISR:      Interrupt handler of the UART. It must call
+     *           UARTBuffer::handleInterrupt.
+     */
+
+    this->uartBase = uartBase;
+    head = 0;
+    tail = 0;
+    overflows = 0;
+
+    UARTFIFOLevelSet(uartBase, UART_FIFO_TX1_8, UART_FIFO_RX1_8);
+    UARTTxIntModeSet(uartBase, UART_TXINT_MODE_FIFO);
+    UARTIntRegister(uartBase, ISR);
+    UARTIntClear(uartBase, UART_INT_TX);
+    UARTIntEnable(uartBase, UART_INT_TX);
+    initialized = true;
+}
+
+bool UARTBuffer::write(const void *data, uint32_t length)
+{
+    /*
+     * Queue the given bytes for transmission. Either all of them are queued
+     * or, if there's not enough space, none (a partial debug frame or line
+     * would only corrupt the next one). Returns false in that case.
+     * Costs a memcpy and, if the UART is idle, putting the first bytes into
+     * its FIFO. Never waits for the UART.
+     */
+
+    if (!initialized)
+    {
+        return false;
+    }
+
+    uint32_t start = head;
+    if (length > SIZE - (start - tail))
+    {
+        overflows++;
+        return false;
+    }
+
+    // Copy in up to two parts if the data wraps around the end.
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint32_t index = start & (SIZE - 1);
+    uint32_t first = SIZE - index;
+    if (first > length)
+    {
+        first = length;
+    }
+    memcpy(&buffer[index], bytes, first);
+    memcpy(buffer, bytes + first, length - first);
+
+    // The data must be in the buffer before the consumer sees the new head.
+    dataMemoryBarrier();
+    head = start + length;
+
+    /*
+     * The interrupt is only raised when the FIFO level drops. If the UART is
+     * idle the first bytes have to be put into the FIFO here. The interrupt
+     * is disabled meanwhile so only one consumer runs at a time.
+     */
+    UARTIntDisable(uartBase, UART_INT_TX);
+    fill();
+    UARTIntEnable(uartBase, UART_INT_TX);
+    return true;
+}
+
+void UARTBuffer::handleInterrupt()
+{
+    /*
+     * Refill the transmit FIFO. Called by the interrupt handler of the UART
+     * (see UARTBuffer::init).
+     */
+
+    UARTIntClear(uartBase, UART_INT_TX);
+    fill();
+}
+
+void UARTBuffer::fill()
+{
+    /*
+     * Move bytes from the buffer into the transmit FIFO until one of them is
+     * full or empty.
+     */
+
+    uint32_t index = tail;
+    uint32_t end = head;
+    while (index != end
+           && UARTCharPutNonBlocking(uartBase, buffer[index & (SIZE - 1)]))
+    {
+        index++;
+    }
+    tail = index;
+}
+
+bool UARTBuffer::flush(uint32_t timeoutCycles)
+{
+    /*
+     * Wait until all queued bytes have been sent, f.ex. before sending
+     * something directly with UARTprintf. Needs the interrupt to be enabled,
+     * without it (f.ex. in System::error) it gives up after the timeout.
+     * Returns false in that case. The full buffer takes about 90ms at 115200
+     * baud.
+     *
+     * timeoutCycles: Maximum time to wait in clock cycles.
+     */
+
+    uint32_t start = HWREG(DWT_CYCCNT_REG);
+    while (initialized && (head != tail || UARTBusy(uartBase)))
+    {
+        if (HWREG(DWT_CYCCNT_REG) - start > timeoutCycles)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t UARTBuffer::getFree()
+{
+    /*
+     * Returns the number of bytes that can be written without overflow.
+     */
+
+    return SIZE - (head - tail);
+}
+
+uint32_t UARTBuffer::getOverflows()
+{
+    /*
+     * Returns the number of writes dropped because the buffer was full.
+     */
+
+    return overflows;
+}
@@ -0,0 +1,74 @@
+/*
+ * UARTBuffer.h
+ *
+ * Transmit ring buffer of a UART, drained by its transmit interrupt. Writing
+ * only copies the bytes into the buffer and never waits for the UART; if
+ * there's not enough space the data is dropped and counted (see
+ * UARTBuffer::getOverflows).
+ * There must be only one producer (the main loop or one interrupt) and the
+ * transmit interrupt is the only consumer. Both share nothing but the head
+ * and tail indices, each written by one side only, hence no lock is needed.
+ * If the producer is an interrupt, it must not preempt the one of the UART
+ * (give the UART interrupt the higher priority).
+ * Example (main.cpp):
+ *     void uartISR() { uartBuffer.handleInterrupt(); }
+ *     ...
+ *     uartBuffer.init(UART0_BASE, uartISR);
+ *     uartBuffer.write(data, length);
+ * The UART must already be configured (System::init configures UART0).
+ */
+
+#ifndef UARTBUFFER_H_
+#define UARTBUFFER_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * string.h:                memcpy to fill the buffer.
+ * inc/hw_types.h:          Macros for hardware access.
+ * inc/hw_memmap.h:         Base addresses of the UARTs.
+ * driverlib/uart.h:        UART API of DriverLib (FIFO and interrupts).
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "inc/hw_types.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/uart.h"
+
+
+class UARTBuffer
+{
+public:
+    UARTBuffer();
+    virtual ~UARTBuffer();
+    void init(uint32_t uartBase, void (*ISR)(void));
+    bool write(const void *data, uint32_t length);
+    void handleInterrupt();
+    bool flush(uint32_t timeoutCycles);
+    uint32_t getFree();
+    uint32_t getOverflows();
+
+    // Must be a power of 2 (the indices are masked).
+    const static uint32_t SIZE = 1024;
+
+private:
+    void fill();
+
+    // Cycle counter of the Data Watchpoint and Trace unit, enabled by
+    // System::init (see System::getCycles).
+    const uint32_t DWT_CYCCNT_REG = 0xe0001004;
+
+    uint32_t uartBase = 0;
+    bool initialized = false;
+    uint8_t buffer[SIZE];
+
+    // Free running indices; only the producer writes head, only the
+    // consumer writes tail. head - tail bytes are waiting.
+    volatile uint32_t head = 0;
+    volatile uint32_t tail = 0;
+    uint32_t overflows = 0;     // writes dropped because the buffer was full
+};
+
+#endif /* UARTBUFFER_H_ */
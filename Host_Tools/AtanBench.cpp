@@ -0,0 +1,164 @@
+/*
+ * AtanBench.cpp
+ *
+ * Compares fastAtan2 (see FastMath.h) with atan2f of the C library:
+ *  - accuracy over the whole circle and in the working range of the
+ *    controller (tilt up to 30deg, accelerations from 0.5g to 1.5g with
+ *    noise), as floats in g and as raw sensor values
+ *  - time per call on the PC
+ * The errors are measured against atan2 in double precision. The times only
+ * show the ratio between both functions; on the Cortex-M4F the difference is
+ * bigger because atan2f isn't supported by the FPU.
+ * The program returns 1 if the error exceeds the 0.1deg needed by the
+ * controller.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -ICommon_Classes Host_Tools/AtanBench.cpp \
+ *         -o AtanBench
+ *     ./AtanBench [calls for the time measurement]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "FastMath.h"
+
+
+const double RAD_TO_DEG = 180.0 / 3.14159265358979;
+const double MAX_ERROR_DEG = 0.1;   // needed by the controller
+const float LSB_PER_G = 16384.0f;   // MPU6050 at +-2g
+
+
+struct ErrorStats
+{
+    double max = 0.0;
+    double squared = 0.0;
+    uint32_t count = 0;
+};
+
+void addError(ErrorStats &stats, float y, float x, float result)
+{
+    double error = fabs(result - atan2((double) y, (double) x));
+
+    // -pi and pi are the same angle.
+    if (error > 3.14159265358979)
+    {
+        error = fabs(error - 2.0 * 3.14159265358979);
+    }
+    if (error > stats.max)
+    {
+        stats.max = error;
+    }
+    stats.squared += error * error;
+    stats.count++;
+}
+
+void printErrors(const char *name, const ErrorStats &fast,
+                 const ErrorStats &lib)
+{
+    printf("%-26s %12.6f %12.6f %12.6f %12.6f\n", name,
+           fast.max * RAD_TO_DEG, sqrt(fast.squared / fast.count) * RAD_TO_DEG,
+           lib.max * RAD_TO_DEG, sqrt(lib.squared / lib.count) * RAD_TO_DEG);
+}
+
+template <class Function>
+double measureNS(Function function, const std::vector<float> &y,
+                 const std::vector<float> &x, uint32_t calls)
+{
+    /*
+     * Returns the mean time of one call in ns. The results are summed up so
+     * that the compiler can't remove the calls.
+     */
+
+    volatile float sink = 0.0f;
+    float sum = 0.0f;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        uint32_t j = i % y.size();
+        sum += function(y[j], x[j]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    sink = sum;
+    (void) sink;
+    return std::chrono::duration<double, std::nano>(end - start).count()
+           / calls;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t calls = 10000000;
+    if (argc > 1)
+    {
+        calls = strtoul(argv[1], 0, 10);
+    }
+    if (calls == 0)
+    {
+        fprintf(stderr, "Usage: %s [calls for the time measurement]\n",
+                argv[0]);
+        return 1;
+    }
+
+    // Whole circle
+    ErrorStats circleFast, circleLib;
+    const uint32_t CIRCLE_STEPS = 1000000;
+    for (uint32_t i = 0; i <= CIRCLE_STEPS; i++)
+    {
+        double angle = -3.14159265358979
+                       + 2.0 * 3.14159265358979 * i / CIRCLE_STEPS;
+        float y = sin(angle);
+        float x = cos(angle);
+        addError(circleFast, y, x, fastAtan2(y, x));
+        addError(circleLib, y, x, atan2f(y, x));
+    }
+
+    // Working range of the controller. Same arguments as in
+    // Controller::updateValuesRad and Controller::updateValuesRaw.
+    ErrorStats gFast, gLib, rawFast, rawLib;
+    std::vector<float> benchY, benchX;
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> tiltDist(-30.0f, 30.0f);
+    std::uniform_real_distribution<float> accelDist(0.5f, 1.5f);
+    std::normal_distribution<float> noiseDist(0.0f, 0.01f);
+    for (uint32_t i = 0; i < 1000000; i++)
+    {
+        float tilt = tiltDist(random) / RAD_TO_DEG;
+        float accel = accelDist(random);
+        float accelHor = accel * sinf(tilt) + noiseDist(random);
+        float accelVer = accel * cosf(tilt) + noiseDist(random);
+        addError(gFast, -accelHor, -accelVer, fastAtan2(-accelHor, -accelVer));
+        addError(gLib, -accelHor, -accelVer, atan2f(-accelHor, -accelVer));
+
+        float rawHor = (int32_t) (accelHor * LSB_PER_G);
+        float rawVer = (int32_t) (accelVer * LSB_PER_G);
+        addError(rawFast, -rawHor, -rawVer, fastAtan2(-rawHor, -rawVer));
+        addError(rawLib, -rawHor, -rawVer, atan2f(-rawHor, -rawVer));
+
+        if (i < 4096)
+        {
+            benchY.push_back(-accelHor);
+            benchX.push_back(-accelVer);
+        }
+    }
+
+    printf("%-26s %12s %12s %12s %12s\n", "error [deg]", "fast max",
+           "fast RMS", "atan2f max", "atan2f RMS");
+    printErrors("whole circle", circleFast, circleLib);
+    printErrors("working range [g]", gFast, gLib);
+    printErrors("working range [raw]", rawFast, rawLib);
+
+    double fastNS = measureNS(fastAtan2, benchY, benchX, calls);
+    double libNS = measureNS(atan2f, benchY, benchX, calls);
+    printf("\nTime per call: fastAtan2 %.2f ns, atan2f %.2f ns (%.1fx)\n",
+           fastNS, libNS, libNS / fastNS);
+
+    double maxErrorDeg = fmax(circleFast.max, fmax(gFast.max, rawFast.max))
+                         * RAD_TO_DEG;
+    printf("Max. error of fastAtan2: %.6f deg (limit %.1f deg): %s\n",
+           maxErrorDeg, MAX_ERROR_DEG,
+           maxErrorDeg <= MAX_ERROR_DEG ? "ok" : "FAILED");
+    return maxErrorDeg <= MAX_ERROR_DEG ? 0 : 1;
+}
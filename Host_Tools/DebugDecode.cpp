@@ -0,0 +1,371 @@
+/*
+ * DebugDecode.cpp
+ *
+ * Converts the binary debug frames (see DebugFrame.h and
+ * System::setDebugBinary) captured from the USB UART to CSV or to the text
+ * format of System::sendDebugVals, which the Arduino Serial Plotter reads.
+ * Frames with a wrong CRC are skipped, lost frames are detected by their
+ * sequence numbers. A summary (frames, errors, frame rate, bytes per frame)
+ * is printed to stderr.
+ * The CSV has a column with the time in seconds (computed from the cycle
+ * counter of the microcontroller, see -c) followed by one column per
+ * channel of the schema. A new header line is written whenever the schema
+ * changes. Channels with a decimation (see System::addDebugChannel) are
+ * empty in the frames which don't contain them; the Serial Plotter format
+ * repeats their last value instead.
+ *
+ * Capture: set CFG_DEBUG_BINARY in Config.h and capture the USB UART, f.ex.
+ * on Linux:
+ *     stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > debug.bin
+ * Live plotting works by piping the capture through the decoder (-p) into
+ * a program reading the text format.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -ICommon_Classes Host_Tools/DebugDecode.cpp \
+ *         -o DebugDecode
+ *     ./DebugDecode [-p] [-c clock frequency] [capture file or - for stdin]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "DebugFrame.h"
+
+
+struct Options
+{
+    bool plotter = false;           // Serial Plotter format instead of CSV
+    double clockFreq = 40000000.0;  // CFG_SYS_FREQ
+    const char *input = "-";
+};
+
+struct Statistics
+{
+    uint64_t frames = 0;
+    uint64_t valueFrames = 0;
+    uint64_t valueBytes = 0;        // size of all value frames
+    uint64_t crcErrors = 0;
+    uint64_t skippedBytes = 0;      // outside of valid frames
+    uint64_t lostFrames = 0;        // gaps in the sequence numbers
+    double firstTime = -1.0;        // [s] of the first value frame
+    double lastTime = 0.0;          // [s] of the last one
+};
+
+
+const uint32_t MAX_PAYLOAD = 4096;  // larger lengths are invalid
+const uint32_t CRC_SIZE = 2;
+
+std::string names[DEBUGFRAME_MAX_CHANNELS];
+uint32_t schemaMask = 0;            // channels known from the schema
+bool schemaChanged = true;
+std::string lastValues[DEBUGFRAME_MAX_CHANNELS];
+
+
+bool readInput(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    uint8_t buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+    return true;
+}
+
+void decodeSchema(const DebugFrameHeader &header, const uint8_t *payload)
+{
+    /*
+     * The payload contains the type (1 byte), the decimation (2 bytes) and
+     * the name (terminated by a 0) of each channel in the mask. Only the
+     * names are needed, the value frames contain the types.
+     */
+
+    uint32_t pos = 0;
+    for (uint32_t i = 0; i < DEBUGFRAME_MAX_CHANNELS; i++)
+    {
+        if (!(header.mask & (1u << i)))
+        {
+            continue;
+        }
+        pos += 3;
+        std::string name;
+        while (pos < header.length && payload[pos])
+        {
+            name += (char) payload[pos++];
+        }
+        pos++;
+        names[i] = name;
+        lastValues[i].clear();
+    }
+    schemaMask = header.mask;
+    schemaChanged = true;
+}
+
+void printLabels(uint32_t mask, const Options &options)
+{
+    if (!options.plotter)
+    {
+        printf("time");
+    }
+    for (uint32_t i = 0; i < DEBUGFRAME_MAX_CHANNELS; i++)
+    {
+        if (!(mask & (1u << i)))
+        {
+            continue;
+        }
+        std::string name = (schemaMask & (1u << i))
+                           ? names[i] : "Channel_" + std::to_string(i);
+        printf(options.plotter ? "%s\t" : ",%s", name.c_str());
+    }
+    printf("\n");
+}
+
+bool decodeValues(const DebugFrameHeader &header, const uint8_t *payload,
+                  double time, const Options &options)
+{
+    /*
+     * The payload contains the types of the channels in the mask (2 bits
+     * each) followed by their values. Returns false if the payload doesn't
+     * match the mask.
+     * The columns are the channels of the schema (or those of the frame if
+     * the schema hasn't been received).
+     */
+
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < DEBUGFRAME_MAX_CHANNELS; i++)
+    {
+        count += (header.mask >> i) & 1;
+    }
+    const uint8_t *types = payload;
+    uint32_t pos = (count + 3) / 4;
+    if (pos > header.length)
+    {
+        return false;
+    }
+
+    std::string values[DEBUGFRAME_MAX_CHANNELS];
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < DEBUGFRAME_MAX_CHANNELS; i++)
+    {
+        if (!(header.mask & (1u << i)))
+        {
+            continue;
+        }
+        uint8_t type = (types[n / 4] >> (2 * (n % 4))) & 3;
+        uint32_t size = (type == DEBUGFRAME_INT16) ? 2 : 4;
+        if (pos + size > header.length)
+        {
+            return false;
+        }
+
+        char text[32];
+        if (type == DEBUGFRAME_INT16)
+        {
+            int16_t value;
+            memcpy(&value, payload + pos, 2);
+            snprintf(text, sizeof(text), options.plotter ? "%04d" : "%d",
+                     value);
+        }
+        else if (type == DEBUGFRAME_INT32)
+        {
+            int32_t value;
+            memcpy(&value, payload + pos, 4);
+            snprintf(text, sizeof(text), options.plotter ? "%04d" : "%d",
+                     value);
+        }
+        else
+        {
+            float value;
+            memcpy(&value, payload + pos, 4);
+            snprintf(text, sizeof(text), "%g", value);
+        }
+        values[i] = text;
+        lastValues[i] = text;
+        pos += size;
+        n++;
+    }
+
+    static uint32_t printedMask = 0;
+    uint32_t columns = schemaMask ? schemaMask : header.mask;
+    if (schemaChanged || columns != printedMask)
+    {
+        printLabels(columns, options);
+        printedMask = columns;
+        schemaChanged = false;
+    }
+
+    if (!options.plotter)
+    {
+        printf("%.6f", time);
+    }
+    for (uint32_t i = 0; i < DEBUGFRAME_MAX_CHANNELS; i++)
+    {
+        if (!(columns & (1u << i)))
+        {
+            continue;
+        }
+        if (options.plotter)
+        {
+            printf("%s\t", lastValues[i].empty() ? "0"
+                                                 : lastValues[i].c_str());
+        }
+        else
+        {
+            printf(",%s", values[i].c_str());
+        }
+    }
+    printf("\n");
+    return true;
+}
+
+void decode(const std::vector<uint8_t> &data, const Options &options,
+            Statistics &stats)
+{
+    /*
+     * Find the frames by their sync word and check their CRC. On errors
+     * the search continues one byte after the sync word.
+     */
+
+    uint64_t cycles = 0;
+    uint32_t lastCycles = 0;
+    int lastSequence = -1;
+
+    size_t pos = 0;
+    while (pos + DEBUGFRAME_HEADER_SIZE + CRC_SIZE <= data.size())
+    {
+        DebugFrameHeader header;
+        memcpy(&header, &data[pos], DEBUGFRAME_HEADER_SIZE);
+        size_t frameSize = DEBUGFRAME_HEADER_SIZE + header.length + CRC_SIZE;
+
+        if (header.sync != DEBUGFRAME_SYNC || header.length > MAX_PAYLOAD)
+        {
+            pos++;
+            stats.skippedBytes++;
+            continue;
+        }
+        if (pos + frameSize > data.size())
+        {
+            // Capture ended in the middle of the frame.
+            break;
+        }
+
+        uint16_t crc;
+        memcpy(&crc, &data[pos + frameSize - CRC_SIZE], CRC_SIZE);
+        if (crc != debugFrameCRC(0xffff, &data[pos], frameSize - CRC_SIZE))
+        {
+            stats.crcErrors++;
+            pos++;
+            stats.skippedBytes++;
+            continue;
+        }
+
+        // Sequence numbers and the cycle counter wrap around.
+        if (lastSequence >= 0)
+        {
+            stats.lostFrames += (uint8_t) (header.sequence - lastSequence - 1);
+            cycles += header.cycles - lastCycles;
+        }
+        lastSequence = header.sequence;
+        lastCycles = header.cycles;
+        double time = cycles / options.clockFreq;
+        stats.frames++;
+
+        const uint8_t *payload = &data[pos + DEBUGFRAME_HEADER_SIZE];
+        if (header.type == DEBUGFRAME_SCHEMA)
+        {
+            decodeSchema(header, payload);
+        }
+        else if (header.type == DEBUGFRAME_VALUES)
+        {
+            if (!decodeValues(header, payload, time, options))
+            {
+                fprintf(stderr, "Frame %u: payload doesn't match the "
+                        "channels\n", header.sequence);
+            }
+            if (stats.firstTime < 0.0)
+            {
+                stats.firstTime = time;
+            }
+            stats.lastTime = time;
+            stats.valueFrames++;
+            stats.valueBytes += frameSize;
+        }
+        pos += frameSize;
+    }
+    stats.skippedBytes += data.size() - pos;
+}
+
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-p"))
+        {
+            options.plotter = true;
+        }
+        else if (!strcmp(argv[i], "-c") && i + 1 < argc)
+        {
+            options.clockFreq = atof(argv[++i]);
+        }
+        else if (argv[i][0] == '-' && argv[i][1])
+        {
+            fprintf(stderr, "Usage: %s [-p] [-c clock frequency] "
+                    "[capture file or - for stdin]\n", argv[0]);
+            return 2;
+        }
+        else
+        {
+            options.input = argv[i];
+        }
+    }
+
+    std::vector<uint8_t> data;
+    if (!readInput(options.input, data))
+    {
+        return 2;
+    }
+
+    Statistics stats;
+    decode(data, options, stats);
+
+    fprintf(stderr, "Frames:        %llu (%llu with values)\n",
+            (unsigned long long) stats.frames,
+            (unsigned long long) stats.valueFrames);
+    fprintf(stderr, "Errors:        %llu CRC, %llu frames lost, "
+            "%llu bytes skipped\n", (unsigned long long) stats.crcErrors,
+            (unsigned long long) stats.lostFrames,
+            (unsigned long long) stats.skippedBytes);
+    if (stats.valueFrames)
+    {
+        fprintf(stderr, "Frame size:    %.1f bytes\n",
+                (double) stats.valueBytes / stats.valueFrames);
+    }
+    // The rate needs at least two value frames.
+    double duration = stats.lastTime - stats.firstTime;
+    if (stats.valueFrames > 1 && stats.firstTime >= 0.0 && duration > 0.0)
+    {
+        fprintf(stderr, "Frame rate:    %.1f Hz\n",
+                (stats.valueFrames - 1) / duration);
+    }
+    else
+    {
+        fprintf(stderr, "Frame rate:    n/a\n");
+    }
+
+    return (stats.crcErrors || stats.lostFrames) ? 1 : 0;
+}
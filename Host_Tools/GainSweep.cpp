@@ -0,0 +1,730 @@
+/*
+ * GainSweep.cpp
+ *
+ * Searches the gains of the controller (see Controller::updateValues) by
+ * running closed loop simulations for each combination of the factors in
+ * GAIN_FACTORS, which scale the gains configured in Config.h. Each set of
+ * gains is simulated with the same SEED_COUNT seeds of the sensor noise.
+ * A simulation starts upright, is pushed after PUSH_TIME and is scored by:
+ *  - settle time: time after the push until the tilt stays within
+ *    SETTLE_TILT of 0 up to the end of the simulation (the whole time
+ *    after the push if it keeps oscillating by more)
+ *  - overshoot:   largest tilt in the opposite direction of the first
+ *    deflection
+ *  - saturation:  share of the time a duty cycle is at CFG_CTLR_MAXDUTY
+ *  - energy:      energy taken from the battery
+ * A set gets the worst of each score over its seeds; sets with which the
+ * segway fell with any seed are discarded. The sets which aren't worse
+ * than any other set in all four scores (Pareto set) are sorted by the sum
+ * of their scores normalized to the range of the Pareto set.
+ * A single noise sequence can make a set look much better than it is,
+ * therefore each set of the Pareto set is checked in the balance, push and
+ * drive scenarios of SegwaySim.cpp with CHECK_SEED_COUNT seeds. The sets
+ * with which the segway never fell are written to a generated header. The
+ * first one is the recommended compromise; the build options to confirm
+ * it in SegwaySim are printed.
+ *
+ * The simulations run in parallel on all cores. Each thread simulates
+ * independently with its own model, controller and sensor noise (seeded
+ * per run), so the result doesn't depend on the number of threads. The
+ * runs are distributed to the threads in blocks; a thread which finished
+ * its block steals runs from the others (runs which fall end early, so the
+ * blocks take different times).
+ * As the emulated hardware (HostHardware, HostDriverlib) exists only once,
+ * the controller is fed directly from the model (see SegwaySim.cpp for the
+ * simulation of the complete Segway class): the MPU6050 is replaced by the
+ * true angle rate and accelerations with noise and its low pass filter
+ * (CFG_SENSOR_LOW_PASS, if enabled), the PWM by the dead band of PWM::setDuty.
+ * The update frequency and the estimator are taken from Config.h like on
+ * the microcontroller.
+ *
+ * Build and run from the repository root (the controller's templates are
+ * compiled in this file, therefore Controller.cpp and Estimator.cpp must
+ * not be linked; -DTIVSEG or -DMINISEG overrides the device of Config.h):
+ *     g++ -std=c++11 -O2 -pthread -IHost_Tools -IHost_Tools/TivaWare \
+ *         -ICommon_Classes Host_Tools/GainSweep.cpp \
+ *         Host_Tools/SegwayModel.cpp Host_Tools/HostHardware.cpp \
+ *         Host_Tools/HostDriverlib.cpp Common_Classes/System.cpp \
+ *         Common_Classes/UARTBuffer.cpp Common_Classes/FlightRecorder.cpp \
+ *         -o GainSweep
+ *     ./GainSweep [output header] [threads]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+#include "SegwayModel.h"
+#include "Config.h"
+#include "System.h"
+
+// Template definitions of the controller and the estimators, needed to
+// compile them for TunedParams.
+#include "Controller.cpp"
+#include "Estimator.cpp"
+
+
+// Gains of the controller which are varied (see Config.h).
+struct Gains
+{
+    float angle;            // CFG_CTLR_ANGLE_GAIN
+    float rate;             // CFG_CTLR_RATE_GAIN
+    float drive;            // CFG_CTLR_DRIVE_GAIN
+    float overspeed;        // CFG_CTLR_OVERSPEED_GAIN
+    float overspeedInt;     // CFG_CTLR_OVERSPEED_INT_GAIN
+    float lowPass;          // CFG_CTLR_LOW_PASS_FACT
+};
+
+const uint8_t GAIN_COUNT = 6;
+const char *GAIN_NAMES[GAIN_COUNT] = {"ANGLE_GAIN", "RATE_GAIN",
+                                      "DRIVE_GAIN", "OVERSPEED_GAIN",
+                                      "OVERSPEED_INT_GAIN", "LOW_PASS_FACT"};
+const Gains CONFIGURED_GAINS = {CFG_CTLR_ANGLE_GAIN, CFG_CTLR_RATE_GAIN,
+                                CFG_CTLR_DRIVE_GAIN, CFG_CTLR_OVERSPEED_GAIN,
+                                CFG_CTLR_OVERSPEED_INT_GAIN,
+                                CFG_CTLR_LOW_PASS_FACT};
+
+// Factors applied to the configured gains (in the order of Gains). One
+// simulation runs for each combination.
+const std::vector<float> GAIN_FACTORS[GAIN_COUNT] = {
+    {0.4f, 0.6f, 0.8f, 1.0f, 1.25f, 1.6f, 2.0f, 2.5f},
+    {0.5f, 1.0f, 1.5f, 2.0f, 3.0f},
+    {0.5f, 1.0f, 1.5f, 2.0f},
+    {0.5f, 1.0f},
+    {0.5f, 1.0f},
+    {0.5f, 1.0f, 2.0f, 4.0f}};
+
+
+enum Scenario
+{
+    SCENARIO_PUSH,          // scored, checked
+    SCENARIO_BALANCE,       // checked (starts tilted)
+    SCENARIO_DRIVE          // checked (the rider leans forward)
+};
+
+const Scenario CHECK_SCENARIOS[] = {SCENARIO_BALANCE, SCENARIO_PUSH,
+                                    SCENARIO_DRIVE};
+
+struct Run
+{
+    uint32_t set;           // see getGains
+    Scenario scenario;
+    uint32_t seed;
+};
+
+
+struct Score
+{
+    bool fallen;
+    float settleTime;       // [s]
+    float overshoot;        // [deg]
+    float saturation;       // [%]
+    float energy;           // [J]
+};
+
+const uint8_t SCORE_COUNT = 4;
+
+
+template <class Base>
+struct TunedParams : Base
+{
+    /*
+     * Parameter set of the controller with the gains of the current
+     * simulation. Each thread runs its own simulations, therefore the gains
+     * are thread local. Everything else (update frequency, filter factor of
+     * the estimator) is inherited from the parameter set of the device.
+     */
+
+    static thread_local float ANGLE_GAIN;
+    static thread_local float RATE_GAIN;
+    static thread_local float OVERSPEED_GAIN;
+    static thread_local float OVERSPEED_INT_GAIN;
+    static thread_local float LOW_PASS_FACT;
+    static thread_local float DRIVE_ACCEL_GAIN;
+    static thread_local float DRIVE_GAIN_DT;
+
+    static void set(const Gains &gains)
+    {
+        ANGLE_GAIN = gains.angle;
+        RATE_GAIN = gains.rate;
+        OVERSPEED_GAIN = gains.overspeed;
+        OVERSPEED_INT_GAIN = gains.overspeedInt;
+        LOW_PASS_FACT = gains.lowPass;
+        DRIVE_ACCEL_GAIN = CFG_CTLR_SPEED_TO_ACCEL * gains.drive;
+        DRIVE_GAIN_DT = gains.drive * Base::DT;
+    }
+};
+
+template <class Base> thread_local float TunedParams<Base>::ANGLE_GAIN;
+template <class Base> thread_local float TunedParams<Base>::RATE_GAIN;
+template <class Base> thread_local float TunedParams<Base>::OVERSPEED_GAIN;
+template <class Base> thread_local float TunedParams<Base>::OVERSPEED_INT_GAIN;
+template <class Base> thread_local float TunedParams<Base>::LOW_PASS_FACT;
+template <class Base> thread_local float TunedParams<Base>::DRIVE_ACCEL_GAIN;
+template <class Base> thread_local float TunedParams<Base>::DRIVE_GAIN_DT;
+
+typedef TunedParams<CFG_CTLR_PARAMS> Params;
+
+
+// Simulation
+const uint32_t SEED_COUNT = 8;          // seeds 1 to SEED_COUNT per set
+const uint32_t CHECK_SEED_COUNT = 32;   // seeds 1 to CHECK_SEED_COUNT
+const double DURATION = 8.0;            // [s] scored runs
+const double CHECK_DURATION = 10.0;     // [s] checks, as in SegwaySim.cpp
+const double PUSH_TIME = 1.0;           // [s]
+const double PUSH_DURATION = 0.2;       // [s]
+const double PUSH_WEIGHT_FACT = 0.1;    // as in SegwaySim.cpp
+const double START_TILT = 1.0;          // [deg] as in SegwaySim.cpp
+const double DRIVE_START = 2.0;         // [s] as in SegwaySim.cpp
+const double DRIVE_END = 6.0;           // [s]
+const double SETTLE_TILT = 0.5;         // [deg]
+const uint32_t MODEL_STEP_US = 100;
+const uint32_t SENSOR_STEP_US = 1000;   // sample rate of the MPU6050
+const uint32_t RECORD_STEP_US = 10000;  // resolution of the settle time
+const float ANGLE_RATE_NOISE = 0.05f;   // [deg/s]
+const float ACCEL_NOISE = 0.004f;       // [g]
+const float PWM_DEAD_BAND = 0.1f;       // see PWM::setDuty
+
+// Rider of the TivSeg (as in SegwaySim.cpp)
+const double RIDER_SPEED_GAIN = 0.1;    // [rad s/m]
+const double RIDER_MAX_LEAN = 0.15;     // [rad]
+const double RIDER_TAU = 0.3;           // [s]
+
+const double DEG_TO_RAD = 3.14159265358979 / 180.0;
+
+
+class JobPool
+{
+public:
+    /*
+     * Work stealing distribution of the runs 0 to jobs - 1. Each thread
+     * owns a queue with a block of runs. It takes its runs from the back of
+     * its own queue and steals from the front of the other queues when its
+     * own is empty.
+     */
+
+    JobPool(uint32_t threads, uint32_t jobs) : queues(threads)
+    {
+        for (uint32_t job = 0; job < jobs; job++)
+        {
+            queues[(uint64_t) job * threads / jobs].jobs.push_back(job);
+        }
+    }
+
+    bool getJob(uint32_t thread, uint32_t &job)
+    {
+        /*
+         * Returns false if no runs are left.
+         */
+
+        {
+            Queue &own = queues[thread];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.jobs.empty())
+            {
+                job = own.jobs.back();
+                own.jobs.pop_back();
+                return true;
+            }
+        }
+
+        for (uint32_t i = 1; i < queues.size(); i++)
+        {
+            Queue &other = queues[(thread + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if (!other.jobs.empty())
+            {
+                job = other.jobs.front();
+                other.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<uint32_t> jobs;
+    };
+
+    std::vector<Queue> queues;
+};
+
+
+Gains getGains(uint32_t job)
+{
+    /*
+     * Returns the combination of gains of the given run.
+     */
+
+    float factors[GAIN_COUNT];
+    for (uint8_t i = 0; i < GAIN_COUNT; i++)
+    {
+        factors[i] = GAIN_FACTORS[i][job % GAIN_FACTORS[i].size()];
+        job /= GAIN_FACTORS[i].size();
+    }
+    const Gains &gains = CONFIGURED_GAINS;
+    return {gains.angle * factors[0], gains.rate * factors[1],
+            gains.drive * factors[2], gains.overspeed * factors[3],
+            gains.overspeedInt * factors[4],
+            fminf(1.0f, gains.lowPass * factors[5])};
+}
+
+float getDuty(float speed)
+{
+    return fabsf(speed) < PWM_DEAD_BAND ? 0.0f : speed;
+}
+
+Score simulate(const Gains &gains, Scenario scenario, uint32_t seed)
+{
+    /*
+     * Run one simulation with the given gains. Uses only local objects and
+     * the thread local parameter set.
+     */
+
+#ifdef TIVSEG
+    const SegwayModelParams modelParams = SegwayModelParams::tivSeg();
+    const bool hasRider = true;
+    const double driveLean = 5.0;       // [deg] as in SegwaySim.cpp
+#else
+    const SegwayModelParams modelParams = SegwayModelParams::miniSeg();
+    const bool hasRider = false;
+    const double driveLean = 1.0;       // [deg]
+#endif
+
+    Params::set(gains);
+    System sys;
+    sys.setDebugging(false);
+    Controller<Params, CFG_CTLR_ESTIMATOR> controller;
+    controller.init(&sys, CFG_CTLR_MAX_SPEED);
+
+    SegwayModel model;
+    model.init(modelParams, scenario == SCENARIO_BALANCE
+                            ? START_TILT * DEG_TO_RAD : 0.0);
+    std::mt19937 random(seed);
+    std::normal_distribution<float> rateNoise(0.0f, ANGLE_RATE_NOISE
+                                                    * DEG_TO_RAD);
+    std::normal_distribution<float> accelNoise(0.0f, ACCEL_NOISE);
+
+    // First order low pass of the MPU6050 at the sensor sample rate (none
+    // if it's disabled).
+    const float lowPass = CFG_SENSOR_LOW_PASS
+                          ? 1.0f - expf(-2.0f * 3.14159265f
+                                        * CFG_SENSOR_LOW_PASS
+                                        * SENSOR_STEP_US * 1e-6f)
+                          : 1.0f;
+    float angleRate = 0.0f, accelHor = 0.0f, accelVer = -1.0f;
+
+    const uint32_t sensorSteps = SENSOR_STEP_US / MODEL_STEP_US;
+    const uint32_t updateSteps = 1000000 / Params::UPDATE_FREQ
+                                 / MODEL_STEP_US;
+    const double dt = MODEL_STEP_US * 1e-6;
+    const uint32_t steps = (scenario == SCENARIO_PUSH ? DURATION
+                                                      : CHECK_DURATION) / dt;
+
+    Score score = {false, 0.0f, 0.0f, 0.0f, 0.0f};
+    double riderLean = 0.0, firstDeflection = 0.0;
+    uint32_t saturatedSteps = 0;
+    std::vector<float> tilts;   // after the push, every RECORD_STEP_US
+    const uint32_t recordSteps = RECORD_STEP_US / MODEL_STEP_US;
+    for (uint32_t step = 0; step < steps; step++)
+    {
+        double t = step * dt;
+        model.setPushForce((scenario == SCENARIO_PUSH && t >= PUSH_TIME
+                            && t < PUSH_TIME + PUSH_DURATION)
+                           ? PUSH_WEIGHT_FACT * modelParams.bodyMass
+                             * SegwayModel::GRAVITY
+                           : 0.0);
+        double leanTarget = (scenario == SCENARIO_DRIVE && t >= DRIVE_START
+                             && t < DRIVE_END) ? driveLean * DEG_TO_RAD
+                                               : 0.0;
+        if (hasRider)
+        {
+            leanTarget -= RIDER_SPEED_GAIN * model.getSpeed();
+            leanTarget = fmax(-RIDER_MAX_LEAN, fmin(RIDER_MAX_LEAN,
+                                                    leanTarget));
+        }
+        riderLean += (leanTarget - riderLean) * (dt / RIDER_TAU);
+        model.setRiderLean(riderLean);
+
+        // Sensor, in the units and signs of MPU6050::getAngleRate, getAccelHor
+        // and getAccelVer.
+        if (step % sensorSteps == 0)
+        {
+            angleRate += lowPass * (model.getTiltRate() + rateNoise(random)
+                                    - angleRate);
+            accelHor += lowPass * (model.getSensorAccelForward()
+                                   + accelNoise(random) - accelHor);
+            accelVer += lowPass * (-model.getSensorAccelUp()
+                                   + accelNoise(random) - accelVer);
+        }
+
+        // Controller
+        if (step % updateSteps == 0)
+        {
+            controller.updateValuesRad(0.0f, angleRate, accelHor, accelVer);
+            model.setDuties(getDuty(controller.getLeftSpeed()),
+                            getDuty(controller.getRightSpeed()));
+        }
+        model.step(dt);
+
+        if (model.hasFallen())
+        {
+            score.fallen = true;
+            return score;
+        }
+
+        // Scores
+        if (fabsf(controller.getLeftSpeed()) >= CFG_CTLR_MAXDUTY
+            || fabsf(controller.getRightSpeed()) >= CFG_CTLR_MAXDUTY)
+        {
+            saturatedSteps++;
+        }
+        if (t >= PUSH_TIME)
+        {
+            double tilt = model.getTilt() / DEG_TO_RAD;
+            if (step % recordSteps == 0)
+            {
+                tilts.push_back(tilt);
+            }
+            if (firstDeflection == 0.0)
+            {
+                if (fabs(tilt) > SETTLE_TILT)
+                {
+                    firstDeflection = tilt;
+                }
+            }
+            else if (tilt * firstDeflection < 0.0)
+            {
+                score.overshoot = fmax(score.overshoot, fabs(tilt));
+            }
+        }
+    }
+
+    // Settled after the last deviation from upright
+    for (uint32_t i = 0; i < tilts.size(); i++)
+    {
+        if (fabsf(tilts[i]) > SETTLE_TILT)
+        {
+            score.settleTime = (i + 1) * RECORD_STEP_US * 1e-6f;
+        }
+    }
+    score.saturation = 100.0f * saturatedSteps / steps;
+    score.energy = model.getEnergy();
+    return score;
+}
+
+void worker(JobPool *pool, uint32_t thread, const std::vector<Run> *runs,
+            std::vector<Score> *scores)
+{
+    /*
+     * Runs simulations until the pool is empty. Each run writes only its own
+     * element of scores.
+     */
+
+    uint32_t job;
+    while (pool->getJob(thread, job))
+    {
+        const Run &run = (*runs)[job];
+        (*scores)[job] = simulate(getGains(run.set), run.scenario, run.seed);
+    }
+}
+
+std::vector<Score> simulateAll(const std::vector<Run> &runs,
+                               uint32_t threads)
+{
+    /*
+     * Runs the simulations on the given number of threads and returns the
+     * scores in the order of runs.
+     */
+
+    std::vector<Score> scores(runs.size());
+    JobPool pool(threads, runs.size());
+    std::vector<std::thread> workers;
+    for (uint32_t thread = 0; thread < threads; thread++)
+    {
+        workers.emplace_back(worker, &pool, thread, &runs, &scores);
+    }
+    for (std::thread &thread : workers)
+    {
+        thread.join();
+    }
+    return scores;
+}
+
+Score getWorstCase(const Score *scores, uint32_t count)
+{
+    /*
+     * Returns the worst of each score over the given runs of a set.
+     */
+
+    Score worst = scores[0];
+    for (uint32_t i = 1; i < count; i++)
+    {
+        worst.fallen |= scores[i].fallen;
+        worst.settleTime = fmaxf(worst.settleTime, scores[i].settleTime);
+        worst.overshoot = fmaxf(worst.overshoot, scores[i].overshoot);
+        worst.saturation = fmaxf(worst.saturation, scores[i].saturation);
+        worst.energy = fmaxf(worst.energy, scores[i].energy);
+    }
+    return worst;
+}
+
+void getScores(const Score &score, float values[SCORE_COUNT])
+{
+    values[0] = score.settleTime;
+    values[1] = score.overshoot;
+    values[2] = score.saturation;
+    values[3] = score.energy;
+}
+
+bool dominates(const Score &a, const Score &b)
+{
+    /*
+     * Returns whether a is at least as good as b in all scores and better in
+     * at least one.
+     */
+
+    float valuesA[SCORE_COUNT], valuesB[SCORE_COUNT];
+    getScores(a, valuesA);
+    getScores(b, valuesB);
+    bool better = false;
+    for (uint8_t i = 0; i < SCORE_COUNT; i++)
+    {
+        if (valuesA[i] > valuesB[i])
+        {
+            return false;
+        }
+        better |= valuesA[i] < valuesB[i];
+    }
+    return better;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *outputPath = "TunedGains.h";
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+    {
+        outputPath = argv[1];
+    }
+    if (argc > 2)
+    {
+        threads = strtoul(argv[2], 0, 10);
+    }
+    if (threads == 0)
+    {
+        fprintf(stderr, "Usage: %s [output header] [threads]\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t sets = 1;
+    for (const std::vector<float> &factors : GAIN_FACTORS)
+    {
+        sets *= factors.size();
+    }
+    printf("%u gain sets with %u seeds, simulations of %.0fs on %u threads "
+           "(%d Hz, %s)\n", sets, SEED_COUNT, DURATION, threads,
+           Params::UPDATE_FREQ,
+#ifdef TIVSEG
+           "TivSeg");
+#else
+           "MiniSeg");
+#endif
+
+    // Simulate, the runs of each set one after the other.
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Run> runs;
+    for (uint32_t set = 0; set < sets; set++)
+    {
+        for (uint32_t seed = 1; seed <= SEED_COUNT; seed++)
+        {
+            runs.push_back({set, SCENARIO_PUSH, seed});
+        }
+    }
+    const std::vector<Score> runScores = simulateAll(runs, threads);
+    std::vector<Score> scores(sets);
+    for (uint32_t set = 0; set < sets; set++)
+    {
+        scores[set] = getWorstCase(&runScores[set * SEED_COUNT], SEED_COUNT);
+    }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start).count();
+
+    // Pareto set
+    std::vector<uint32_t> pareto;
+    uint32_t fallen = 0;
+    for (uint32_t i = 0; i < sets; i++)
+    {
+        if (scores[i].fallen)
+        {
+            fallen++;
+            continue;
+        }
+        bool dominated = false;
+        for (uint32_t j = 0; j < sets && !dominated; j++)
+        {
+            dominated = !scores[j].fallen && dominates(scores[j], scores[i]);
+        }
+        if (!dominated)
+        {
+            pareto.push_back(i);
+        }
+    }
+    printf("%.1fs (%.1f ms per simulation), %u sets fell, %u Pareto "
+           "optimal\n", seconds, 1000.0 * seconds * threads / runs.size(),
+           fallen, (uint32_t) pareto.size());
+    if (pareto.empty())
+    {
+        fprintf(stderr, "The segway fell with all sets.\n");
+        return 1;
+    }
+
+    // Sort by the sum of the normalized scores.
+    float minScores[SCORE_COUNT], maxScores[SCORE_COUNT];
+    std::fill(minScores, minScores + SCORE_COUNT, INFINITY);
+    std::fill(maxScores, maxScores + SCORE_COUNT, -INFINITY);
+    for (uint32_t set : pareto)
+    {
+        float values[SCORE_COUNT];
+        getScores(scores[set], values);
+        for (uint8_t i = 0; i < SCORE_COUNT; i++)
+        {
+            minScores[i] = fminf(minScores[i], values[i]);
+            maxScores[i] = fmaxf(maxScores[i], values[i]);
+        }
+    }
+    auto normalizedSum = [&](uint32_t set)
+    {
+        float values[SCORE_COUNT];
+        getScores(scores[set], values);
+        float sum = 0.0f;
+        for (uint8_t i = 0; i < SCORE_COUNT; i++)
+        {
+            float range = maxScores[i] - minScores[i];
+            sum += range > 0.0f ? (values[i] - minScores[i]) / range : 0.0f;
+        }
+        return sum;
+    };
+    std::stable_sort(pareto.begin(), pareto.end(),
+                     [&](uint32_t a, uint32_t b)
+                     { return normalizedSum(a) < normalizedSum(b); });
+
+    // Check the Pareto set in the scenarios of SegwaySim.cpp.
+    const uint32_t checkRuns = sizeof(CHECK_SCENARIOS)
+                               / sizeof(CHECK_SCENARIOS[0])
+                               * CHECK_SEED_COUNT;
+    runs.clear();
+    for (uint32_t set : pareto)
+    {
+        for (Scenario scenario : CHECK_SCENARIOS)
+        {
+            for (uint32_t seed = 1; seed <= CHECK_SEED_COUNT; seed++)
+            {
+                runs.push_back({set, scenario, seed});
+            }
+        }
+    }
+    const std::vector<Score> checkScores = simulateAll(runs, threads);
+    std::vector<uint32_t> checked;
+    for (uint32_t i = 0; i < pareto.size(); i++)
+    {
+        if (!getWorstCase(&checkScores[i * checkRuns], checkRuns).fallen)
+        {
+            checked.push_back(pareto[i]);
+        }
+    }
+    printf("%u passed the checks (balance, push, drive with %u seeds)\n",
+           (uint32_t) checked.size(), CHECK_SEED_COUNT);
+    if (checked.empty())
+    {
+        fprintf(stderr, "The segway fell with all Pareto optimal sets in "
+                "the checks.\n");
+        return 1;
+    }
+
+    // Generated header
+    FILE *output = fopen(outputPath, "w");
+    if (!output)
+    {
+        fprintf(stderr, "Can't write %s\n", outputPath);
+        return 1;
+    }
+    fprintf(output,
+            "/*\n"
+            " * TunedGains.h\n"
+            " *\n"
+            " * Generated by Host_Tools/GainSweep.cpp. Do not edit.\n"
+            " *\n"
+            " * Pareto optimal gains of the controller for the %s at %d Hz\n"
+            " * (%u sets with %u seeds each, %u sets fell, %u of %u Pareto\n"
+            " * optimal sets passed the checks). The first set is the\n"
+            " * recommended compromise. To use a set copy its values to the\n"
+            " * corresponding CFG_CTLR_ constants in Config.h.\n"
+            " */\n\n"
+            "#ifndef TUNEDGAINS_H_\n"
+            "#define TUNEDGAINS_H_\n\n"
+            "struct TunedGains\n"
+            "{\n",
+#ifdef TIVSEG
+            "TivSeg",
+#else
+            "MiniSeg",
+#endif
+            Params::UPDATE_FREQ, sets, SEED_COUNT, fallen,
+            (uint32_t) checked.size(), (uint32_t) pareto.size());
+    for (const char *name : GAIN_NAMES)
+    {
+        fprintf(output, "    float %s;\n", name);
+    }
+    fprintf(output,
+            "};\n\n"
+            "// Worst case of the scores: settle time [s], overshoot [deg],"
+            "\n// saturation [%%], energy [J]\n"
+            "static const TunedGains TUNED_GAINS[] = {\n");
+    printf("\n%6s %6s %6s %6s %6s %6s %10s %10s %10s %10s\n", "angle", "rate",
+           "drive", "over", "overI", "lowP", "settle [s]", "over [deg]",
+           "sat. [%]", "energy [J]");
+    for (uint32_t i = 0; i < checked.size(); i++)
+    {
+        const Gains gains = getGains(checked[i]);
+        const Score &score = scores[checked[i]];
+        fprintf(output, "    {%.2ff, %.2ff, %.2ff, %.2ff, %.2ff, %.2ff},"
+                " // %.2f, %.2f, %.1f, %.1f\n", gains.angle, gains.rate,
+                gains.drive, gains.overspeed, gains.overspeedInt,
+                gains.lowPass, score.settleTime, score.overshoot,
+                score.saturation, score.energy);
+        printf("%6.2f %6.2f %6.2f %6.2f %6.2f %6.2f %10.2f %10.2f %10.1f "
+               "%10.1f\n", gains.angle, gains.rate, gains.drive,
+               gains.overspeed, gains.overspeedInt, gains.lowPass,
+               score.settleTime, score.overshoot, score.saturation,
+               score.energy);
+    }
+    fprintf(output, "};\n\n#endif /* TUNEDGAINS_H_ */\n");
+    fclose(output);
+    printf("\nWritten to %s\n", outputPath);
+
+    // The checks use the simplified sensor and PWM of this program.
+    const Gains recommended = getGains(checked[0]);
+    const float values[GAIN_COUNT] = {recommended.angle, recommended.rate,
+                                      recommended.drive,
+                                      recommended.overspeed,
+                                      recommended.overspeedInt,
+                                      recommended.lowPass};
+    printf("Confirm the recommended set in SegwaySim with the build "
+           "options\n   ");
+    for (uint8_t i = 0; i < GAIN_COUNT; i++)
+    {
+        printf(" -DCFG_CTLR_%s=%.2ff", GAIN_NAMES[i], values[i]);
+    }
+    printf("\n");
+    return 0;
+}
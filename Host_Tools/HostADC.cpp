@@ -0,0 +1,93 @@
+/*
+ * HostADC.cpp
+ *
+ * Host implementation of the ADC class. On the microcontroller the class is
+ * linked from a precompiled library (see USE_ADC_LIBRARY in ADC.cpp), which
+ * isn't available on the PC. This file replaces ADC.cpp in host builds.
+ * The voltages of the analog inputs are set by the host program with
+ * hostADCSetVoltage. Each conversion takes the time of the hardware.
+ */
+
+#include "ADC.h"
+#include "HostDriverlib.h"
+
+
+// Voltages of the analog inputs AIN0 to AIN11
+static float voltages[12] = {};
+
+// Reference voltage and resolution of the ADC
+static const float REFERENCE_VOLTAGE = 3.3f;
+static const uint32_t MAX_VALUE = 4095;
+
+// Time of one conversion (1 Msps) times the hardware averaging.
+static const uint32_t CONVERSION_US = 1;
+
+
+void hostADCSetVoltage(uint32_t analogInput, float voltage)
+{
+    /*
+     * Set the voltage applied to the given analog input (ADC_CTL_CH0 to
+     * ADC_CTL_CH11). It's clamped to the reference voltage like on the
+     * hardware.
+     */
+
+    if (voltage < 0.0f)
+    {
+        voltage = 0.0f;
+    }
+    if (voltage > REFERENCE_VOLTAGE)
+    {
+        voltage = REFERENCE_VOLTAGE;
+    }
+    voltages[analogInput % 12] = voltage;
+}
+
+
+ADC::ADC()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+ADC::~ADC()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void ADC::init(System *sys, uint32_t base, uint32_t sampleSeq,
+               uint32_t analogInput)
+{
+    this->sys = sys;
+    this->base = base;
+    this->sampleSeq = sampleSeq;
+    this->analogInput = analogInput;
+    readValue = 0;
+    voltage = 0.0f;
+    spaceForLib[0] = 1;     // hardware averaging
+}
+
+void ADC::setHWAveraging(uint32_t averaging)
+{
+    spaceForLib[0] = averaging ? averaging : 1;
+}
+
+uint32_t ADC::read()
+{
+    /*
+     * Convert the voltage of the analog input to a 12 bit value.
+     */
+
+    host.advanceUS(CONVERSION_US * spaceForLib[0]);
+    readValue = voltages[analogInput % 12] / REFERENCE_VOLTAGE * MAX_VALUE
+                + 0.5f;
+    return readValue;
+}
+
+float ADC::readVolt()
+{
+    voltage = read() * (REFERENCE_VOLTAGE / MAX_VALUE);
+    return voltage;
+}
@@ -0,0 +1,1194 @@
+/*
+ * HostDriverlib.cpp
+ *
+ * Host implementation of the TivaWare driverlib (see HostDriverlib.h). Only
+ * the behaviour the code in Common_Classes relies on is modelled:
+ *  - SysCtl:    clock frequency, delays and enabled peripherals.
+ *  - GPIO:      pin states, pull-ups/-downs and edge interrupts.
+ *  - I2C:       master commands with the timing of the bus, errors and
+ *               interrupts. The devices are attached with hostI2CAttach.
+ *  - Timer:     periodic and one shot timeouts with interrupts.
+ *  - PWM:       period, pulse width and state of the outputs, which can be
+ *               read with hostPWMGetDuty (no waveform is generated).
+ *  - Interrupt: enabling and disabling all interrupts.
+ *  - UART:      UART0 with the timing of its transmit FIFO and the
+ *               transmit interrupt. The bytes are written to stdout (or
+ *               the function given to hostUARTSetOutput) as soon as they
+ *               enter the FIFO. Input is queued with hostUARTReceive.
+ *  - UARTStdio: unbuffered output via the UART.
+ */
+
+#include "HostDriverlib.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <set>
+#include <string>
+#include <algorithm>
+#include "inc/hw_memmap.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/gpio.h"
+#include "driverlib/i2c.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/fpu.h"
+#include "driverlib/timer.h"
+#include "driverlib/pwm.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/uart.h"
+#include "uartstdio.h"
+
+
+/*
+ * SysCtl
+ */
+
+static std::set<uint32_t> enabledPeripherals;
+static uint32_t pwmClockConfig = SYSCTL_PWMDIV_1;
+
+void SysCtlClockSet(uint32_t ui32Config)
+{
+    /*
+     * Only the configurations used by System::init are supported (PLL with
+     * 16MHz crystal).
+     */
+
+    switch (ui32Config & 0xffc00000)
+    {
+    case SYSCTL_SYSDIV_2_5:
+        host.setClockFreq(80000000);
+        break;
+    case SYSCTL_SYSDIV_4:
+        host.setClockFreq(50000000);
+        break;
+    case SYSCTL_SYSDIV_5:
+        host.setClockFreq(40000000);
+        break;
+    default:
+        fprintf(stderr, "SysCtlClockSet: unsupported configuration %08x\n",
+                ui32Config);
+        host.error();
+    }
+}
+
+uint32_t SysCtlClockGet(void)
+{
+    return host.getClockFreq();
+}
+
+void SysCtlDelay(uint32_t ui32Count)
+{
+    // Each loop of SysCtlDelay takes 3 cycles.
+    host.advance(3 * (uint64_t) ui32Count);
+}
+
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral)
+{
+    enabledPeripherals.insert(ui32Peripheral);
+}
+
+void SysCtlPeripheralDisable(uint32_t ui32Peripheral)
+{
+    enabledPeripherals.erase(ui32Peripheral);
+}
+
+void SysCtlPeripheralReset(uint32_t /* ui32Peripheral */)
+{
+    /*
+     * Only called by System::error (see HostHardware::error).
+     */
+
+    host.error();
+}
+
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral)
+{
+    host.advance(HostHardware::POLL_CYCLES);
+    return enabledPeripherals.count(ui32Peripheral);
+}
+
+void SysCtlPWMClockSet(uint32_t ui32Config)
+{
+    pwmClockConfig = ui32Config;
+}
+
+uint32_t SysCtlPWMClockGet(void)
+{
+    return pwmClockConfig;
+}
+
+
+/*
+ * Interrupt and FPU
+ */
+
+bool IntMasterEnable(void)
+{
+    return host.setInterruptsEnabled(true);
+}
+
+bool IntMasterDisable(void)
+{
+    return host.setInterruptsEnabled(false);
+}
+
+void IntEnable(uint32_t /* ui32Interrupt */)
+{
+    // The peripherals have their own interrupt enables.
+}
+
+void IntDisable(uint32_t /* ui32Interrupt */)
+{
+    // The peripherals have their own interrupt enables.
+}
+
+void IntPrioritySet(uint32_t /* ui32Interrupt */, uint8_t /* ui8Priority */)
+{
+    // Priorities are given by the order of HostHardware::addPeripheral.
+}
+
+void FPUEnable(void)
+{
+}
+
+void FPULazyStackingEnable(void)
+{
+}
+
+
+/*
+ * GPIO
+ */
+
+class HostGPIOPort : public HostPeripheral
+{
+public:
+    uint8_t outputs = 0;        // values written by GPIOPinWrite
+    uint8_t inputs = 0;         // values driven by external devices
+    uint8_t driven = 0;         // pins driven by external devices
+    uint8_t dirOut = 0;
+    uint8_t pullups = 0;
+    uint8_t pulldowns = 0;
+    uint8_t bothEdges = 0;
+    uint8_t risingEdges = 0;    // otherwise falling edge
+    uint8_t intMask = 0;
+    uint8_t intRaw = 0;
+    void (*ISR)(void) = 0;
+
+    uint8_t getState()
+    {
+        /*
+         * Returns the level of all pins. Inputs which aren't driven by a
+         * device are defined by their pull-up or pull-down.
+         */
+
+        uint8_t in = (inputs & driven) | (pullups & ~driven);
+        return (outputs & dirOut) | (in & ~dirOut);
+    }
+
+    void setInputs(uint8_t pins, bool state)
+    {
+        /*
+         * Drive the given pins and set the interrupt flags of pins with a
+         * matching edge.
+         */
+
+        uint8_t before = getState();
+        driven |= pins;
+        inputs = state ? (inputs | pins) : (inputs & ~pins);
+        uint8_t after = getState();
+
+        uint8_t rising = ~before & after;
+        uint8_t falling = before & ~after;
+        intRaw |= (rising | falling) & bothEdges;
+        intRaw |= rising & risingEdges & ~bothEdges;
+        intRaw |= falling & ~risingEdges & ~bothEdges;
+    }
+
+    bool interruptPending()
+    {
+        return (intRaw & intMask) && ISR;
+    }
+
+    void callISR()
+    {
+        ISR();
+    }
+};
+
+static HostGPIOPort gpioPorts[6];
+static bool gpioPortsAdded = false;
+
+static HostGPIOPort &getGPIOPort(uint32_t portBase)
+{
+    /*
+     * Returns the port with the given base address. The ports are attached
+     * to the host hardware on first use.
+     */
+
+    if (!gpioPortsAdded)
+    {
+        for (HostGPIOPort &port : gpioPorts)
+        {
+            host.addPeripheral(&port);
+        }
+        gpioPortsAdded = true;
+    }
+
+    switch (portBase)
+    {
+    case GPIO_PORTA_BASE:
+        return gpioPorts[0];
+    case GPIO_PORTB_BASE:
+        return gpioPorts[1];
+    case GPIO_PORTC_BASE:
+        return gpioPorts[2];
+    case GPIO_PORTD_BASE:
+        return gpioPorts[3];
+    case GPIO_PORTE_BASE:
+        return gpioPorts[4];
+    case GPIO_PORTF_BASE:
+        return gpioPorts[5];
+    default:
+        fprintf(stderr, "GPIO: unknown port %08x\n", portBase);
+        host.error();
+        return gpioPorts[0];
+    }
+}
+
+void GPIODirModeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32PinIO)
+{
+    HostGPIOPort &port = getGPIOPort(ui32Port);
+    if (ui32PinIO == GPIO_DIR_MODE_OUT)
+    {
+        port.dirOut |= ui8Pins;
+    }
+    else
+    {
+        port.dirOut &= ~ui8Pins;
+    }
+}
+
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins,
+                      uint32_t /* ui32Strength */, uint32_t ui32PadType)
+{
+    HostGPIOPort &port = getGPIOPort(ui32Port);
+    port.pullups &= ~ui8Pins;
+    port.pulldowns &= ~ui8Pins;
+    if (ui32PadType == GPIO_PIN_TYPE_STD_WPU)
+    {
+        port.pullups |= ui8Pins;
+    }
+    else if (ui32PadType == GPIO_PIN_TYPE_STD_WPD)
+    {
+        port.pulldowns |= ui8Pins;
+    }
+}
+
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    host.advance(HostHardware::POLL_CYCLES);
+    return getGPIOPort(ui32Port).getState() & ui8Pins;
+}
+
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val)
+{
+    HostGPIOPort &port = getGPIOPort(ui32Port);
+    port.outputs = (port.outputs & ~ui8Pins) | (ui8Val & ui8Pins);
+}
+
+void GPIOPinConfigure(uint32_t /* ui32PinConfig */)
+{
+    // The pin multiplexing has no effect on the host.
+}
+
+void GPIOPinTypeADC(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    GPIODirModeSet(ui32Port, ui8Pins, GPIO_DIR_MODE_HW);
+}
+
+void GPIOPinTypeI2C(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    GPIODirModeSet(ui32Port, ui8Pins, GPIO_DIR_MODE_HW);
+}
+
+void GPIOPinTypeI2CSCL(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    GPIODirModeSet(ui32Port, ui8Pins, GPIO_DIR_MODE_HW);
+}
+
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    GPIODirModeSet(ui32Port, ui8Pins, GPIO_DIR_MODE_HW);
+}
+
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins)
+{
+    GPIODirModeSet(ui32Port, ui8Pins, GPIO_DIR_MODE_HW);
+}
+
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins,
+                    uint32_t ui32IntType)
+{
+    /*
+     * Only edge interrupts are supported.
+     */
+
+    HostGPIOPort &port = getGPIOPort(ui32Port);
+    port.bothEdges &= ~ui8Pins;
+    port.risingEdges &= ~ui8Pins;
+    if (ui32IntType == GPIO_BOTH_EDGES)
+    {
+        port.bothEdges |= ui8Pins;
+    }
+    else if (ui32IntType == GPIO_RISING_EDGE)
+    {
+        port.risingEdges |= ui8Pins;
+    }
+    else if (ui32IntType != GPIO_FALLING_EDGE)
+    {
+        fprintf(stderr, "GPIOIntTypeSet: level interrupts not supported\n");
+        host.error();
+    }
+}
+
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void))
+{
+    getGPIOPort(ui32Port).ISR = pfnIntHandler;
+}
+
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getGPIOPort(ui32Port).intMask |= ui32IntFlags;
+}
+
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getGPIOPort(ui32Port).intMask &= ~ui32IntFlags;
+}
+
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked)
+{
+    HostGPIOPort &port = getGPIOPort(ui32Port);
+    return bMasked ? (port.intRaw & port.intMask) : port.intRaw;
+}
+
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags)
+{
+    getGPIOPort(ui32Port).intRaw &= ~ui32IntFlags;
+}
+
+void hostGPIOSetInput(uint32_t portBase, uint8_t pins, bool state)
+{
+    /*
+     * Drive input pins from an external device (f.ex. a switch or the INT
+     * pin of a sensor). Interrupts of the pins are triggered accordingly.
+     *
+     * portBase: Base address of the port.
+     * pins:     Pins to be driven.
+     * state:    Level of these pins.
+     */
+
+    getGPIOPort(portBase).setInputs(pins, state);
+}
+
+bool hostGPIOGetOutput(uint32_t portBase, uint8_t pin)
+{
+    /*
+     * Returns the level of the given pin (f.ex. to check the state of an
+     * LED).
+     */
+
+    return getGPIOPort(portBase).getState() & pin;
+}
+
+
+/*
+ * I2C
+ */
+
+class HostI2CMaster : public HostPeripheral
+{
+public:
+    std::vector<HostI2CDevice*> devices;
+    HostI2CDevice *active = 0;  // device addressed by the last start
+    uint32_t bitCycles = 0;     // duration of one bit on the bus
+    uint8_t slaveAddress = 0;
+    bool receive = false;
+    uint8_t data = 0;
+    uint32_t error = I2C_MASTER_ERR_NONE;
+    uint64_t busyUntil = 0;
+    bool busy = false;
+    bool intRaw = false;
+    bool intEnabled = false;
+    void (*ISR)(void) = 0;
+    HostI2CStats stats = {0, 0, 0, 0};
+
+    // Master control bits of I2CMasterControl
+    const static uint32_t CMD_RUN   = 0x01;
+    const static uint32_t CMD_START = 0x02;
+    const static uint32_t CMD_STOP  = 0x04;
+
+    void control(uint32_t cmd)
+    {
+        /*
+         * Execute one master command. The devices see the transfer
+         * immediately, the master stays busy as long as the transfer takes on
+         * the bus (9 bit times per byte plus start and stop condition).
+         */
+
+        uint32_t bits = 0;
+        error = I2C_MASTER_ERR_NONE;
+        stats.commands++;
+
+        if (cmd & CMD_START)
+        {
+            active = 0;
+            for (HostI2CDevice *device : devices)
+            {
+                if (device->start(slaveAddress, receive))
+                {
+                    active = device;
+                    break;
+                }
+            }
+            bits += 1 + 9;
+            stats.transactions++;
+            stats.bytes++;
+            if (!active)
+            {
+                // Without acknowledge the master stops the transfer.
+                error = I2C_MASTER_ERR_ADDR_ACK;
+                cmd = CMD_STOP;
+            }
+        }
+
+        if (cmd & CMD_RUN)
+        {
+            if (!active)
+            {
+                error = I2C_MASTER_ERR_DATA_ACK;
+            }
+            else if (receive)
+            {
+                data = active->read();
+            }
+            else if (!active->write(data))
+            {
+                error = I2C_MASTER_ERR_DATA_ACK;
+                cmd |= CMD_STOP;
+            }
+            bits += 9;
+            stats.bytes++;
+        }
+
+        if (cmd & CMD_STOP)
+        {
+            if (active)
+            {
+                active->stop();
+            }
+            active = 0;
+            bits += 1;
+        }
+
+        busy = true;
+        busyUntil = host.getCycles() + bits * bitCycles;
+        stats.busyCycles += bits * bitCycles;
+    }
+
+    uint64_t getNextEvent()
+    {
+        return busy ? busyUntil : NO_EVENT;
+    }
+
+    void update(uint64_t /* cycles */)
+    {
+        // Command finished
+        busy = false;
+        intRaw = true;
+    }
+
+    bool interruptPending()
+    {
+        return intRaw && intEnabled && ISR;
+    }
+
+    void callISR()
+    {
+        ISR();
+    }
+};
+
+static HostI2CMaster i2cMasters[4];
+static bool i2cMastersAdded = false;
+
+static HostI2CMaster &getI2CMaster(uint32_t i2cBase)
+{
+    /*
+     * Returns the master with the given base address. The masters are
+     * attached to the host hardware on first use.
+     */
+
+    if (!i2cMastersAdded)
+    {
+        for (HostI2CMaster &master : i2cMasters)
+        {
+            host.addPeripheral(&master);
+        }
+        i2cMastersAdded = true;
+    }
+
+    uint32_t module = (i2cBase - I2C0_BASE) / 0x1000;
+    if (module >= 4)
+    {
+        fprintf(stderr, "I2C: unknown module %08x\n", i2cBase);
+        host.error();
+        module = 0;
+    }
+    return i2cMasters[module];
+}
+
+void I2CMasterInitExpClk(uint32_t ui32Base, uint32_t ui32I2CClk,
+                         bool bFast)
+{
+    uint32_t busFreq = bFast ? 400000 : 100000;
+    getI2CMaster(ui32Base).bitCycles = ui32I2CClk / busFreq;
+}
+
+void I2CMasterSlaveAddrSet(uint32_t ui32Base, uint8_t ui8SlaveAddr,
+                           bool bReceive)
+{
+    HostI2CMaster &master = getI2CMaster(ui32Base);
+    master.slaveAddress = ui8SlaveAddr;
+    master.receive = bReceive;
+}
+
+void I2CMasterDataPut(uint32_t ui32Base, uint8_t ui8Data)
+{
+    getI2CMaster(ui32Base).data = ui8Data;
+}
+
+uint32_t I2CMasterDataGet(uint32_t ui32Base)
+{
+    return getI2CMaster(ui32Base).data;
+}
+
+void I2CMasterControl(uint32_t ui32Base, uint32_t ui32Cmd)
+{
+    getI2CMaster(ui32Base).control(ui32Cmd);
+}
+
+bool I2CMasterBusy(uint32_t ui32Base)
+{
+    host.advance(HostHardware::POLL_CYCLES);
+    return getI2CMaster(ui32Base).busy;
+}
+
+uint32_t I2CMasterErr(uint32_t ui32Base)
+{
+    return getI2CMaster(ui32Base).error;
+}
+
+void I2CMasterIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    getI2CMaster(ui32Base).ISR = pfnHandler;
+}
+
+void I2CMasterIntEnable(uint32_t ui32Base)
+{
+    getI2CMaster(ui32Base).intEnabled = true;
+}
+
+void I2CMasterIntDisable(uint32_t ui32Base)
+{
+    getI2CMaster(ui32Base).intEnabled = false;
+}
+
+void I2CMasterIntClear(uint32_t ui32Base)
+{
+    getI2CMaster(ui32Base).intRaw = false;
+}
+
+bool I2CMasterIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    HostI2CMaster &master = getI2CMaster(ui32Base);
+    return bMasked ? (master.intRaw && master.intEnabled) : master.intRaw;
+}
+
+void hostI2CAttach(uint32_t i2cBase, HostI2CDevice *device)
+{
+    /*
+     * Connect a device to the bus of the given I2C module.
+     */
+
+    getI2CMaster(i2cBase).devices.push_back(device);
+}
+
+void hostI2CDetach(uint32_t i2cBase, HostI2CDevice *device)
+{
+    /*
+     * Disconnect a device from the bus, f.ex. before it's destroyed.
+     */
+
+    HostI2CMaster &master = getI2CMaster(i2cBase);
+    master.devices.erase(std::remove(master.devices.begin(),
+                                     master.devices.end(), device),
+                         master.devices.end());
+    if (master.active == device)
+    {
+        master.active = 0;
+    }
+}
+
+HostI2CStats hostI2CGetStats(uint32_t i2cBase)
+{
+    /*
+     * Returns the statistics of the given I2C module since the start or the
+     * last call of hostI2CResetStats.
+     */
+
+    return getI2CMaster(i2cBase).stats;
+}
+
+void hostI2CResetStats(uint32_t i2cBase)
+{
+    getI2CMaster(i2cBase).stats = {0, 0, 0, 0};
+}
+
+
+/*
+ * Timer
+ */
+
+class HostTimer : public HostPeripheral
+{
+public:
+    uint64_t load = 0;
+    uint64_t timeout = 0;       // time of the next timeout
+    bool periodic = true;
+    bool enabled = false;
+    uint32_t intMask = 0;
+    uint32_t intRaw = 0;
+    void (*ISR)(void) = 0;
+
+    uint64_t getNextEvent()
+    {
+        return enabled ? timeout : NO_EVENT;
+    }
+
+    void update(uint64_t /* cycles */)
+    {
+        /*
+         * The timer counts down from the load value to 0 and then sets its
+         * timeout flag. A periodic timer reloads, a one shot timer stops.
+         */
+
+        intRaw |= TIMER_TIMA_TIMEOUT;
+        if (periodic)
+        {
+            timeout += load + 1;
+        }
+        else
+        {
+            enabled = false;
+        }
+    }
+
+    bool interruptPending()
+    {
+        return (intRaw & intMask) && ISR;
+    }
+
+    void callISR()
+    {
+        ISR();
+    }
+};
+
+static HostTimer timers[6];
+static bool timersAdded = false;
+
+static HostTimer &getTimer(uint32_t timerBase)
+{
+    /*
+     * Returns the timer with the given base address. The timers are attached
+     * to the host hardware on first use.
+     */
+
+    if (!timersAdded)
+    {
+        for (HostTimer &timer : timers)
+        {
+            host.addPeripheral(&timer);
+        }
+        timersAdded = true;
+    }
+
+    uint32_t module = (timerBase - TIMER0_BASE) / 0x1000;
+    if (module >= 6)
+    {
+        fprintf(stderr, "Timer: unknown module %08x\n", timerBase);
+        host.error();
+        module = 0;
+    }
+    return timers[module];
+}
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config)
+{
+    HostTimer &timer = getTimer(ui32Base);
+    timer.periodic = (ui32Config == TIMER_CFG_PERIODIC);
+    timer.enabled = false;
+}
+
+void TimerEnable(uint32_t ui32Base, uint32_t /* ui32Timer */)
+{
+    HostTimer &timer = getTimer(ui32Base);
+    timer.enabled = true;
+    timer.timeout = host.getCycles() + timer.load + 1;
+}
+
+void TimerDisable(uint32_t ui32Base, uint32_t /* ui32Timer */)
+{
+    getTimer(ui32Base).enabled = false;
+}
+
+void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value)
+{
+    // A running timer uses the new value after the next timeout.
+    getTimer(ui32Base).load = ui64Value;
+}
+
+uint64_t TimerValueGet64(uint32_t ui32Base)
+{
+    HostTimer &timer = getTimer(ui32Base);
+    return timer.enabled ? timer.timeout - host.getCycles() : timer.load;
+}
+
+void TimerIntRegister(uint32_t ui32Base, uint32_t /* ui32Timer */,
+                      void (*pfnHandler)(void))
+{
+    getTimer(ui32Base).ISR = pfnHandler;
+}
+
+void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getTimer(ui32Base).intMask |= ui32IntFlags;
+}
+
+void TimerIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getTimer(ui32Base).intMask &= ~ui32IntFlags;
+}
+
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getTimer(ui32Base).intRaw &= ~ui32IntFlags;
+}
+
+
+/*
+ * PWM
+ */
+
+struct HostPWMModule
+{
+    uint32_t periods[4];
+    bool generatorsEnabled[4];
+    uint32_t widths[8];
+    uint8_t outputsEnabled;
+    uint8_t outputsInverted;
+};
+
+static HostPWMModule pwmModules[2] = {};
+
+// Pins which can be used as PWM outputs: GPIO port, pin, PWM module and
+// output (see PWM.h).
+static const uint32_t PWM_PINS[16][4] = {
+    {GPIO_PORTB_BASE, GPIO_PIN_6, PWM0_BASE, PWM_OUT_0},
+    {GPIO_PORTB_BASE, GPIO_PIN_7, PWM0_BASE, PWM_OUT_1},
+    {GPIO_PORTB_BASE, GPIO_PIN_4, PWM0_BASE, PWM_OUT_2},
+    {GPIO_PORTB_BASE, GPIO_PIN_5, PWM0_BASE, PWM_OUT_3},
+    {GPIO_PORTE_BASE, GPIO_PIN_4, PWM0_BASE, PWM_OUT_4},
+    {GPIO_PORTE_BASE, GPIO_PIN_5, PWM0_BASE, PWM_OUT_5},
+    {GPIO_PORTC_BASE, GPIO_PIN_4, PWM0_BASE, PWM_OUT_6},
+    {GPIO_PORTC_BASE, GPIO_PIN_5, PWM0_BASE, PWM_OUT_7},
+    {GPIO_PORTD_BASE, GPIO_PIN_0, PWM1_BASE, PWM_OUT_0},
+    {GPIO_PORTD_BASE, GPIO_PIN_1, PWM1_BASE, PWM_OUT_1},
+    {GPIO_PORTA_BASE, GPIO_PIN_6, PWM1_BASE, PWM_OUT_2},
+    {GPIO_PORTA_BASE, GPIO_PIN_7, PWM1_BASE, PWM_OUT_3},
+    {GPIO_PORTF_BASE, GPIO_PIN_0, PWM1_BASE, PWM_OUT_4},
+    {GPIO_PORTF_BASE, GPIO_PIN_1, PWM1_BASE, PWM_OUT_5},
+    {GPIO_PORTF_BASE, GPIO_PIN_2, PWM1_BASE, PWM_OUT_6},
+    {GPIO_PORTF_BASE, GPIO_PIN_3, PWM1_BASE, PWM_OUT_7}};
+
+static HostPWMModule &getPWMModule(uint32_t pwmBase)
+{
+    switch (pwmBase)
+    {
+    case PWM0_BASE:
+        return pwmModules[0];
+    case PWM1_BASE:
+        return pwmModules[1];
+    default:
+        fprintf(stderr, "PWM: unknown module %08x\n", pwmBase);
+        host.error();
+        return pwmModules[0];
+    }
+}
+
+static uint32_t getPWMGenerator(uint32_t gen)
+{
+    // PWM_GEN_0 to PWM_GEN_3 are multiples of 0x40.
+    return (gen / 0x40 - 1) & 3;
+}
+
+void PWMGenConfigure(uint32_t /* ui32Base */, uint32_t /* ui32Gen */,
+                     uint32_t /* ui32Config */)
+{
+    // Only the count down mode used by the PWM class is modelled.
+}
+
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen,
+                     uint32_t ui32Period)
+{
+    getPWMModule(ui32Base).periods[getPWMGenerator(ui32Gen)] = ui32Period;
+}
+
+uint32_t PWMGenPeriodGet(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    return getPWMModule(ui32Base).periods[getPWMGenerator(ui32Gen)];
+}
+
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen)
+{
+    getPWMModule(ui32Base).generatorsEnabled[getPWMGenerator(ui32Gen)] = true;
+}
+
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut,
+                      uint32_t ui32Width)
+{
+    getPWMModule(ui32Base).widths[ui32PWMOut & 7] = ui32Width;
+}
+
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits,
+                    bool bEnable)
+{
+    HostPWMModule &module = getPWMModule(ui32Base);
+    if (bEnable)
+    {
+        module.outputsEnabled |= ui32PWMOutBits;
+    }
+    else
+    {
+        module.outputsEnabled &= ~ui32PWMOutBits;
+    }
+}
+
+void PWMOutputInvert(uint32_t ui32Base, uint32_t ui32PWMOutBits,
+                     bool bInvert)
+{
+    HostPWMModule &module = getPWMModule(ui32Base);
+    if (bInvert)
+    {
+        module.outputsInverted |= ui32PWMOutBits;
+    }
+    else
+    {
+        module.outputsInverted &= ~ui32PWMOutBits;
+    }
+}
+
+void PWMOutputUpdateMode(uint32_t /* ui32Base */,
+                         uint32_t /* ui32PWMOutBits */,
+                         uint32_t /* ui32Mode */)
+{
+    // New pulse widths apply immediately on the host.
+}
+
+float hostPWMGetDuty(uint32_t portBase, uint8_t pin)
+{
+    /*
+     * Returns the duty cycle (0.0f to 1.0f) of the PWM output on the given
+     * pin, 0.0f if the output or its generator is disabled.
+     * The inversion (PWMOutputInvert) is not applied: it only adapts the
+     * signal to the motor driver (see CFG_PWM_INVERT), which therefore
+     * sees this duty cycle.
+     */
+
+    for (const uint32_t *pwmPin : PWM_PINS)
+    {
+        if (pwmPin[0] != portBase || pwmPin[1] != pin)
+        {
+            continue;
+        }
+
+        HostPWMModule &module = getPWMModule(pwmPin[2]);
+        uint32_t out = pwmPin[3] & 7;
+        uint32_t gen = out / 2;
+        uint32_t period = module.periods[gen];
+        if (!(module.outputsEnabled & (1 << out))
+            || !module.generatorsEnabled[gen] || period == 0)
+        {
+            return 0.0f;
+        }
+        return std::min(module.widths[out], period) / (float) period;
+    }
+
+    fprintf(stderr, "PWM: pin %02x of port %08x has no PWM output\n", pin,
+            portBase);
+    host.error();
+    return 0.0f;
+}
+
+
+/*
+ * UART and UARTStdio
+ */
+
+static void stdoutOutput(const char *data, uint32_t length)
+{
+    fwrite(data, 1, length, stdout);
+}
+
+static void (*uartOutput)(const char *data, uint32_t length) = stdoutOutput;
+static std::string uartInput;
+
+class HostUART : public HostPeripheral
+{
+public:
+    uint32_t baud = 115200;
+    uint32_t fifoCount = 0;     // bytes in the transmit FIFO
+    uint64_t nextByteSent = 0;  // time the first of them is sent
+    uint32_t txLevel = 2;       // interrupt at or below (UARTFIFOLevelSet)
+    uint32_t intMask = 0;
+    uint32_t intRaw = 0;
+    void (*ISR)(void) = 0;
+
+    // Size of the transmit FIFO
+    const static uint32_t FIFO_SIZE = 16;
+
+    uint64_t getNextEvent()
+    {
+        return fifoCount ? nextByteSent : NO_EVENT;
+    }
+
+    void update(uint64_t /* cycles */)
+    {
+        /*
+         * One byte (start bit, 8 data bits, stop bit) has been sent. The
+         * transmit interrupt is set when the FIFO drops to its level.
+         */
+
+        fifoCount--;
+        nextByteSent += getByteCycles();
+        if (fifoCount == txLevel)
+        {
+            intRaw |= UART_INT_TX;
+        }
+    }
+
+    bool interruptPending()
+    {
+        return (intRaw & intMask) && ISR;
+    }
+
+    void callISR()
+    {
+        ISR();
+    }
+
+    bool put(unsigned char data)
+    {
+        /*
+         * Add a byte to the FIFO. It's passed to the output right away, the
+         * FIFO only models the time needed to send it.
+         */
+
+        if (fifoCount >= FIFO_SIZE)
+        {
+            return false;
+        }
+        if (!fifoCount)
+        {
+            nextByteSent = host.getCycles() + getByteCycles();
+        }
+        fifoCount++;
+
+        char c = data;
+        uartOutput(&c, 1);
+        return true;
+    }
+
+    uint64_t getByteCycles()
+    {
+        return (uint64_t) host.getClockFreq() * 10 / baud;
+    }
+};
+
+static HostUART uart;
+static bool uartAdded = false;
+
+static HostUART &getUART(uint32_t uartBase)
+{
+    /*
+     * Only UART0 (USB) is modelled; it shares the output with UARTStdio. It
+     * is attached to the host hardware on first use.
+     */
+
+    if (!uartAdded)
+    {
+        host.addPeripheral(&uart);
+        uartAdded = true;
+    }
+
+    if (uartBase != UART0_BASE)
+    {
+        fprintf(stderr, "UART: unknown module %08x\n", uartBase);
+        host.error();
+    }
+    return uart;
+}
+
+void UARTStdioConfig(uint32_t /* ui32Port */, uint32_t ui32Baud,
+                     uint32_t /* ui32SrcClock */)
+{
+    getUART(UART0_BASE).baud = ui32Baud;
+}
+
+int UARTwrite(const char *pcBuf, uint32_t ui32Len)
+{
+    // Unbuffered like UARTStdio on the microcontroller (without
+    // UART_BUFFERED): waits for space in the FIFO.
+    for (uint32_t i = 0; i < ui32Len; i++)
+    {
+        UARTCharPut(UART0_BASE, pcBuf[i]);
+    }
+    return ui32Len;
+}
+
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData)
+{
+    HostUART &uart = getUART(ui32Base);
+    while (!uart.put(ucData))
+    {
+        host.advance(HostHardware::POLL_CYCLES);
+    }
+}
+
+bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData)
+{
+    return getUART(ui32Base).put(ucData);
+}
+
+bool UARTSpaceAvail(uint32_t ui32Base)
+{
+    HostUART &uart = getUART(ui32Base);
+    host.advance(HostHardware::POLL_CYCLES);
+    return uart.fifoCount < HostUART::FIFO_SIZE;
+}
+
+bool UARTBusy(uint32_t ui32Base)
+{
+    HostUART &uart = getUART(ui32Base);
+    host.advance(HostHardware::POLL_CYCLES);
+    return uart.fifoCount > 0;
+}
+
+void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel,
+                      uint32_t /* ui32RxLevel */)
+{
+    // UART_FIFO_TX1_8 (0) to UART_FIFO_TX7_8 (4) in steps of 1/8 (2 bytes).
+    getUART(ui32Base).txLevel = (ui32TxLevel + 1) * 2;
+}
+
+void UARTTxIntModeSet(uint32_t /* ui32Base */, uint32_t ui32Mode)
+{
+    // Only the FIFO mode is modelled.
+    if (ui32Mode != UART_TXINT_MODE_FIFO)
+    {
+        fprintf(stderr, "UART: transmit interrupt mode %08x not modelled\n",
+                ui32Mode);
+        host.error();
+    }
+}
+
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void))
+{
+    getUART(ui32Base).ISR = pfnHandler;
+}
+
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getUART(ui32Base).intMask |= ui32IntFlags;
+}
+
+void UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getUART(ui32Base).intMask &= ~ui32IntFlags;
+}
+
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked)
+{
+    HostUART &uart = getUART(ui32Base);
+    return bMasked ? (uart.intRaw & uart.intMask) : uart.intRaw;
+}
+
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags)
+{
+    getUART(ui32Base).intRaw &= ~ui32IntFlags;
+}
+
+bool UARTCharsAvail(uint32_t /* ui32Base */)
+{
+    return !uartInput.empty();
+}
+
+int32_t UARTCharGetNonBlocking(uint32_t /* ui32Base */)
+{
+    // Returns -1 if nothing has been received (see hostUARTReceive).
+    if (uartInput.empty())
+    {
+        return -1;
+    }
+    unsigned char data = uartInput[0];
+    uartInput.erase(0, 1);
+    return data;
+}
+
+void UARTprintf(const char *pcString, ...)
+{
+    char buffer[256];
+    va_list args;
+    va_start(args, pcString);
+    int length = vsnprintf(buffer, sizeof(buffer), pcString, args);
+    va_end(args);
+
+    if (length > (int) sizeof(buffer) - 1)
+    {
+        length = sizeof(buffer) - 1;
+    }
+    if (length > 0)
+    {
+        UARTwrite(buffer, length);
+    }
+}
+
+void hostUARTSetOutput(void (*output)(const char *data, uint32_t length))
+{
+    /*
+     * Redirect everything sent with UARTStdio (f.ex. to a file or to decode
+     * it). Default is stdout.
+     */
+
+    uartOutput = output;
+}
+
+void hostUARTReceive(const char *data)
+{
+    /*
+     * Queue the given characters as if they had been sent to UART0 by the
+     * PC (f.ex. commands for System::handleRequests).
+     */
+
+    uartInput += data;
+}
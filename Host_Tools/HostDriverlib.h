@@ -0,0 +1,73 @@
+/*
+ * HostDriverlib.h
+ *
+ * Host implementation of the TivaWare driverlib functions used by
+ * Common_Classes. The functions themselves are declared in the host versions
+ * of the TivaWare headers (Host_Tools/TivaWare). This header contains the
+ * additional functions the host programs need to connect external devices
+ * and to inspect the peripherals.
+ */
+
+#ifndef HOSTDRIVERLIB_H_
+#define HOSTDRIVERLIB_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * HostHardware.h:          Virtual time base and interrupt handling.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "HostHardware.h"
+
+
+class HostI2CDevice
+{
+public:
+    /*
+     * Interface of a device (slave) on an I2C bus. The master calls these
+     * methods in the order the transfer happens on the bus.
+     */
+    virtual ~HostI2CDevice() {}
+
+    // Start condition with the given slave address and direction. Returns
+    // whether the device acknowledges.
+    virtual bool start(uint8_t address, bool receive) = 0;
+
+    // Byte sent by the master. Returns whether the device acknowledges.
+    virtual bool write(uint8_t data) = 0;
+
+    // Returns the byte requested by the master.
+    virtual uint8_t read() = 0;
+
+    // Stop condition.
+    virtual void stop() = 0;
+};
+
+
+// Statistics of an I2C master module.
+struct HostI2CStats
+{
+    uint32_t transactions;  // start conditions (including repeated starts)
+    uint32_t commands;      // calls of I2CMasterControl
+    uint32_t bytes;         // bytes on the bus (including address bytes)
+    uint64_t busyCycles;    // time the bus was busy in CPU cycles
+};
+
+
+void hostI2CAttach(uint32_t i2cBase, HostI2CDevice *device);
+void hostI2CDetach(uint32_t i2cBase, HostI2CDevice *device);
+HostI2CStats hostI2CGetStats(uint32_t i2cBase);
+void hostI2CResetStats(uint32_t i2cBase);
+void hostGPIOSetInput(uint32_t portBase, uint8_t pins, bool state);
+bool hostGPIOGetOutput(uint32_t portBase, uint8_t pin);
+float hostPWMGetDuty(uint32_t portBase, uint8_t pin);
+void hostUARTSetOutput(void (*output)(const char *data, uint32_t length));
+void hostUARTReceive(const char *data);
+
+// Implemented in HostADC.cpp (replacement of the precompiled ADC library).
+void hostADCSetVoltage(uint32_t analogInput, float voltage);
+
+
+#endif /* HOSTDRIVERLIB_H_ */
@@ -0,0 +1,320 @@
+/*
+ * HostHardware.cpp
+ */
+
+#include "HostHardware.h"
+#include "inc/hw_types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+
+HostHardware host;
+
+
+HostPeripheral::HostPeripheral()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+HostPeripheral::~HostPeripheral()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+uint64_t HostPeripheral::getNextEvent()
+{
+    /*
+     * Returns the cycle count at which HostPeripheral::update must be called
+     * next. Default is no event.
+     */
+
+    return NO_EVENT;
+}
+
+void HostPeripheral::update(uint64_t /* cycles */)
+{
+    /*
+     * Called as soon as the time returned by HostPeripheral::getNextEvent
+     * has come. Must schedule the next event (or none), otherwise it's called
+     * again immediately.
+     *
+     * cycles: Current time.
+     */
+}
+
+bool HostPeripheral::interruptPending()
+{
+    /*
+     * Returns whether the peripheral has an enabled interrupt whose flag is
+     * set.
+     */
+
+    return false;
+}
+
+void HostPeripheral::callISR()
+{
+    /*
+     * Call the ISR registered for the pending interrupt.
+     */
+}
+
+
+HostHardware::HostHardware()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+HostHardware::~HostHardware()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void HostHardware::addPeripheral(HostPeripheral *peripheral)
+{
+    /*
+     * Attach a peripheral to the virtual hardware. Peripherals added first
+     * have the higher interrupt priority.
+     */
+
+    peripherals.push_back(peripheral);
+}
+
+void HostHardware::removePeripheral(HostPeripheral *peripheral)
+{
+    /*
+     * Detach a peripheral, f.ex. before it's destroyed.
+     */
+
+    peripherals.erase(std::remove(peripherals.begin(), peripherals.end(),
+                                  peripheral),
+                      peripherals.end());
+}
+
+void HostHardware::setClockFreq(uint32_t freq)
+{
+    /*
+     * Set the CPU clock (see SysCtlClockSet). The cycle counter keeps its
+     * value.
+     */
+
+    clockFreq = freq;
+}
+
+uint32_t HostHardware::getClockFreq()
+{
+    return clockFreq;
+}
+
+uint64_t HostHardware::getCycles()
+{
+    /*
+     * Returns the number of CPU cycles since the start of the program. Unlike
+     * the DWT cycle counter this value doesn't overflow.
+     */
+
+    return cycles;
+}
+
+uint64_t HostHardware::getCyclesUS(uint32_t us)
+{
+    /*
+     * Convert microseconds to CPU cycles.
+     */
+
+    return (uint64_t) us * clockFreq / 1000000;
+}
+
+double HostHardware::getTime()
+{
+    /*
+     * Returns the time since the start of the program in seconds.
+     */
+
+    return (double) cycles / clockFreq;
+}
+
+void HostHardware::advance(uint64_t cycles)
+{
+    /*
+     * Let the given number of CPU cycles pass (see HostHardware::advanceTo).
+     */
+
+    advanceTo(this->cycles + cycles);
+}
+
+void HostHardware::advanceUS(uint32_t us)
+{
+    /*
+     * Let the given number of microseconds pass (see
+     * HostHardware::advanceTo).
+     */
+
+    advance(getCyclesUS(us));
+}
+
+void HostHardware::advanceTo(uint64_t cycles)
+{
+    /*
+     * Let the time pass until the given cycle count. All peripheral events
+     * in between are processed in chronological order and pending
+     * interrupts are serviced right after the event which caused them, just
+     * like the CPU would interrupt the running code.
+     * Note: ISRs may call this method themselves (f.ex. by polling the I2C
+     *       master). Events are still processed then, but no other ISR is
+     *       called until the running one returns.
+     *
+     * cycles: Time up to which the events are processed.
+     */
+
+    do
+    {
+        // Jump to the next event (or the target if there is none before).
+        uint64_t next = cycles;
+        for (HostPeripheral *peripheral : peripherals)
+        {
+            next = std::min(next, peripheral->getNextEvent());
+        }
+        if (next > this->cycles)
+        {
+            this->cycles = next;
+        }
+
+        for (HostPeripheral *peripheral : peripherals)
+        {
+            if (peripheral->getNextEvent() <= this->cycles)
+            {
+                peripheral->update(this->cycles);
+            }
+        }
+
+        dispatchInterrupts();
+    } while (this->cycles < cycles);
+}
+
+bool HostHardware::setInterruptsEnabled(bool enabled)
+{
+    /*
+     * Enable or disable the processor interrupts (see IntMasterEnable).
+     * Interrupts which became pending while they were disabled are serviced
+     * as soon as they're enabled again.
+     * Returns whether interrupts were disabled before, like
+     * IntMasterEnable.
+     */
+
+    bool wasDisabled = !interruptsEnabled;
+    interruptsEnabled = enabled;
+    dispatchInterrupts();
+
+    return wasDisabled;
+}
+
+bool HostHardware::getInterruptsEnabled()
+{
+    return interruptsEnabled;
+}
+
+bool HostHardware::isInISR()
+{
+    /*
+     * Returns whether an ISR is running.
+     */
+
+    return inISR;
+}
+
+volatile uint32_t *HostHardware::getRegister(uint32_t address)
+{
+    /*
+     * Returns the storage of the register with the given address. Registers
+     * without special meaning simply keep the value written to them.
+     * Reading the DWT cycle counter returns the lower 32 bits of the virtual
+     * time. Each access takes one cycle so that loops waiting for a deadline
+     * (see System::deadlinePassed) terminate.
+     */
+
+    uint32_t &reg = registers[address];
+    if (address == DWT_CYCCNT_REG)
+    {
+        advance(1);
+        reg = (uint32_t) this->cycles;
+    }
+    return &reg;
+}
+
+void HostHardware::setErrorHandler(void (*handler)(void))
+{
+    /*
+     * Set a function which is called instead of stopping the program if the
+     * code calls System::error. Default is none.
+     */
+
+    errorHandler = handler;
+}
+
+void HostHardware::error()
+{
+    /*
+     * On the microcontroller System::error stops all peripherals and hangs
+     * in an endless loop. The host stops the program instead (unless an
+     * error handler has been set).
+     */
+
+    if (errorHandler)
+    {
+        errorHandler();
+        return;
+    }
+
+    fprintf(stderr, "System::error called at t = %.6fs\n", getTime());
+    exit(EXIT_FAILURE);
+}
+
+void HostHardware::dispatchInterrupts()
+{
+    /*
+     * Call the ISRs of all pending interrupts, in the order the peripherals
+     * have been added. Interrupts don't nest.
+     */
+
+    if (!interruptsEnabled || inISR)
+    {
+        return;
+    }
+
+    inISR = true;
+    for (HostPeripheral *peripheral : peripherals)
+    {
+        uint32_t calls = 0;
+        while (interruptsEnabled && peripheral->interruptPending())
+        {
+            if (++calls > MAX_ISR_CALLS)
+            {
+                fprintf(stderr, "ISR doesn't clear its interrupt flag\n");
+                error();
+                break;
+            }
+            peripheral->callISR();
+        }
+    }
+    inISR = false;
+}
+
+
+volatile uint32_t *hostRegister(uint32_t address)
+{
+    /*
+     * Used by the HWREG macro of the host version of inc/hw_types.h.
+     */
+
+    return host.getRegister(address);
+}
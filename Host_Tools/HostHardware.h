@@ -0,0 +1,95 @@
+/*
+ * HostHardware.h
+ *
+ * Virtual hardware which allows to run the code in Common_Classes on a PC.
+ * It provides the time base (a virtual cycle counter), the interrupt handling
+ * and the registers accessed with HWREG. The peripherals (see
+ * HostDriverlib.cpp and MPU6050Emulator.cpp) are attached to it as
+ * HostPeripheral objects.
+ *
+ * Time only passes when the code waits (SysCtlDelay, polling a status
+ * register) or when the host program calls HostHardware::advance. Hence
+ * the results don't depend on the speed of the PC.
+ */
+
+#ifndef HOSTHARDWARE_H_
+#define HOSTHARDWARE_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * map:                     Storage of the registers accessed with HWREG.
+ * vector:                  List of the attached peripherals.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <map>
+#include <vector>
+
+
+class HostPeripheral
+{
+public:
+    HostPeripheral();
+    virtual ~HostPeripheral();
+    virtual uint64_t getNextEvent();
+    virtual void update(uint64_t cycles);
+    virtual bool interruptPending();
+    virtual void callISR();
+
+    // Returned by HostPeripheral::getNextEvent if nothing is scheduled.
+    const static uint64_t NO_EVENT = UINT64_MAX;
+};
+
+
+class HostHardware
+{
+public:
+    HostHardware();
+    virtual ~HostHardware();
+    void addPeripheral(HostPeripheral *peripheral);
+    void removePeripheral(HostPeripheral *peripheral);
+    void setClockFreq(uint32_t freq);
+    uint32_t getClockFreq();
+    uint64_t getCycles();
+    uint64_t getCyclesUS(uint32_t us);
+    double getTime();
+    void advance(uint64_t cycles);
+    void advanceUS(uint32_t us);
+    void advanceTo(uint64_t cycles);
+    bool setInterruptsEnabled(bool enabled);
+    bool getInterruptsEnabled();
+    bool isInISR();
+    volatile uint32_t *getRegister(uint32_t address);
+    void setErrorHandler(void (*handler)(void));
+    void error();
+
+    // Cycles consumed each time the code reads a status register while
+    // polling (f.ex. I2CMasterBusy). Ensures that busy loops make progress.
+    const static uint32_t POLL_CYCLES = 10;
+
+private:
+    void dispatchInterrupts();
+
+    std::vector<HostPeripheral*> peripherals;
+    std::map<uint32_t, uint32_t> registers;
+    uint64_t cycles = 0;
+    uint32_t clockFreq = 16000000; // Precision internal oscillator
+    bool interruptsEnabled = true;
+    bool inISR = false;
+    void (*errorHandler)(void) = 0;
+
+    // An ISR which doesn't clear its interrupt flag would be called forever.
+    const static uint32_t MAX_ISR_CALLS = 1000;
+
+    // Cycle counter of the Data Watchpoint and Trace unit (see
+    // System::getCycles). Reading it returns the virtual time.
+    const uint32_t DWT_CYCCNT_REG = 0xe0001004;
+};
+
+// There's only one microcontroller.
+extern HostHardware host;
+
+
+#endif /* HOSTHARDWARE_H_ */
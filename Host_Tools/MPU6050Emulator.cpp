@@ -0,0 +1,606 @@
+/*
+ * MPU6050Emulator.cpp
+ */
+
+#include "MPU6050Emulator.h"
+#include <string.h>
+#include <math.h>
+
+
+MPU6050Emulator::MPU6050Emulator()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+MPU6050Emulator::~MPU6050Emulator()
+{
+    /*
+     * Detach from the host hardware.
+     */
+
+    if (i2cBase)
+    {
+        hostI2CDetach(i2cBase, this);
+        host.removePeripheral(this);
+    }
+}
+
+void MPU6050Emulator::init(uint32_t i2cBase, bool addressBit, uint32_t seed)
+{
+    /*
+     * Connect the emulated sensor to the bus of the given I2C module. The
+     * sensor is in its reset state (sleep mode) afterwards.
+     *
+     * i2cBase:    Base address of the I2C module.
+     * addressBit: Value of the address pin (AD0).
+     * seed:       Seed of the noise generator. Equal seeds give equal noise.
+     *             Default is 1.
+     */
+
+    this->i2cBase = i2cBase;
+    address = 0b1101000 + addressBit;
+    generator.seed(seed);
+    reset();
+
+    hostI2CAttach(i2cBase, this);
+    host.addPeripheral(this);
+}
+
+void MPU6050Emulator::connectInterruptPin(uint32_t portBase, uint8_t pin)
+{
+    /*
+     * Connect the INT pin of the sensor to a GPIO pin of the
+     * microcontroller. Default is not connected. A portBase of 0 disconnects
+     * it; the GPIO pin keeps its level then.
+     */
+
+    intPortBase = portBase;
+    intPin = pin;
+    setInterruptPin(intPinActive);
+}
+
+void MPU6050Emulator::setAngleRates(float x, float y, float z)
+{
+    /*
+     * Set the true angle rates around the sensor axes in deg/s.
+     */
+
+    angleRates[0] = x;
+    angleRates[1] = y;
+    angleRates[2] = z;
+}
+
+void MPU6050Emulator::setAccels(float x, float y, float z)
+{
+    /*
+     * Set the true accelerations (including gravity) along the sensor axes
+     * in g.
+     */
+
+    accels[0] = x;
+    accels[1] = y;
+    accels[2] = z;
+}
+
+void MPU6050Emulator::setTemperature(float temperature)
+{
+    /*
+     * Set the temperature of the sensor in degree Celsius.
+     */
+
+    this->temperature = temperature;
+}
+
+void MPU6050Emulator::setGyroBias(float x, float y, float z)
+{
+    /*
+     * Set the offsets of the gyroscope axes in deg/s. Default is 0.
+     */
+
+    gyroBias[0] = x;
+    gyroBias[1] = y;
+    gyroBias[2] = z;
+}
+
+void MPU6050Emulator::setAccelBias(float x, float y, float z)
+{
+    /*
+     * Set the offsets of the accelerometer axes in g. Default is 0.
+     */
+
+    accelBias[0] = x;
+    accelBias[1] = y;
+    accelBias[2] = z;
+}
+
+void MPU6050Emulator::setNoise(float angleRateNoise, float accelNoise)
+{
+    /*
+     * Set the standard deviation of the white noise added to each sample.
+     * Default is no noise.
+     *
+     * angleRateNoise: Noise of the gyroscope in deg/s.
+     * accelNoise:     Noise of the accelerometer in g.
+     */
+
+    this->angleRateNoise = angleRateNoise;
+    this->accelNoise = accelNoise;
+}
+
+void MPU6050Emulator::setLatencyUS(uint32_t us)
+{
+    /*
+     * Set the time between measuring a sample and updating the registers,
+     * in addition to the delay of the digital low pass filter. Default is 0.
+     */
+
+    latencyUS = us;
+}
+
+uint32_t MPU6050Emulator::getSampleRate()
+{
+    /*
+     * Returns the sample rate in Hz as configured by CONFIG and SMPLRT_DIV.
+     */
+
+    uint8_t dlpf = registers[REG_CONFIG] & 0x07;
+    uint32_t gyroRate = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+    return gyroRate / (1 + registers[REG_SMPLRT_DIV]);
+}
+
+uint32_t MPU6050Emulator::getSamples()
+{
+    /*
+     * Returns the number of samples written to the registers.
+     */
+
+    return samples;
+}
+
+uint32_t MPU6050Emulator::getTransactions()
+{
+    /*
+     * Returns the number of transactions (start conditions with the address
+     * of this sensor).
+     */
+
+    return transactions;
+}
+
+uint32_t MPU6050Emulator::getBytesRead()
+{
+    return bytesRead;
+}
+
+uint32_t MPU6050Emulator::getBytesWritten()
+{
+    return bytesWritten;
+}
+
+uint32_t MPU6050Emulator::getFIFOOverflows()
+{
+    return fifoOverflows;
+}
+
+void MPU6050Emulator::resetCounters()
+{
+    samples = 0;
+    transactions = 0;
+    bytesRead = 0;
+    bytesWritten = 0;
+    fifoOverflows = 0;
+}
+
+uint8_t MPU6050Emulator::peekRegister(uint8_t reg)
+{
+    /*
+     * Returns the value of a register without the side effects of reading
+     * it over the bus.
+     */
+
+    return registers[reg & 0x7f];
+}
+
+bool MPU6050Emulator::start(uint8_t address, bool receive)
+{
+    /*
+     * A write transfer starts with the register address, a read transfer
+     * continues at the current register address.
+     */
+
+    if (address != this->address)
+    {
+        return false;
+    }
+
+    transactions++;
+    addressPending = !receive;
+
+    // A burst read gets the sensor values of a single sample, even if a new
+    // one is published meanwhile. The registers read over the bus are only
+    // updated while it's idle (see MPU-6050 Register Map page 29).
+    if (receive)
+    {
+        memcpy(shadowRegisters, &registers[REG_ACCEL_XOUT_H], SAMPLE_BYTES);
+    }
+    burstRead = receive;
+    return true;
+}
+
+bool MPU6050Emulator::write(uint8_t data)
+{
+    bytesWritten++;
+    if (addressPending)
+    {
+        registerAddress = data & 0x7f;
+        addressPending = false;
+        return true;
+    }
+
+    writeRegister(registerAddress, data);
+
+    // The register address is incremented after each byte, except for the
+    // FIFO.
+    if (registerAddress != REG_FIFO_R_W)
+    {
+        registerAddress = (registerAddress + 1) & 0x7f;
+    }
+    return true;
+}
+
+uint8_t MPU6050Emulator::read()
+{
+    bytesRead++;
+    uint8_t val = readRegister(registerAddress);
+    if (burstRead && registerAddress >= REG_ACCEL_XOUT_H
+        && registerAddress <= REG_GYRO_ZOUT_L)
+    {
+        val = shadowRegisters[registerAddress - REG_ACCEL_XOUT_H];
+    }
+
+    // The register address is incremented after each byte, except for the
+    // FIFO.
+    if (registerAddress != REG_FIFO_R_W)
+    {
+        registerAddress = (registerAddress + 1) & 0x7f;
+    }
+    return val;
+}
+
+void MPU6050Emulator::stop()
+{
+    burstRead = false;
+}
+
+uint64_t MPU6050Emulator::getNextEvent()
+{
+    uint64_t next = intPulseEndCycles;
+    if (!(registers[REG_PWR_MGMT_1] & PWR_MGMT_1_SLEEP)
+        && nextSampleCycles < next)
+    {
+        next = nextSampleCycles;
+    }
+    if (!pendingSamples.empty() && pendingSamples.front().publishCycles < next)
+    {
+        next = pendingSamples.front().publishCycles;
+    }
+    return next;
+}
+
+void MPU6050Emulator::update(uint64_t cycles)
+{
+    /*
+     * Take the samples which are due, publish those whose latency passed and
+     * end the pulse on the INT pin.
+     */
+
+    if (!(registers[REG_PWR_MGMT_1] & PWR_MGMT_1_SLEEP))
+    {
+        while (nextSampleCycles <= cycles)
+        {
+            takeSample(nextSampleCycles);
+            nextSampleCycles += getSamplePeriod();
+        }
+    }
+
+    while (!pendingSamples.empty()
+           && pendingSamples.front().publishCycles <= cycles)
+    {
+        publishSample(pendingSamples.front().values);
+        pendingSamples.pop_front();
+    }
+
+    if (intPulseEndCycles <= cycles)
+    {
+        intPulseEndCycles = NO_EVENT;
+        setInterruptPin(false);
+    }
+}
+
+void MPU6050Emulator::reset()
+{
+    /*
+     * Reset all registers to their default values (see MPU-6050 Register Map
+     * page 8), clear the FIFO and drop all pending samples.
+     */
+
+    memset(registers, 0, sizeof(registers));
+    registers[REG_PWR_MGMT_1] = PWR_MGMT_1_SLEEP;
+    registers[REG_WHO_AM_I] = 0b1101000;
+    registerAddress = 0;
+    addressPending = false;
+
+    fifoStart = 0;
+    fifoCount = 0;
+    pendingSamples.clear();
+    intPulseEndCycles = NO_EVENT;
+    setInterruptPin(false);
+}
+
+void MPU6050Emulator::takeSample(uint64_t cycles)
+{
+    /*
+     * Measure the current movement and queue the sample until its latency
+     * has passed. The values are stored in the order of the registers
+     * ACCEL_XOUT_H to GYRO_ZOUT_L.
+     *
+     * cycles: Time of the measurement.
+     */
+
+    // Full scale ranges (see MPU-6050 Register Map pages 14 and 15)
+    float accelLSB = 16384.0f / (1 << ((registers[REG_ACCEL_CONFIG] >> 3) & 3));
+    float gyroLSB = 131.0f / (1 << ((registers[REG_GYRO_CONFIG] >> 3) & 3));
+
+    int16_t raw[SAMPLE_BYTES / 2];
+    for (uint8_t axis = 0; axis < 3; axis++)
+    {
+        raw[axis] = toRaw(accels[axis] + accelBias[axis]
+                          + accelNoise * normal(generator), accelLSB);
+        raw[4 + axis] = toRaw(angleRates[axis] + gyroBias[axis]
+                              + angleRateNoise * normal(generator), gyroLSB);
+    }
+
+    // See MPU-6050 Register Map page 30.
+    raw[3] = toRaw(temperature - 36.53f, 340.0f);
+
+    PendingSample sample;
+    sample.publishCycles = cycles
+                           + host.getCyclesUS(latencyUS + getFilterDelayUS());
+    for (uint8_t i = 0; i < SAMPLE_BYTES / 2; i++)
+    {
+        sample.values[2 * i]     = (uint16_t) raw[i] >> 8;
+        sample.values[2 * i + 1] = (uint16_t) raw[i] & 0xff;
+    }
+    pendingSamples.push_back(sample);
+}
+
+void MPU6050Emulator::publishSample(const uint8_t *values)
+{
+    /*
+     * Update the sensor registers, the FIFO and the interrupt status.
+     */
+
+    memcpy(&registers[REG_ACCEL_XOUT_H], values, SAMPLE_BYTES);
+    samples++;
+
+    if (registers[REG_USER_CTRL] & USER_CTRL_FIFO_EN)
+    {
+        pushFIFO(values);
+    }
+    setInterruptStatus(INT_DATA_RDY);
+}
+
+void MPU6050Emulator::pushFIFO(const uint8_t *values)
+{
+    /*
+     * Store the values selected by FIFO_EN in the FIFO, in the order of the
+     * registers. If the FIFO is full, the oldest bytes are overwritten (see
+     * MPU-6050 Register Map page 27).
+     */
+
+    const uint8_t selection[SAMPLE_BYTES / 2] = {
+        FIFO_EN_ACCEL, FIFO_EN_ACCEL, FIFO_EN_ACCEL, FIFO_EN_TEMP,
+        FIFO_EN_XG, FIFO_EN_YG, FIFO_EN_ZG
+    };
+
+    bool overflow = false;
+    for (uint8_t i = 0; i < SAMPLE_BYTES; i++)
+    {
+        if (!(registers[REG_FIFO_EN] & selection[i / 2]))
+        {
+            continue;
+        }
+
+        if (fifoCount == FIFO_SIZE)
+        {
+            fifoStart = (fifoStart + 1) % FIFO_SIZE;
+            fifoCount--;
+            overflow = true;
+        }
+        fifo[(fifoStart + fifoCount) % FIFO_SIZE] = values[i];
+        fifoCount++;
+    }
+
+    if (overflow)
+    {
+        fifoOverflows++;
+        setInterruptStatus(INT_FIFO_OFLOW);
+    }
+}
+
+void MPU6050Emulator::setInterruptStatus(uint8_t status)
+{
+    /*
+     * Set bits in INT_STATUS and activate the INT pin if one of them is
+     * enabled. Without latching, the pin only generates a 50us pulse.
+     */
+
+    registers[REG_INT_STATUS] |= status;
+    if (status & registers[REG_INT_ENABLE])
+    {
+        setInterruptPin(true);
+        if (!(registers[REG_INT_PIN_CFG] & INT_PIN_CFG_LATCH))
+        {
+            intPulseEndCycles = host.getCycles()
+                                + host.getCyclesUS(INT_PULSE_US);
+        }
+    }
+}
+
+void MPU6050Emulator::clearInterruptStatus()
+{
+    /*
+     * Clear INT_STATUS, which also ends a latched interrupt.
+     */
+
+    registers[REG_INT_STATUS] = 0;
+    if (registers[REG_INT_PIN_CFG] & INT_PIN_CFG_LATCH)
+    {
+        setInterruptPin(false);
+    }
+}
+
+void MPU6050Emulator::setInterruptPin(bool active)
+{
+    /*
+     * Drive the INT pin. It's active high unless INT_LEVEL is set.
+     */
+
+    intPinActive = active;
+    if (intPortBase)
+    {
+        bool activeLow = registers[REG_INT_PIN_CFG] & INT_PIN_CFG_LEVEL;
+        hostGPIOSetInput(intPortBase, intPin, active != activeLow);
+    }
+}
+
+uint8_t MPU6050Emulator::readRegister(uint8_t reg)
+{
+    /*
+     * Read a register over the bus, including the side effects of reading
+     * INT_STATUS and FIFO_R_W.
+     */
+
+    uint8_t val = registers[reg];
+    if (reg == REG_FIFO_COUNTH)
+    {
+        val = fifoCount >> 8;
+    }
+    else if (reg == REG_FIFO_COUNTL)
+    {
+        val = fifoCount & 0xff;
+    }
+    else if (reg == REG_FIFO_R_W)
+    {
+        // Reading an empty FIFO returns no valid data.
+        val = 0xff;
+        if (fifoCount)
+        {
+            val = fifo[fifoStart];
+            fifoStart = (fifoStart + 1) % FIFO_SIZE;
+            fifoCount--;
+        }
+    }
+
+    if (reg == REG_INT_STATUS
+        || (registers[REG_INT_PIN_CFG] & INT_PIN_CFG_RD_CLEAR))
+    {
+        clearInterruptStatus();
+    }
+
+    return val;
+}
+
+void MPU6050Emulator::writeRegister(uint8_t reg, uint8_t val)
+{
+    /*
+     * Write a register over the bus. Writes to read-only registers are
+     * ignored.
+     */
+
+    if (reg == REG_INT_STATUS || reg == REG_WHO_AM_I
+        || reg == REG_FIFO_COUNTH || reg == REG_FIFO_COUNTL
+        || reg == REG_FIFO_R_W
+        || (reg >= REG_ACCEL_XOUT_H && reg <= REG_GYRO_ZOUT_L))
+    {
+        return;
+    }
+
+    if (reg == REG_PWR_MGMT_1)
+    {
+        if (val & PWR_MGMT_1_RESET)
+        {
+            reset();
+            return;
+        }
+
+        // The first sample is taken one sample period after waking up.
+        if ((registers[reg] & PWR_MGMT_1_SLEEP) && !(val & PWR_MGMT_1_SLEEP))
+        {
+            nextSampleCycles = host.getCycles() + getSamplePeriod();
+        }
+    }
+    else if (reg == REG_USER_CTRL)
+    {
+        if (val & USER_CTRL_FIFO_RESET)
+        {
+            fifoStart = 0;
+            fifoCount = 0;
+        }
+
+        // The reset bits clear themselves.
+        val &= ~0x07;
+    }
+    else if (reg == REG_SMPLRT_DIV && val != registers[reg])
+    {
+        // The queue only models the delay of the filter. The real sensor
+        // doesn't output the samples taken at the old rate (and their data
+        // ready interrupts) after the rate changed.
+        pendingSamples.clear();
+    }
+
+    registers[reg] = val;
+
+    if (reg == REG_INT_PIN_CFG)
+    {
+        setInterruptPin(intPinActive);
+    }
+}
+
+uint64_t MPU6050Emulator::getSamplePeriod()
+{
+    /*
+     * Returns the sample period in CPU cycles.
+     */
+
+    uint8_t dlpf = registers[REG_CONFIG] & 0x07;
+    uint32_t gyroRate = (dlpf == 0 || dlpf == 7) ? 8000 : 1000;
+    return (uint64_t) host.getClockFreq() * (1 + registers[REG_SMPLRT_DIV])
+           / gyroRate;
+}
+
+uint32_t MPU6050Emulator::getFilterDelayUS()
+{
+    return DLPF_DELAY[registers[REG_CONFIG] & 0x07];
+}
+
+int16_t MPU6050Emulator::toRaw(float value, float lsbPerUnit)
+{
+    /*
+     * Convert a value to its raw representation and saturate it like the
+     * sensor does.
+     */
+
+    float raw = roundf(value * lsbPerUnit);
+    if (raw > 32767.0f)
+    {
+        return 32767;
+    }
+    if (raw < -32768.0f)
+    {
+        return -32768;
+    }
+    return (int16_t) raw;
+}
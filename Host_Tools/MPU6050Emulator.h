@@ -0,0 +1,178 @@
+/*
+ * MPU6050Emulator.h
+ *
+ * Register level emulation of an MPU6050 on the I2C bus of the host hardware
+ * (see HostDriverlib.h). The MPU6050 class in Common_Classes talks to it via
+ * the same driverlib calls it uses on the microcontroller.
+ *
+ * Modelled are:
+ *  - the register map including WHO_AM_I, reset values and the automatic
+ *    increment of the register address during bursts (except for FIFO_R_W),
+ *    which read the sensor values of a single sample,
+ *  - sampling with the rate given by CONFIG and SMPLRT_DIV, the full scale
+ *    ranges and the sleep mode,
+ *  - the FIFO (including overflows) and the INT pin with data ready and FIFO
+ *    overflow interrupts,
+ *  - noise, bias and latency of the measurements. The digital low pass
+ *    filter is modelled by its delay only.
+ * The movement of the sensor is given by setting its angle rates,
+ * accelerations and temperature.
+ */
+
+#ifndef MPU6050EMULATOR_H_
+#define MPU6050EMULATOR_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * deque:                   Samples waiting for their latency to pass.
+ * random:                  Noise generator.
+ * HostDriverlib.h:         I2C device interface and GPIO access.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include <deque>
+#include <random>
+#include "HostDriverlib.h"
+
+
+class MPU6050Emulator : public HostI2CDevice, public HostPeripheral
+{
+public:
+    MPU6050Emulator();
+    virtual ~MPU6050Emulator();
+    void init(uint32_t i2cBase, bool addressBit, uint32_t seed = 1);
+    void connectInterruptPin(uint32_t portBase, uint8_t pin);
+    void setAngleRates(float x, float y, float z);
+    void setAccels(float x, float y, float z);
+    void setTemperature(float temperature);
+    void setGyroBias(float x, float y, float z);
+    void setAccelBias(float x, float y, float z);
+    void setNoise(float angleRateNoise, float accelNoise);
+    void setLatencyUS(uint32_t us);
+    uint32_t getSampleRate();
+    uint32_t getSamples();
+    uint32_t getTransactions();
+    uint32_t getBytesRead();
+    uint32_t getBytesWritten();
+    uint32_t getFIFOOverflows();
+    void resetCounters();
+    uint8_t peekRegister(uint8_t reg);
+
+    // HostI2CDevice
+    bool start(uint8_t address, bool receive);
+    bool write(uint8_t data);
+    uint8_t read();
+    void stop();
+
+    // HostPeripheral
+    uint64_t getNextEvent();
+    void update(uint64_t cycles);
+
+private:
+    void reset();
+    void takeSample(uint64_t cycles);
+    void publishSample(const uint8_t *values);
+    void pushFIFO(const uint8_t *values);
+    void setInterruptStatus(uint8_t status);
+    void clearInterruptStatus();
+    void setInterruptPin(bool active);
+    uint8_t readRegister(uint8_t reg);
+    void writeRegister(uint8_t reg, uint8_t val);
+    uint64_t getSamplePeriod();
+    uint32_t getFilterDelayUS();
+    int16_t toRaw(float value, float lsbPerUnit);
+
+    uint8_t address = 0;
+    uint32_t i2cBase = 0;
+    uint8_t registers[128] = {0};
+    uint8_t registerAddress = 0;
+    bool addressPending = false; // next written byte is a register address
+    bool burstRead = false;      // read transfer running
+
+    // True sensor movement and the errors added to it
+    float angleRates[3] = {0.0f, 0.0f, 0.0f};  // [deg/s]
+    float accels[3] = {0.0f, 0.0f, 1.0f};      // [g]
+    float temperature = 25.0f;                 // [degree Celsius]
+    float gyroBias[3] = {0.0f, 0.0f, 0.0f};    // [deg/s]
+    float accelBias[3] = {0.0f, 0.0f, 0.0f};   // [g]
+    float angleRateNoise = 0.0f;               // standard deviation [deg/s]
+    float accelNoise = 0.0f;                   // standard deviation [g]
+    uint32_t latencyUS = 0;
+    std::mt19937 generator;
+    std::normal_distribution<float> normal;
+
+    // Sampling. Samples are published after the latency has passed.
+    const static uint8_t SAMPLE_BYTES = 14;
+    struct PendingSample
+    {
+        uint64_t publishCycles;
+        uint8_t values[SAMPLE_BYTES];
+    };
+    std::deque<PendingSample> pendingSamples;
+    uint8_t shadowRegisters[SAMPLE_BYTES]; // sample of a running burst read
+    uint64_t nextSampleCycles = 0;
+
+    // FIFO as ring buffer
+    const static uint16_t FIFO_SIZE = 1024;
+    uint8_t fifo[FIFO_SIZE];
+    uint16_t fifoStart = 0;
+    uint16_t fifoCount = 0;
+
+    // INT pin
+    uint32_t intPortBase = 0;
+    uint8_t intPin = 0;
+    bool intPinActive = false;
+    uint64_t intPulseEndCycles = NO_EVENT;
+    const static uint32_t INT_PULSE_US = 50;
+
+    // Counters
+    uint32_t samples = 0;
+    uint32_t transactions = 0;
+    uint32_t bytesRead = 0;
+    uint32_t bytesWritten = 0;
+    uint32_t fifoOverflows = 0;
+
+    // Delay of the digital low pass filter settings DLPF_CFG 0-7 in us
+    // (gyroscope, see MPU-6050 Register Map page 13).
+    const uint16_t DLPF_DELAY[8] = {980, 1900, 2800, 4800, 8300, 13400, 18600,
+                                    980};
+
+    // Register addresses (see MPU-6050 Register Map)
+    const uint8_t REG_SMPLRT_DIV   = 0x19;
+    const uint8_t REG_CONFIG       = 0x1a;
+    const uint8_t REG_GYRO_CONFIG  = 0x1b;
+    const uint8_t REG_ACCEL_CONFIG = 0x1c;
+    const uint8_t REG_FIFO_EN      = 0x23;
+    const uint8_t REG_INT_PIN_CFG  = 0x37;
+    const uint8_t REG_INT_ENABLE   = 0x38;
+    const uint8_t REG_INT_STATUS   = 0x3a;
+    const uint8_t REG_ACCEL_XOUT_H = 0x3b;
+    const uint8_t REG_GYRO_ZOUT_L  = 0x48;
+    const uint8_t REG_USER_CTRL    = 0x6a;
+    const uint8_t REG_PWR_MGMT_1   = 0x6b;
+    const uint8_t REG_FIFO_COUNTH  = 0x72;
+    const uint8_t REG_FIFO_COUNTL  = 0x73;
+    const uint8_t REG_FIFO_R_W     = 0x74;
+    const uint8_t REG_WHO_AM_I     = 0x75;
+
+    // Bits of the registers above
+    const uint8_t FIFO_EN_TEMP          = 0x80;
+    const uint8_t FIFO_EN_XG            = 0x40;
+    const uint8_t FIFO_EN_YG            = 0x20;
+    const uint8_t FIFO_EN_ZG            = 0x10;
+    const uint8_t FIFO_EN_ACCEL         = 0x08;
+    const uint8_t INT_PIN_CFG_LEVEL     = 0x80;
+    const uint8_t INT_PIN_CFG_LATCH     = 0x20;
+    const uint8_t INT_PIN_CFG_RD_CLEAR  = 0x10;
+    const uint8_t INT_DATA_RDY          = 0x01;
+    const uint8_t INT_FIFO_OFLOW        = 0x10;
+    const uint8_t USER_CTRL_FIFO_EN     = 0x40;
+    const uint8_t USER_CTRL_FIFO_RESET  = 0x04;
+    const uint8_t PWR_MGMT_1_RESET      = 0x80;
+    const uint8_t PWR_MGMT_1_SLEEP      = 0x40;
+};
+
+
+#endif /* MPU6050EMULATOR_H_ */
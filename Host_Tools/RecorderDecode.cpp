@@ -0,0 +1,213 @@
+/*
+ * RecorderDecode.cpp
+ *
+ * Converts dumps of the black box (see FlightRecorder.h) captured from the
+ * USB UART to a timeline in CSV: one line per update with the time in
+ * seconds relative to the freeze (negative before it), the raw sensor
+ * values, the estimated angle, the torque, the duty cycles, the steering,
+ * the voltage at the battery ADC pin, the duration of the previous update
+ * and the interval to the previous record. Records added after the freeze
+ * (f.ex. the fall itself) are marked in the last column.
+ * Dumps with a wrong CRC are skipped. If the capture contains several
+ * dumps, each is written with its own header line. A summary of each dump
+ * (reason of the freeze, duration, maximum angle, longest interval) is
+ * printed to stderr.
+ *
+ * Capture: send "b" via the Serial Monitor (see System::handleRequests)
+ * after a fall or an error and capture the USB UART, f.ex. on Linux:
+ *     stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > blackbox.bin
+ * SegwaySim requests the black box itself if the segway fell.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -IHost_Tools/TivaWare -ICommon_Classes \
+ *         Host_Tools/RecorderDecode.cpp -o RecorderDecode
+ *     ./RecorderDecode [capture file or - for stdin]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "FlightRecorder.h"
+
+
+const uint32_t CRC_SIZE = 2;
+
+const char *REASONS[] = {"running", "fall", "System::error", "request"};
+
+
+bool readInput(const char *path, std::vector<uint8_t> &data)
+{
+    FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if (!file)
+    {
+        perror(path);
+        return false;
+    }
+
+    uint8_t buffer[65536];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        data.insert(data.end(), buffer, buffer + count);
+    }
+    if (file != stdin)
+    {
+        fclose(file);
+    }
+    return true;
+}
+
+void printTimeline(const FlightRecorderHeader &header,
+                   const FlightRecord *records)
+{
+    /*
+     * Write the CSV of one dump and its summary. The cycle counter wraps
+     * around, hence all times are computed from differences.
+     */
+
+    double clock = header.clockFreq;
+    uint32_t count = header.count;
+    uint32_t lastCycles = count ? records[count - 1].cycles : 0;
+
+    printf("time,angle_rate_raw,accel_hor_raw,accel_ver_raw,angle_deg,"
+           "torque,left_duty,right_duty,steering,battery_adc_V,"
+           "last_update_us,interval_ms,after_freeze\n");
+
+    double maxAngle = 0.0, maxInterval = 0.0;
+    uint32_t maxUpdateUS = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const FlightRecord &r = records[i];
+        double time = (int32_t) (r.cycles - header.triggerCycles) / clock;
+        if (header.reason == FLIGHTRECORDER_RUNNING)
+        {
+            time = (int32_t) (r.cycles - lastCycles) / clock;
+        }
+        double interval = i ? (r.cycles - records[i - 1].cycles)
+                              / clock * 1000.0 : 0.0;
+        double angle = r.angle / 100.0;
+        bool after = i + header.afterTrigger >= count;
+
+        printf("%.6f,%d,%d,%d,%.2f,%.4f,%.4f,%.4f,%.4f,%.3f,%u,%.3f,%d\n",
+               time, r.angleRate, r.accelHor, r.accelVer, angle,
+               r.torque / 10000.0, r.leftDuty / 10000.0,
+               r.rightDuty / 10000.0, r.steering / 10000.0,
+               r.battery / 1000.0, r.lastUpdateUS, interval, after ? 1 : 0);
+
+        maxAngle = fmax(maxAngle, fabs(angle));
+        maxInterval = fmax(maxInterval, interval);
+        if (r.lastUpdateUS > maxUpdateUS)
+        {
+            maxUpdateUS = r.lastUpdateUS;
+        }
+    }
+
+    const char *reason = (header.reason < sizeof(REASONS) / sizeof(*REASONS))
+                         ? REASONS[header.reason] : "unknown";
+    fprintf(stderr, "Dump:          frozen by %s", reason);
+    if (header.reason == FLIGHTRECORDER_ERROR)
+    {
+        fprintf(stderr, " (error code %u)", header.errorCode);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Records:       %u at %u Hz (%u after the freeze)\n",
+            count, header.updateFreq, header.afterTrigger);
+    if (count)
+    {
+        fprintf(stderr, "Duration:      %.3f s\n",
+                (lastCycles - records[0].cycles) / clock);
+    }
+    fprintf(stderr, "Max. angle:    %.2f deg\n", maxAngle);
+    fprintf(stderr, "Max. interval: %.3f ms (longest update %u us)\n",
+            maxInterval, maxUpdateUS);
+}
+
+uint32_t decode(const std::vector<uint8_t> &data, uint32_t &crcErrors)
+{
+    /*
+     * Find the dumps by their sync word and check their CRC. Returns the
+     * number of valid dumps.
+     */
+
+    uint32_t dumps = 0;
+    size_t pos = 0;
+    while (pos + sizeof(FlightRecorderHeader) + CRC_SIZE <= data.size())
+    {
+        FlightRecorderHeader header;
+        memcpy(&header, &data[pos], sizeof(header));
+        if (header.sync != FLIGHTRECORDER_SYNC)
+        {
+            pos++;
+            continue;
+        }
+        if (header.version != FLIGHTRECORDER_VERSION
+            || header.recordSize != sizeof(FlightRecord))
+        {
+            fprintf(stderr, "Dump at byte %zu: version %u not supported\n",
+                    pos, header.version);
+            pos++;
+            continue;
+        }
+
+        size_t size = sizeof(header) + header.count * sizeof(FlightRecord);
+        if (pos + size + CRC_SIZE > data.size())
+        {
+            fprintf(stderr, "Dump at byte %zu is incomplete\n", pos);
+            break;
+        }
+
+        uint16_t crc;
+        memcpy(&crc, &data[pos + size], CRC_SIZE);
+        if (crc != debugFrameCRC(0xffff, &data[pos], size))
+        {
+            crcErrors++;
+            pos++;
+            continue;
+        }
+
+        std::vector<FlightRecord> records(header.count);
+        memcpy(records.data(), &data[pos + sizeof(header)],
+               header.count * sizeof(FlightRecord));
+        printTimeline(header, records.data());
+        dumps++;
+        pos += size + CRC_SIZE;
+    }
+    return dumps;
+}
+
+
+int main(int argc, char *argv[])
+{
+    const char *input = "-";
+    if (argc > 2 || (argc == 2 && argv[1][0] == '-' && argv[1][1]))
+    {
+        fprintf(stderr, "Usage: %s [capture file or - for stdin]\n",
+                argv[0]);
+        return 2;
+    }
+    if (argc == 2)
+    {
+        input = argv[1];
+    }
+
+    std::vector<uint8_t> data;
+    if (!readInput(input, data))
+    {
+        return 2;
+    }
+
+    uint32_t crcErrors = 0;
+    uint32_t dumps = decode(data, crcErrors);
+    if (crcErrors)
+    {
+        fprintf(stderr, "%u dump(s) with a wrong CRC skipped\n", crcErrors);
+    }
+    if (!dumps)
+    {
+        fprintf(stderr, "No black box found\n");
+    }
+
+    return (dumps && !crcErrors) ? 0 : 1;
+}
@@ -0,0 +1,425 @@
+/*
+ * RideReplay.cpp
+ *
+ * Replays ride logs (see RideLog.h) through the current Controller class
+ * and compares its outputs with the recorded ones. This shows whether a
+ * change of the controller (f.ex. fixed point arithmetic or faster math
+ * functions) changes its behavior. By default the outputs must be bit
+ * exact; a tolerance can be given instead.
+ * For each log the number of updates, the differing ones, the largest
+ * difference, the update intervals of the ride and the replay speed are
+ * printed. Optionally the outputs and differences of all updates are
+ * written to <log>.deltas.csv.
+ * The logs are memory mapped, so long rides replay at the speed of the
+ * controller. If a directory is given, all *.rlog files in it are replayed
+ * in parallel, each by its own thread with its own controller.
+ * The controller is compiled with the parameter set and estimator of
+ * Config.h; a log recorded with another update frequency is reported. The
+ * recorded update periods are handed to the controller, which uses them
+ * with CFG_CTLR_MEASURED_DT (like on the segway).
+ * The program returns 0 if all logs match, 1 if not and 2 on errors
+ * (including logs without a header or without records).
+ *
+ * Recording: set CFG_RIDELOG_ENABLE in Config.h and capture the USB UART
+ * to a file, f.ex. on Linux:
+ *     stty -F /dev/ttyACM0 115200 raw && cat /dev/ttyACM0 > ride.rlog
+ * SegwaySim writes the UART output to a file as well.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -pthread -IHost_Tools -IHost_Tools/TivaWare \
+ *         -ICommon_Classes Host_Tools/RideReplay.cpp \
+ *         Host_Tools/HostHardware.cpp Host_Tools/HostDriverlib.cpp \
+ *         Common_Classes/Controller.cpp Common_Classes/Estimator.cpp \
+ *         Common_Classes/System.cpp Common_Classes/UARTBuffer.cpp \
+ *         Common_Classes/FlightRecorder.cpp -o RideReplay
+ *     ./RideReplay [-t tolerance] [-j threads] [-d] <log file or directory>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "Config.h"
+#include "System.h"
+#include "Controller.h"
+#include "RideLog.h"
+
+
+struct ReplayResult
+{
+    bool error;                 // log couldn't be read
+    uint32_t segments;          // headers (power ups)
+    uint64_t updates;
+    uint64_t mismatches;        // outputs differing more than the tolerance
+    uint64_t firstMismatch;     // index of the first one
+    uint64_t skippedBytes;      // outside of records (f.ex. lost bytes)
+    uint64_t overflows;         // records lost on the segway
+    bool wrongFreq;             // recorded with another update frequency
+    double maxDelta;
+    double squaredDelta;
+    double rideTime;            // [s]
+    double minInterval;         // [s] between two updates
+    double maxInterval;         // [s]
+    double replayTime;          // [s]
+};
+
+
+struct Options
+{
+    double tolerance = 0.0;     // 0: bit exact
+    uint32_t threads = 0;       // 0: all cores
+    bool writeDeltas = false;
+};
+
+
+bool isMismatch(float replayed, float logged, double tolerance)
+{
+    if (tolerance > 0.0)
+    {
+        return fabs(replayed - logged) > tolerance;
+    }
+    return memcmp(&replayed, &logged, sizeof(float)) != 0;
+}
+
+ReplayResult replay(const std::string &path, const Options &options)
+{
+    /*
+     * Replay one log. Uses only local objects, so several logs can be
+     * replayed at the same time.
+     */
+
+    ReplayResult result = {};
+    result.minInterval = INFINITY;
+
+    int file = open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || fstat(file, &status) != 0)
+    {
+        fprintf(stderr, "%s: can't open\n", path.c_str());
+        result.error = true;
+        if (file >= 0)
+        {
+            close(file);
+        }
+        return result;
+    }
+    size_t size = status.st_size;
+    const uint8_t *data = 0;
+    if (size > 0)
+    {
+        void *mapping = mmap(0, size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (mapping == MAP_FAILED)
+        {
+            fprintf(stderr, "%s: can't map\n", path.c_str());
+            close(file);
+            result.error = true;
+            return result;
+        }
+        data = (const uint8_t *) mapping;
+        madvise(mapping, size, MADV_SEQUENTIAL);
+    }
+
+    FILE *deltas = 0;
+    if (options.writeDeltas)
+    {
+        deltas = fopen((path + ".deltas.csv").c_str(), "w");
+        if (deltas)
+        {
+            fprintf(deltas, "update,time,left_logged,left_replayed,"
+                    "left_delta,right_logged,right_replayed,right_delta\n");
+        }
+    }
+
+    System sys;
+    sys.setDebugging(false);
+    Controller<CFG_CTLR_PARAMS, CFG_CTLR_ESTIMATOR> controller;
+    bool initialized = false;
+    double clockFreq = 1.0;
+    uint32_t lastCycles = 0;
+    double time = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    size_t offset = 0;
+    while (offset + sizeof(uint32_t) <= size)
+    {
+        uint32_t sync;
+        memcpy(&sync, data + offset, sizeof(sync));
+
+        if (sync == RIDELOG_HEADER_SYNC
+            && offset + sizeof(RideLogHeader) <= size)
+        {
+            // Power up of the segway: start with a new controller.
+            RideLogHeader header;
+            memcpy(&header, data + offset, sizeof(header));
+            offset += sizeof(header);
+            if (header.version != RIDELOG_VERSION)
+            {
+                fprintf(stderr, "%s: unsupported version %u\n",
+                        path.c_str(), header.version);
+                result.error = true;
+                break;
+            }
+            result.wrongFreq |= (header.updateFreq != CFG_CTLR_UPDATE_FREQ);
+            controller = Controller<CFG_CTLR_PARAMS, CFG_CTLR_ESTIMATOR>();
+            controller.init(&sys, header.maxSpeed);
+            controller.setSensorDelayUS(header.sensorDelayUS);
+            clockFreq = header.clockFreq;
+            initialized = true;
+            lastCycles = 0;
+            result.segments++;
+            continue;
+        }
+
+        if (sync != RIDELOG_RECORD_SYNC || !initialized
+            || offset + sizeof(RideLogRecord) > size)
+        {
+            offset++;
+            result.skippedBytes++;
+            continue;
+        }
+
+        RideLogRecord record;
+        memcpy(&record, data + offset, sizeof(record));
+        offset += sizeof(record);
+
+        if (record.flags & RIDELOG_RESET)
+        {
+            controller.resetSpeeds();
+        }
+        if (record.flags & RIDELOG_OVERFLOW)
+        {
+            result.overflows++;
+        }
+        controller.setUpdatePeriodUS(record.periodUS);
+        if (record.flags & RIDELOG_RAW_VALUES)
+        {
+            controller.updateValuesRaw(record.steering,
+                                       (int32_t) record.angleRate,
+                                       (int32_t) record.accelHor,
+                                       (int32_t) record.accelVer);
+        }
+        else
+        {
+            controller.updateValuesRad(record.steering, record.angleRate,
+                                       record.accelHor, record.accelVer);
+        }
+        float left = controller.getLeftSpeed();
+        float right = controller.getRightSpeed();
+
+        // Timing of the ride. The cycle counter wraps around.
+        if (lastCycles != 0)
+        {
+            double interval = (uint32_t) (record.cycles - lastCycles)
+                              / clockFreq;
+            time += interval;
+            result.minInterval = fmin(result.minInterval, interval);
+            result.maxInterval = fmax(result.maxInterval, interval);
+        }
+        lastCycles = record.cycles;
+
+        // Differences
+        double deltaLeft = (double) left - record.leftSpeed;
+        double deltaRight = (double) right - record.rightSpeed;
+        if (isMismatch(left, record.leftSpeed, options.tolerance)
+            || isMismatch(right, record.rightSpeed, options.tolerance))
+        {
+            if (result.mismatches == 0)
+            {
+                result.firstMismatch = result.updates;
+            }
+            result.mismatches++;
+        }
+        double delta = fmax(fabs(deltaLeft), fabs(deltaRight));
+        result.maxDelta = fmax(result.maxDelta, delta);
+        result.squaredDelta += delta * delta;
+        if (deltas)
+        {
+            fprintf(deltas, "%llu,%.6f,%.9g,%.9g,%.3g,%.9g,%.9g,%.3g\n",
+                    (unsigned long long) result.updates, time,
+                    record.leftSpeed, left, deltaLeft, record.rightSpeed,
+                    right, deltaRight);
+        }
+        result.updates++;
+    }
+    result.replayTime = std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - start).count();
+    result.rideTime = time;
+
+    // A truncated capture must not pass as identical.
+    if (!result.error && (result.segments == 0 || result.updates == 0))
+    {
+        fprintf(stderr, "%s: no %s\n", path.c_str(),
+                result.segments ? "records" : "header");
+        result.error = true;
+    }
+
+    if (deltas)
+    {
+        fclose(deltas);
+    }
+    if (data)
+    {
+        munmap((void *) data, size);
+    }
+    close(file);
+    return result;
+}
+
+std::vector<std::string> getLogs(const char *path)
+{
+    /*
+     * Returns the given file or all *.rlog files of the given directory
+     * (sorted by name).
+     */
+
+    std::vector<std::string> logs;
+    struct stat status;
+    if (stat(path, &status) != 0 || !S_ISDIR(status.st_mode))
+    {
+        logs.push_back(path);
+        return logs;
+    }
+
+    DIR *directory = opendir(path);
+    if (!directory)
+    {
+        return logs;
+    }
+    while (struct dirent *entry = readdir(directory))
+    {
+        std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".rlog") == 0)
+        {
+            logs.push_back(std::string(path) + "/" + name);
+        }
+    }
+    closedir(directory);
+    std::sort(logs.begin(), logs.end());
+    return logs;
+}
+
+void printResult(const std::string &path, const ReplayResult &result)
+{
+    if (result.error)
+    {
+        printf("%s: ERROR\n", path.c_str());
+        return;
+    }
+
+    printf("%s: %llu updates in %u segment(s), %s\n", path.c_str(),
+           (unsigned long long) result.updates, result.segments,
+           result.mismatches ? "DIFFERENT" : "identical");
+    if (result.mismatches)
+    {
+        printf("    %llu differing updates (first: %llu), max. delta %.3g, "
+               "RMS %.3g\n", (unsigned long long) result.mismatches,
+               (unsigned long long) result.firstMismatch, result.maxDelta,
+               sqrt(result.squaredDelta / result.updates));
+    }
+    if (result.updates > 1)
+    {
+        printf("    ride %.1f s, update interval %.3f to %.3f ms, replay "
+               "%.1f ns per update (%.0fx real time)\n", result.rideTime,
+               result.minInterval * 1e3, result.maxInterval * 1e3,
+               result.replayTime * 1e9 / result.updates,
+               result.rideTime / fmax(result.replayTime, 1e-9));
+    }
+    if (result.skippedBytes || result.overflows)
+    {
+        printf("    %llu bytes outside of records, %llu buffer overflows on "
+               "the segway\n", (unsigned long long) result.skippedBytes,
+               (unsigned long long) result.overflows);
+    }
+    if (result.wrongFreq)
+    {
+        printf("    recorded with another update frequency than %d Hz\n",
+               CFG_CTLR_UPDATE_FREQ);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    const char *path = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc)
+        {
+            options.tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+        {
+            options.threads = strtoul(argv[++i], 0, 10);
+        }
+        else if (strcmp(argv[i], "-d") == 0)
+        {
+            options.writeDeltas = true;
+        }
+        else
+        {
+            path = argv[i];
+        }
+    }
+    if (!path)
+    {
+        fprintf(stderr, "Usage: %s [-t tolerance] [-j threads] [-d] <log file "
+                "or directory>\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> logs = getLogs(path);
+    if (logs.empty())
+    {
+        fprintf(stderr, "No *.rlog files in %s\n", path);
+        return 2;
+    }
+
+    // Each thread takes the next log until all are replayed.
+    uint32_t threads = options.threads ? options.threads
+                                       : std::thread::hardware_concurrency();
+    threads = std::max(1u, std::min<uint32_t>(threads, logs.size()));
+    std::vector<ReplayResult> results(logs.size());
+    std::atomic<uint32_t> next(0);
+    auto worker = [&]()
+    {
+        for (uint32_t i = next++; i < logs.size(); i = next++)
+        {
+            results[i] = replay(logs[i], options);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threads; i++)
+    {
+        workers.emplace_back(worker);
+    }
+    for (std::thread &thread : workers)
+    {
+        thread.join();
+    }
+
+    int status = 0;
+    for (uint32_t i = 0; i < logs.size(); i++)
+    {
+        printResult(logs[i], results[i]);
+        if (results[i].error)
+        {
+            status = 2;
+        }
+        else if (results[i].mismatches && status == 0)
+        {
+            status = 1;
+        }
+    }
+    return status;
+}
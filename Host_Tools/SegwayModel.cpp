@@ -0,0 +1,333 @@
+/*
+ * SegwayModel.cpp
+ *
+ * Physical model of a segway (see SegwayModel.h).
+ */
+
+#include "SegwayModel.h"
+#include <math.h>
+
+
+SegwayModelParams SegwayModelParams::tivSeg()
+{
+    /*
+     * Segway for one person. Estimated values: rider of 70kg, 24V lead
+     * acid battery, top speed of about 5m/s at full duty cycle.
+     */
+
+    SegwayModelParams params;
+    params.bodyMass = 85.0;
+    params.bodyHeight = 0.9;
+    params.bodyInertia = 6.0;
+    params.yawInertia = 4.0;
+    params.wheelMass = 3.0;
+    params.wheelRadius = 0.24;
+    params.wheelInertia = 0.15;
+    params.trackWidth = 0.6;
+    params.motorTorqueConst = 1.15;
+    params.motorResistance = 0.5;
+    params.motorFriction = 0.05;
+    params.batteryVoltage = 24.0;
+    params.batteryResistance = 0.05;
+    params.sensorHeight = 0.1;
+    return params;
+}
+
+SegwayModelParams SegwayModelParams::miniSeg()
+{
+    /*
+     * Model segway without rider. Estimated values: tall and light body,
+     * geared motors with a top speed of about 2m/s at full duty cycle.
+     */
+
+    SegwayModelParams params;
+    params.bodyMass = 3.0;
+    params.bodyHeight = 0.5;
+    params.bodyInertia = 0.08;
+    params.yawInertia = 0.03;
+    params.wheelMass = 0.3;
+    params.wheelRadius = 0.06;
+    params.wheelInertia = 0.002;
+    params.trackWidth = 0.25;
+    params.motorTorqueConst = 0.72;
+    params.motorResistance = 5.0;
+    params.motorFriction = 0.01;
+    params.batteryVoltage = 24.0;
+    params.batteryResistance = 0.2;
+    params.sensorHeight = 0.05;
+    return params;
+}
+
+
+SegwayModel::SegwayModel()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+SegwayModel::~SegwayModel()
+{
+    /*
+     * Default empty destructor
+     */
+}
+
+void SegwayModel::init(const SegwayModelParams &params, double tilt)
+{
+    /*
+     * Start at rest at the origin with the given tilt.
+     *
+     * params: Properties of the segway (f.ex. SegwayModelParams::tivSeg()).
+     * tilt:   Initial tilt in rad.
+     */
+
+    this->params = params;
+    this->tilt = tilt;
+    tiltRate = tiltAccel = 0.0;
+    position = speed = accel = 0.0;
+    yaw = yawRate = 0.0;
+    duties[0] = duties[1] = 0.0;
+    currents[0] = currents[1] = 0.0;
+    pushForce = 0.0;
+    riderLean = 0.0;
+    batteryVoltage = params.batteryVoltage;
+    energy = 0.0;
+    held = false;
+    fallen = false;
+}
+
+void SegwayModel::setDuties(double left, double right)
+{
+    /*
+     * Set the duty cycles of the H-bridges (-1.0 to 1.0, positive drives
+     * forward). 0.0 means both outputs are off and the motor coasts.
+     */
+
+    duties[0] = left;
+    duties[1] = right;
+}
+
+void SegwayModel::setPushForce(double force)
+{
+    /*
+     * Horizontal force in N acting on the center of mass of the body
+     * (f.ex. a push or wind). Positive pushes forward.
+     */
+
+    pushForce = force;
+}
+
+void SegwayModel::setRiderLean(double lean)
+{
+    /*
+     * Angle in rad by which the rider leans relative to the platform
+     * (positive forward). The center of mass of the body is rotated by this
+     * angle while the sensor keeps the tilt of the platform.
+     */
+
+    riderLean = lean;
+}
+
+void SegwayModel::setHeld(bool held)
+{
+    /*
+     * Hold the body at its current tilt without moving (f.ex. while the
+     * sensor is calibrated). The motors still draw current.
+     */
+
+    this->held = held;
+}
+
+double SegwayModel::getMotorTorque(double duty, double relativeRate,
+                                   double voltage, double &current)
+{
+    /*
+     * Returns the torque of one motor at the wheel and stores its current.
+     * The motor is averaged over the PWM period.
+     *
+     * relativeRate: Angle rate of the wheel relative to the body in rad/s.
+     */
+
+    current = 0.0;
+    if (duty != 0.0)
+    {
+        current = (duty * voltage - params.motorTorqueConst * relativeRate)
+                  / params.motorResistance;
+    }
+    return params.motorTorqueConst * current
+           - params.motorFriction * relativeRate;
+}
+
+void SegwayModel::step(double dt)
+{
+    /*
+     * Advance the model by dt seconds (semi-implicit Euler). The step should
+     * be well below the electrical and mechanical time constants, f.ex.
+     * 100us.
+     */
+
+    const SegwayModelParams &p = params;
+
+    // The battery voltage drops with the current of the last step.
+    double batteryCurrent = duties[0] * currents[0] + duties[1] * currents[1];
+    batteryVoltage = p.batteryVoltage - p.batteryResistance * batteryCurrent;
+
+    // Motors. The stators turn with the body.
+    double halfTrack = 0.5 * p.trackWidth;
+    double wheelRates[2] = {(speed - yawRate * halfTrack) / p.wheelRadius,
+                            (speed + yawRate * halfTrack) / p.wheelRadius};
+    double torques[2];
+    for (uint8_t i = 0; i < 2; i++)
+    {
+        torques[i] = getMotorTorque(duties[i], wheelRates[i] - tiltRate,
+                                    batteryVoltage, currents[i]);
+        energy += duties[i] * batteryVoltage * currents[i] * dt;
+    }
+
+    if (held || fallen)
+    {
+        tiltRate = tiltAccel = 0.0;
+        speed = accel = 0.0;
+        yawRate = 0.0;
+        return;
+    }
+
+    /*
+     * Equations of motion of the wheeled inverted pendulum (Lagrange):
+     *   (M + Mw) x'' + M l cos(c) t'' = T/r + F + M l sin(c) t'^2
+     *   M l cos(c) x'' + (I + M l^2) t'' = -T + F l cos(c) + M g l sin(c)
+     * with the angle of the center of mass c = t + riderLean, the sum of
+     * the motor torques T, the push force F and the effective mass of both
+     * wheels Mw = 2 (m + Iw/r^2).
+     */
+    double torque = torques[0] + torques[1];
+    double wheelsMass = 2.0 * (p.wheelMass
+                               + p.wheelInertia / (p.wheelRadius
+                                                   * p.wheelRadius));
+    double cosTilt = cos(tilt + riderLean);
+    double sinTilt = sin(tilt + riderLean);
+    double ml = p.bodyMass * p.bodyHeight;
+
+    double a11 = p.bodyMass + wheelsMass;
+    double a12 = ml * cosTilt;
+    double a22 = p.bodyInertia + ml * p.bodyHeight;
+    double b1 = torque / p.wheelRadius + pushForce
+                + ml * sinTilt * tiltRate * tiltRate;
+    double b2 = -torque + pushForce * p.bodyHeight * cosTilt
+                + ml * GRAVITY * sinTilt;
+    double det = a11 * a22 - a12 * a12;
+    accel = (b1 * a22 - a12 * b2) / det;
+    tiltAccel = (a11 * b2 - a12 * b1) / det;
+
+    // Rotation around the vertical axis by the difference of the wheel
+    // forces.
+    double yawAccel = (torques[1] - torques[0]) / p.wheelRadius * halfTrack
+                      / (p.yawInertia + wheelsMass * halfTrack * halfTrack);
+
+    speed += accel * dt;
+    position += speed * dt;
+    tiltRate += tiltAccel * dt;
+    tilt += tiltRate * dt;
+    yawRate += yawAccel * dt;
+    yaw += yawRate * dt;
+
+    if (fabs(tilt) >= FALLEN_TILT)
+    {
+        tilt = tilt > 0.0 ? FALLEN_TILT : -FALLEN_TILT;
+        fallen = true;
+    }
+}
+
+double SegwayModel::getTilt()
+{
+    return tilt;
+}
+
+double SegwayModel::getTiltRate()
+{
+    return tiltRate;
+}
+
+double SegwayModel::getTiltAccel()
+{
+    return tiltAccel;
+}
+
+double SegwayModel::getPosition()
+{
+    return position;
+}
+
+double SegwayModel::getSpeed()
+{
+    return speed;
+}
+
+double SegwayModel::getAccel()
+{
+    return accel;
+}
+
+double SegwayModel::getYaw()
+{
+    return yaw;
+}
+
+double SegwayModel::getYawRate()
+{
+    return yawRate;
+}
+
+double SegwayModel::getSensorAccelForward()
+{
+    /*
+     * Returns the acceleration the MPU6050 measures along the body in
+     * driving direction in g (specific force, i.e. gravity included).
+     */
+
+    double h = params.sensorHeight;
+    double ax = accel + h * (cos(tilt) * tiltAccel
+                             - sin(tilt) * tiltRate * tiltRate);
+    double az = h * (-sin(tilt) * tiltAccel - cos(tilt) * tiltRate * tiltRate);
+    return (ax * cos(tilt) - (az + GRAVITY) * sin(tilt)) / GRAVITY;
+}
+
+double SegwayModel::getSensorAccelUp()
+{
+    /*
+     * Returns the acceleration the MPU6050 measures along the body upwards
+     * in g (1.0 at rest).
+     */
+
+    double h = params.sensorHeight;
+    double ax = accel + h * (cos(tilt) * tiltAccel
+                             - sin(tilt) * tiltRate * tiltRate);
+    double az = h * (-sin(tilt) * tiltAccel - cos(tilt) * tiltRate * tiltRate);
+    return (ax * sin(tilt) + (az + GRAVITY) * cos(tilt)) / GRAVITY;
+}
+
+double SegwayModel::getBatteryVoltage()
+{
+    return batteryVoltage;
+}
+
+double SegwayModel::getMotorCurrent(bool right)
+{
+    return currents[right ? 1 : 0];
+}
+
+double SegwayModel::getEnergy()
+{
+    /*
+     * Returns the energy in J taken from the battery since the start
+     * (recuperation reduces it).
+     */
+
+    return energy;
+}
+
+bool SegwayModel::hasFallen()
+{
+    return fallen;
+}
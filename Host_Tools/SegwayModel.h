@@ -0,0 +1,110 @@
+/*
+ * SegwayModel.h
+ *
+ * Physical model of a segway: a wheeled inverted pendulum driven by two DC
+ * motors with H-bridges. It only depends on the standard library, so that
+ * host programs can use it with the emulated hardware (see SegwayPlant.h)
+ * as well as directly with the Controller class.
+ *
+ * Modelled are:
+ *  - the body (segway and rider) as rigid pendulum on the wheel axis, the
+ *    wheels rolling without slip and the rotation around the vertical axis,
+ *  - the rider leaning relative to the platform, which shifts the center of
+ *    mass (the rider's movement itself is neglected),
+ *  - the motors with resistance, back EMF, gear and friction (the
+ *    inductance is neglected),
+ *  - the H-bridges, which apply the battery voltage times the duty cycle
+ *    and let the motor coast when both outputs are off,
+ *  - the battery with internal resistance.
+ * Coordinates: x points in driving direction, the tilt is positive when
+ * leaning forward, the yaw is positive when turning left.
+ */
+
+#ifndef SEGWAYMODEL_H_
+#define SEGWAYMODEL_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ */
+#include <stdbool.h>
+#include <stdint.h>
+
+
+struct SegwayModelParams
+{
+    double bodyMass;            // [kg] including the rider
+    double bodyHeight;          // [m] center of mass above the wheel axis
+    double bodyInertia;         // [kg m^2] around the center of mass (tilt)
+    double yawInertia;          // [kg m^2] around the vertical axis
+    double wheelMass;           // [kg] per wheel
+    double wheelRadius;         // [m]
+    double wheelInertia;        // [kg m^2] per wheel including the gear
+    double trackWidth;          // [m] distance between the wheels
+    double motorTorqueConst;    // [Nm/A] at the wheel (including the gear)
+    double motorResistance;     // [Ohm]
+    double motorFriction;       // [Nm s/rad] viscous friction at the wheel
+    double batteryVoltage;      // [V] open circuit
+    double batteryResistance;   // [Ohm]
+    double sensorHeight;        // [m] MPU6050 above the wheel axis
+
+    static SegwayModelParams tivSeg();
+    static SegwayModelParams miniSeg();
+};
+
+
+class SegwayModel
+{
+public:
+    SegwayModel();
+    virtual ~SegwayModel();
+    void init(const SegwayModelParams &params, double tilt = 0.0);
+    void setDuties(double left, double right);
+    void setPushForce(double force);
+    void setRiderLean(double lean);
+    void setHeld(bool held);
+    void step(double dt);
+    double getTilt();
+    double getTiltRate();
+    double getTiltAccel();
+    double getPosition();
+    double getSpeed();
+    double getAccel();
+    double getYaw();
+    double getYawRate();
+    double getSensorAccelForward();
+    double getSensorAccelUp();
+    double getBatteryVoltage();
+    double getMotorCurrent(bool right);
+    double getEnergy();
+    bool hasFallen();
+
+    // Tilt at which the body touches the ground.
+    constexpr static double FALLEN_TILT = 1.2;      // [rad]
+    constexpr static double GRAVITY = 9.81;         // [m/s^2]
+
+private:
+    double getMotorTorque(double duty, double relativeRate, double voltage,
+                          double &current);
+
+    SegwayModelParams params = {};
+    bool held = false;
+    bool fallen = false;
+
+    // State
+    double tilt = 0.0, tiltRate = 0.0, tiltAccel = 0.0;
+    double position = 0.0, speed = 0.0, accel = 0.0;
+    double yaw = 0.0, yawRate = 0.0;
+
+    // Inputs and results of the last step
+    double duties[2] = {0.0, 0.0};
+    double currents[2] = {0.0, 0.0};
+    double pushForce = 0.0;
+    double riderLean = 0.0;
+    double batteryVoltage = 0.0;
+    double energy = 0.0;
+};
+
+
+#endif /* SEGWAYMODEL_H_ */
@@ -0,0 +1,193 @@
+/*
+ * SegwayPlant.cpp
+ *
+ * Closed loop between the emulated hardware and the physical model of the
+ * segway (see SegwayPlant.h).
+ */
+
+#include "SegwayPlant.h"
+#include "HostDriverlib.h"
+#include "Config.h"
+
+
+SegwayPlant::SegwayPlant()
+{
+    /*
+     * Default empty constructor
+     */
+}
+
+SegwayPlant::~SegwayPlant()
+{
+    host.removePeripheral(this);
+}
+
+void SegwayPlant::init(const SegwayModelParams &params, uint32_t seed)
+{
+    /*
+     * Start the model upright and at rest. The body is held (see
+     * SegwayModel::setHeld) until the host program releases it, f.ex. after
+     * Segway::init calibrated the sensor. Needs to be called before
+     * Segway::init, which accesses the sensor.
+     *
+     * params: Properties of the segway (f.ex. SegwayModelParams::tivSeg()).
+     * seed:   Seed of the sensor noise.
+     */
+
+    model.init(params);
+    model.setHeld(true);
+
+    sensor.init(CFG_SENSOR_I2C_MODULE, CFG_SENSOR_ADRESSBIT, seed);
+    sensor.connectInterruptPin(CFG_SENSOR_INT_PORT, CFG_SENSOR_INT_PIN);
+
+    steering = 0.0f;
+    calibrationButtons = false;
+    duties[0] = duties[1] = 0.0f;
+    setFootSwitch(false);
+
+    host.removePeripheral(this);
+    host.addPeripheral(this);
+    updateInputs(host.getCycles());
+    nextStep = host.getCycles() + host.getCyclesUS(STEP_US);
+}
+
+void SegwayPlant::setSteering(float steering)
+{
+    /*
+     * Position of the steering potentiometer from -1.0f (umin) to 1.0f
+     * (umax).
+     */
+
+    this->steering = steering;
+}
+
+void SegwayPlant::setFootSwitch(bool pressed)
+{
+    hostGPIOSetInput(CFG_FS_PORT, CFG_FS_PIN,
+                     pressed == (bool) CFG_FS_ACTIVE_STATE);
+}
+
+void SegwayPlant::setCalibrationButtons(bool enabled)
+{
+    /*
+     * Steering::calibrateSteering waits until the user turned the
+     * potentiometer to both ends and pressed SW1 (PF4) and SW2 (PF0)
+     * respectively. If enabled, the plant repeats this sequence: SW1 is
+     * pressed with the potentiometer at umin and released, then SW2 with the
+     * potentiometer at umax. Each phase lasts CALIBRATION_PHASE_US. Disable
+     * it as soon as Segway::init returned.
+     */
+
+    calibrationButtons = enabled;
+    if (!enabled)
+    {
+        hostGPIOSetInput(GPIO_PORTF_BASE, GPIO_PIN_4 | GPIO_PIN_0, true);
+    }
+}
+
+SegwayModel &SegwayPlant::getModel()
+{
+    return model;
+}
+
+MPU6050Emulator &SegwayPlant::getSensor()
+{
+    return sensor;
+}
+
+float SegwayPlant::getLeftDuty()
+{
+    return duties[0];
+}
+
+float SegwayPlant::getRightDuty()
+{
+    return duties[1];
+}
+
+uint64_t SegwayPlant::getNextEvent()
+{
+    return nextStep;
+}
+
+void SegwayPlant::update(uint64_t cycles)
+{
+    /*
+     * Advance the model by one step with the current duty cycles and
+     * publish its new state to the inputs of the microcontroller.
+     */
+
+    if (hostGPIOGetOutput(CFG_EM_PORT, CFG_EM_PIN)
+        == (bool) CFG_EM_ACTIVE_STATE)
+    {
+        duties[0] = getDuty(CFG_LM_PORT, CFG_LM_PIN1, CFG_LM_PIN2);
+        duties[1] = getDuty(CFG_RM_PORT, CFG_RM_PIN1, CFG_RM_PIN2);
+    }
+    else
+    {
+        duties[0] = duties[1] = 0.0f;
+    }
+    model.setDuties(duties[0], duties[1]);
+    model.step(STEP_US * 1e-6);
+
+    updateInputs(cycles);
+    nextStep += host.getCyclesUS(STEP_US);
+}
+
+float SegwayPlant::getDuty(uint32_t port, uint8_t forwardPin,
+                           uint8_t reversePin)
+{
+    /*
+     * Returns the duty cycle of one H-bridge from -1.0f to 1.0f.
+     */
+
+    return hostPWMGetDuty(port, forwardPin) - hostPWMGetDuty(port, reversePin);
+}
+
+void SegwayPlant::updateInputs(uint64_t cycles)
+{
+    /*
+     * Apply the state of the model to the sensor, the analog inputs and the
+     * steering calibration buttons.
+     */
+
+    // Sensor. The axes and signs are the inverse of what the MPU6050 class
+    // is configured to in Segway::init.
+    const uint8_t wheel = (CFG_SENSOR_WHEEL_AXIS | 0x20) - 'x';
+    const uint8_t hor = (CFG_SENSOR_HOR_AXIS | 0x20) - 'x';
+    const uint8_t ver = 3 - wheel - hor;
+    const float RAD_TO_DEG = 180.0f / 3.14159265f;
+    float angleRates[3] = {0.0f, 0.0f, 0.0f};
+    float accels[3] = {0.0f, 0.0f, 0.0f};
+    angleRates[wheel] = (CFG_SENSOR_INVERT_ANGLE_RATE ? -1.0f : 1.0f)
+                        * model.getTiltRate() * RAD_TO_DEG;
+    angleRates[ver] = model.getYawRate() * RAD_TO_DEG;
+    accels[hor] = (CFG_SENSOR_INVERT_HOR ? -1.0f : 1.0f)
+                  * model.getSensorAccelForward();
+    accels[ver] = (CFG_SENSOR_INVERT_VER ? -1.0f : 1.0f)
+                  * -model.getSensorAccelUp();
+    sensor.setAngleRates(angleRates[0], angleRates[1], angleRates[2]);
+    sensor.setAccels(accels[0], accels[1], accels[2]);
+
+    // Analog inputs
+    hostADCSetVoltage(CFG_BATT_AIN,
+                      model.getBatteryVoltage() / BATTERY_DIVIDER);
+
+    float potPosition = steering;
+    if (calibrationButtons)
+    {
+        /*
+         * Phase 0: SW1 pressed, pot at umin. Phase 1: released.
+         * Phase 2: SW2 pressed, pot at umax. Phase 3: released.
+         * The buttons are active low.
+         */
+        uint32_t phase = (cycles / host.getCyclesUS(CALIBRATION_PHASE_US))
+                         % 4;
+        potPosition = (phase < 2) ? -1.0f : 1.0f;
+        hostGPIOSetInput(GPIO_PORTF_BASE, GPIO_PIN_4, phase != 0);
+        hostGPIOSetInput(GPIO_PORTF_BASE, GPIO_PIN_0, phase != 2);
+    }
+    hostADCSetVoltage(CFG_STEERING_AIN,
+                      STEERING_U_MIN + 0.5f * (potPosition + 1.0f)
+                                       * (STEERING_U_MAX - STEERING_U_MIN));
+}
@@ -0,0 +1,79 @@
+/*
+ * SegwayPlant.h
+ *
+ * Connects the physical model of the segway (see SegwayModel.h) to the
+ * emulated hardware, so that the unchanged Segway class of Common_Classes
+ * runs in a closed loop on the PC:
+ *  - the duty cycles of the motor PWM outputs (gated by the enable motors
+ *    pin) drive the model,
+ *  - the movement of the model is fed into the emulated MPU6050,
+ *  - the battery voltage and the steering potentiometer are applied to
+ *    their analog inputs, the foot switch to its GPIO pin.
+ * The model advances in fixed steps of STEP_US as peripheral of the host
+ * hardware, hence it runs in the virtual time of the microcontroller.
+ * All pins and axes are taken from Config.h.
+ */
+
+#ifndef SEGWAYPLANT_H_
+#define SEGWAYPLANT_H_
+
+
+/*
+ * stdbool.h:               Boolean definitions for the C99 standard
+ * stdint.h:                Variable definitions for the C99 standard
+ * HostHardware.h:          Virtual time base and interrupt handling.
+ * MPU6050Emulator.h:       Emulated angle rate and acceleration sensor.
+ * SegwayModel.h:           Physical model of the segway.
+ */
+#include <stdbool.h>
+#include <stdint.h>
+#include "HostHardware.h"
+#include "MPU6050Emulator.h"
+#include "SegwayModel.h"
+
+
+class SegwayPlant : public HostPeripheral
+{
+public:
+    SegwayPlant();
+    virtual ~SegwayPlant();
+    void init(const SegwayModelParams &params, uint32_t seed = 1);
+    void setSteering(float steering);
+    void setFootSwitch(bool pressed);
+    void setCalibrationButtons(bool enabled);
+    SegwayModel &getModel();
+    MPU6050Emulator &getSensor();
+    float getLeftDuty();
+    float getRightDuty();
+
+    uint64_t getNextEvent();
+    void update(uint64_t cycles);
+
+    // Resolution of the model in virtual time.
+    const static uint32_t STEP_US = 100;
+
+    // Output voltage range of the steering potentiometer.
+    constexpr static float STEERING_U_MIN = 0.3f;   // [V]
+    constexpr static float STEERING_U_MAX = 3.0f;   // [V]
+
+    // Divider between the battery and its analog input (see CFG_BATT_MIN).
+    constexpr static float BATTERY_DIVIDER = 10.0f;
+
+private:
+    void updateInputs(uint64_t cycles);
+    float getDuty(uint32_t port, uint8_t forwardPin, uint8_t reversePin);
+
+    SegwayModel model;
+    MPU6050Emulator sensor;
+    uint64_t nextStep = NO_EVENT;
+    float steering = 0.0f;
+    bool calibrationButtons = false;
+    float duties[2] = {0.0f, 0.0f};
+
+    // Cycle of the steering calibration buttons (see
+    // SegwayPlant::setCalibrationButtons).
+    const static uint32_t CALIBRATION_PHASE_US = 100000;
+};
+
+
+#endif /* SEGWAYPLANT_H_ */
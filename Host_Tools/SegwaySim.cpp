@@ -0,0 +1,426 @@
+/*
+ * SegwaySim.cpp
+ *
+ * Closed loop simulation of the segway on the PC. The unchanged Segway class
+ * of Common_Classes (including the controller, the MPU6050 driver, the
+ * steering and the battery monitoring) runs on the emulated hardware
+ * against the physical model of the segway (see SegwayPlant.h). The update
+ * frequency, the estimator and the gains are taken from Config.h like on
+ * the microcontroller, so that changes can be tried in seconds. The gains
+ * can also be set with -D (f.ex. a set found by Host_Tools/GainSweep).
+ * The simulation runs in virtual time and is deterministic: the same
+ * configuration and scenario always give the same result.
+ *
+ * Scenarios:
+ *  - balance: starts tilted by 1deg and stands still
+ *  - push:    a push against the body after 2s (10% of the weight for
+ *             0.2s)
+ *  - steer:   turns with half the steering range after 2s
+ *  - drive:   the rider leans forward by 5deg after 2s and back after 6s
+ *  - dropout: the INT pin of the sensor is disconnected for 1s after 2s
+ *             and the tick takes over the updates (see
+ *             Segway::runSensorWatchdogTask). Meanwhile the segway is
+ *             pushed like in the push scenario, so it only stays up if the
+ *             updates go on. Needs the build option
+ *             -DCFG_SENSOR_DATA_READY_TRIGGER=true, which makes the sensor
+ *             trigger the updates in the other scenarios as well.
+ * The TivSeg model includes a rider who leans back when the segway gets
+ * faster, like a real rider does. The MiniSeg carries no rider; in the
+ * drive scenario its load is shifted forward by 1deg instead. Nothing
+ * stops it from accelerating then except the overspeed limit of the
+ * controller.
+ *
+ * Printed is a summary (fall, tilt, duty cycles, energy, distance, lost
+ * task releases, deadline misses, time needed on the PC); optionally the
+ * trajectory is written to a CSV file.
+ * The output of the UART (f.ex. the ride log, see RideLog.h) can be
+ * written to a file as well. With CFG_PROFILING the statistics of the
+ * profiling probes are requested at the end and sent to it. If the segway
+ * fell, the black box (see FlightRecorder.h) is requested as well;
+ * Host_Tools/RecorderDecode.cpp shows the updates before the fall.
+ * The program returns 1 if the segway fell or, in the dropout scenario, if
+ * more than two updates were missing during the dropout (or none was
+ * released by the watchdog).
+ *
+ * Build and run from the repository root (the device is chosen in
+ * Config.h; -DTIVSEG or -DMINISEG overrides it):
+ *     g++ -std=c++11 -O2 -IHost_Tools -IHost_Tools/TivaWare -ICommon_Classes \
+ *         Host_Tools/SegwaySim.cpp Host_Tools/SegwayPlant.cpp \
+ *         Host_Tools/SegwayModel.cpp Host_Tools/HostHardware.cpp \
+ *         Host_Tools/HostDriverlib.cpp Host_Tools/HostADC.cpp \
+ *         Host_Tools/MPU6050Emulator.cpp Common_Classes/Segway.cpp \
+ *         Common_Classes/Controller.cpp Common_Classes/Estimator.cpp \
+ *         Common_Classes/System.cpp Common_Classes/GPIO.cpp \
+ *         Common_Classes/PWM.cpp Common_Classes/Timer.cpp \
+ *         Common_Classes/Steering.cpp Common_Classes/MPU6050.cpp \
+ *         Common_Classes/RideLog.cpp Common_Classes/Scheduler.cpp \
+ *         Common_Classes/UARTBuffer.cpp Common_Classes/FlightRecorder.cpp \
+ *         -o SegwaySim
+ *     ./SegwaySim [balance|push|steer|drive|dropout] [seconds] [trace.csv|-]
+ *                 [uart output file]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include "HostHardware.h"
+#include "HostDriverlib.h"
+#include "SegwayPlant.h"
+#include "Config.h"
+#include "System.h"
+#include "Scheduler.h"
+#include "Segway.h"
+
+
+enum Scenario
+{
+    SCENARIO_BALANCE,
+    SCENARIO_PUSH,
+    SCENARIO_STEER,
+    SCENARIO_DRIVE,
+    SCENARIO_DROPOUT,
+    SCENARIO_COUNT
+};
+
+const char *SCENARIO_NAMES[SCENARIO_COUNT] = {"balance", "push", "steer",
+                                              "drive", "dropout"};
+
+const uint32_t LOOP_US = 1000;          // resolution of the scenario
+const uint32_t IDLE_US = 10;            // time per idle pass of the main loop
+const uint32_t TRACE_US = 10000;        // interval of the CSV trace
+const double START_TILT = 1.0;          // [deg] balance scenario
+const double EVENT_TIME = 2.0;          // [s] start of push, steer, drive
+const double PUSH_DURATION = 0.2;       // [s]
+const double PUSH_WEIGHT_FACT = 0.1;
+const float STEERING = 0.5f;
+const double DRIVE_END = 6.0;           // [s]
+const double DROPOUT_END = 3.0;         // [s]
+const double DROPOUT_PUSH = 2.4;        // [s] start of the push
+const uint32_t DROPOUT_LOST_UPDATES = 2; // at the takeover and handback
+const double SATURATION = 0.99 * CFG_CTLR_MAXDUTY;
+
+// Rider of the TivSeg: leans back by RIDER_SPEED_GAIN per m/s (up to
+// RIDER_MAX_LEAN) and follows with the time constant RIDER_TAU.
+const double RIDER_SPEED_GAIN = 0.1;    // [rad s/m]
+const double RIDER_MAX_LEAN = 0.15;     // [rad]
+const double RIDER_TAU = 0.3;           // [s]
+
+const double DEG_TO_RAD = 3.14159265358979 / 180.0;
+
+System sys;
+Segway segway;
+Scheduler scheduler;
+SegwayPlant plant;
+FILE *uartFile = 0;
+
+
+void schedulerISR()
+{
+    scheduler.tick();
+}
+
+void sensorISR()
+{
+    segway.handleDataReady();
+}
+
+void uartISR()
+{
+    sys.handleUARTInterrupt();
+}
+
+void uartFileOutput(const char *data, uint32_t length)
+{
+    fwrite(data, 1, length, uartFile);
+}
+
+void runMainLoop(uint32_t us)
+{
+    /*
+     * Main loop of the microcontroller for the given time: run the tasks,
+     * otherwise let the time pass.
+     */
+
+    uint64_t loopEnd = host.getCycles() + host.getCyclesUS(us);
+    while (host.getCycles() < loopEnd)
+    {
+        if (!scheduler.run())
+        {
+            host.advanceTo(std::min(loopEnd, host.getCycles()
+                                             + host.getCyclesUS(IDLE_US)));
+        }
+    }
+}
+
+void errorHandler()
+{
+    // System::error loops forever on the microcontroller.
+    fprintf(stderr, "Error reported by the segway code at %.3fs\n",
+            host.getTime());
+    exit(2);
+}
+
+int main(int argc, char *argv[])
+{
+    Scenario scenario = SCENARIO_BALANCE;
+    double duration = 10.0;
+    FILE *trace = 0;
+    if (argc > 1)
+    {
+        scenario = SCENARIO_COUNT;
+        for (uint8_t i = 0; i < SCENARIO_COUNT; i++)
+        {
+            if (strcmp(argv[1], SCENARIO_NAMES[i]) == 0)
+            {
+                scenario = (Scenario) i;
+            }
+        }
+    }
+    if (argc > 2)
+    {
+        duration = atof(argv[2]);
+    }
+    bool traceFailed = false;
+    if (argc > 3 && strcmp(argv[3], "-") != 0)
+    {
+        trace = fopen(argv[3], "w");
+        traceFailed = !trace;
+    }
+    if (argc > 4)
+    {
+        uartFile = fopen(argv[4], "wb");
+        traceFailed |= !uartFile;
+    }
+    if (scenario == SCENARIO_COUNT || duration <= 0.0 || traceFailed)
+    {
+        fprintf(stderr, "Usage: %s [balance|push|steer|drive|dropout] "
+                "[seconds] [trace.csv|-] [uart output file]\n", argv[0]);
+        return 1;
+    }
+    if (uartFile)
+    {
+        hostUARTSetOutput(uartFileOutput);
+    }
+
+#ifdef TIVSEG
+    const SegwayModelParams params = SegwayModelParams::tivSeg();
+    const bool hasRider = true;
+    const double driveLean = 5.0;       // [deg]
+#else
+    const SegwayModelParams params = SegwayModelParams::miniSeg();
+    const bool hasRider = false;
+    const double driveLean = 1.0;       // [deg]
+#endif
+
+    // The debug output is not needed.
+    sys.init(CFG_SYS_FREQ);
+    sys.enableUARTBuffer(uartISR);
+    sys.setDebugging(false);
+    host.setErrorHandler(errorHandler);
+
+    // Power up: the segway is held still while the sensor is calibrated and
+    // the steering buttons are pressed.
+    plant.init(params);
+    plant.setCalibrationButtons(true);
+    segway.init(&sys);
+    plant.setCalibrationButtons(false);
+
+    scheduler.init(&sys, CFG_MAIN_TIMER_BASE, schedulerISR,
+                   CFG_CTLR_UPDATE_FREQ);
+    segway.addTasks(&scheduler);
+    segway.enableDataReadyTrigger(sensorISR);
+    scheduler.start();
+
+    // Someone steps on the segway.
+    SegwayModel &model = plant.getModel();
+    if (scenario == SCENARIO_BALANCE)
+    {
+        model.init(params, START_TILT * DEG_TO_RAD);
+    }
+    model.setHeld(false);
+    plant.setFootSwitch(true);
+
+    if (trace)
+    {
+        fprintf(trace, "time,tilt,tilt_rate,position,speed,yaw,left_duty,"
+                "right_duty,battery_voltage,rider_lean\n");
+    }
+
+    double start = host.getTime();
+    double riderLean = 0.0;
+    double maxTilt = 0.0, squaredTilt = 0.0, maxDuty = 0.0;
+    uint32_t steps = 0, saturatedSteps = 0;
+    uint32_t dropoutUpdates = 0, dropoutReleases = 0;
+    uint32_t traceSteps = TRACE_US / LOOP_US;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    while (host.getTime() - start < duration && !model.hasFallen())
+    {
+        double t = host.getTime() - start;
+        bool event = t >= EVENT_TIME;
+
+        // Scenario
+        double push = 0.0, leanTarget = 0.0;
+        switch (scenario)
+        {
+        case SCENARIO_PUSH:
+            if (event && t < EVENT_TIME + PUSH_DURATION)
+            {
+                push = PUSH_WEIGHT_FACT * params.bodyMass
+                       * SegwayModel::GRAVITY;
+            }
+            break;
+        case SCENARIO_STEER:
+            plant.setSteering(event ? STEERING : 0.0f);
+            break;
+        case SCENARIO_DRIVE:
+            if (event && t < DRIVE_END)
+            {
+                leanTarget = driveLean * DEG_TO_RAD;
+            }
+            break;
+        case SCENARIO_DROPOUT:
+            // Like a loose wire of the INT pin
+            if (event && t < DROPOUT_END)
+            {
+                plant.getSensor().connectInterruptPin(0, 0);
+                if (t >= DROPOUT_PUSH && t < DROPOUT_PUSH + PUSH_DURATION)
+                {
+                    push = PUSH_WEIGHT_FACT * params.bodyMass
+                           * SegwayModel::GRAVITY;
+                }
+            }
+            else
+            {
+                plant.getSensor().connectInterruptPin(CFG_SENSOR_INT_PORT,
+                                                      CFG_SENSOR_INT_PIN);
+            }
+            break;
+        default:
+            break;
+        }
+        model.setPushForce(push);
+
+        // The rider leans towards the target and back against the speed.
+        if (hasRider)
+        {
+            leanTarget -= RIDER_SPEED_GAIN * model.getSpeed();
+            leanTarget = fmax(-RIDER_MAX_LEAN, fmin(RIDER_MAX_LEAN,
+                                                    leanTarget));
+        }
+        riderLean += (leanTarget - riderLean) * (LOOP_US * 1e-6 / RIDER_TAU);
+        model.setRiderLean(riderLean);
+
+        uint32_t updates = segway.getUpdateCount();
+        uint32_t releases = segway.getWatchdogReleases();
+        runMainLoop(LOOP_US);
+        if (scenario == SCENARIO_DROPOUT && event && t < DROPOUT_END)
+        {
+            dropoutUpdates += segway.getUpdateCount() - updates;
+            dropoutReleases += segway.getWatchdogReleases() - releases;
+        }
+
+        // Statistics
+        double tilt = model.getTilt() / DEG_TO_RAD;
+        double duty = fmax(fabs(plant.getLeftDuty()),
+                           fabs(plant.getRightDuty()));
+        maxTilt = fmax(maxTilt, fabs(tilt));
+        squaredTilt += tilt * tilt;
+        maxDuty = fmax(maxDuty, duty);
+        saturatedSteps += (duty >= SATURATION);
+        steps++;
+
+        if (trace && steps % traceSteps == 0)
+        {
+            fprintf(trace, "%.3f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f,"
+                    "%.4f\n", host.getTime() - start, tilt,
+                    model.getTiltRate() / DEG_TO_RAD, model.getPosition(),
+                    model.getSpeed(), model.getYaw() / DEG_TO_RAD,
+                    plant.getLeftDuty(), plant.getRightDuty(),
+                    model.getBatteryVoltage(), riderLean / DEG_TO_RAD);
+        }
+    }
+
+    double wallTime = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - wallStart).count();
+    double simTime = host.getTime() - start;
+    if (trace)
+    {
+        fclose(trace);
+    }
+    printf("Scenario:          %s (%s, %d Hz%s)\n", SCENARIO_NAMES[scenario],
+           hasRider ? "TivSeg" : "MiniSeg", CFG_CTLR_UPDATE_FREQ,
+           CFG_SENSOR_DATA_READY_TRIGGER ? ", data ready trigger" : "");
+    // The watchdog must keep the updates going while the INT pin is
+    // disconnected.
+    uint32_t dropoutExpected = (DROPOUT_END - EVENT_TIME)
+                               * CFG_CTLR_UPDATE_FREQ;
+    bool dropoutFailed = scenario == SCENARIO_DROPOUT
+                         && (dropoutUpdates + DROPOUT_LOST_UPDATES
+                             < dropoutExpected
+                             || (CFG_SENSOR_DATA_READY_TRIGGER
+                                 && dropoutReleases == 0));
+    printf("Result:            %s\n", model.hasFallen() ? "FALLEN"
+                                      : dropoutFailed ? "UPDATES STOPPED"
+                                      : "balanced");
+    printf("Simulated time:    %.3f s (%.0fx real time)\n", simTime,
+           simTime / wallTime);
+    printf("Max. tilt:         %.2f deg (RMS %.2f deg)\n", maxTilt,
+           sqrt(squaredTilt / (steps ? steps : 1)));
+    printf("Max. duty cycle:   %.2f (saturated %.1f%% of the time)\n",
+           maxDuty, 100.0 * saturatedSteps / (steps ? steps : 1));
+    printf("Energy:            %.1f J\n", model.getEnergy());
+    printf("Task overruns:     %u\n", scheduler.getTotalOverruns());
+    // The balance task is the first one (see Segway::addTasks).
+    printf("Deadline misses:   %u (max. jitter %u us)\n",
+           scheduler.getTotalDeadlineMisses(), scheduler.getJitterUS(0));
+    printf("Position, yaw:     %.2f m, %.1f deg\n", model.getPosition(),
+           model.getYaw() / DEG_TO_RAD);
+    if (scenario == SCENARIO_DROPOUT)
+    {
+        printf("Sensor dropout:    %u of %u updates (%u released by the "
+               "watchdog)\n", dropoutUpdates, dropoutExpected,
+               dropoutReleases);
+    }
+
+    // Request the statistics of the profiling probes like with the Serial
+    // Monitor. The telemetry task sends them to the UART output.
+    if (CFG_PROFILING)
+    {
+        printf("Profiling probes (virtual CPU cycles, see System::addProbe):\n");
+        fflush(stdout);
+        hostUARTReceive("p");
+        UARTBuffer *uartBuffer = sys.getUARTBuffer();
+        for (uint32_t i = 0;
+             i < 1000 && (UARTCharsAvail(UART0_BASE) || sys.isSendingProbes()
+                          || uartBuffer->getFree() < UARTBuffer::SIZE);
+             i++)
+        {
+            // An overloaded CPU might never run the telemetry task. The
+            // report is sent in parts, wait until the last one is out.
+            runMainLoop(LOOP_US);
+        }
+    }
+
+    // Request the black box like with the Serial Monitor. The telemetry
+    // task sends it in parts within about a second.
+    if (CFG_RECORDER_ENABLE && uartFile && model.hasFallen())
+    {
+        printf("Black box:         sent to the UART output\n");
+        hostUARTReceive("b");
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            runMainLoop(LOOP_US);
+        }
+    }
+
+    if (uartFile)
+    {
+        fclose(uartFile);
+    }
+
+    return (model.hasFallen() || dropoutFailed) ? 1 : 0;
+}
@@ -0,0 +1,292 @@
+/*
+ * SensorBench.cpp
+ *
+ * Runs the MPU6050 class of Common_Classes on the PC against the emulated
+ * sensor (see MPU6050Emulator.h) and compares the ways of reading it once
+ * per control cycle:
+ *  - burst:      MPU6050::readAll
+ *  - async:      MPU6050::startReadAll at the end of the cycle and
+ *                MPU6050::readAll at the beginning of the next one
+ *  - fifo:       MPU6050::readFIFO (CFG_SENSOR_FIFO_SAMPLES samples per
+ *                cycle, 8 if disabled in Config.h)
+ *  - data ready: MPU6050::readAll triggered by the INT pin
+ * For each mode the I2C transactions, bytes and bus time per cycle, the CPU
+ * time spent waiting for the bus and the error of the angle rate are
+ * printed. The segway swings with 5deg at 1Hz around its wheel axis.
+ * Additionally it's checked that the gyroscope calibration removes the
+ * bias of the emulated sensor. The program returns 1 if not.
+ *
+ * Build and run from the repository root:
+ *     g++ -std=c++11 -O2 -IHost_Tools -IHost_Tools/TivaWare -ICommon_Classes \
+ *         Host_Tools/SensorBench.cpp Host_Tools/HostHardware.cpp \
+ *         Host_Tools/HostDriverlib.cpp Host_Tools/MPU6050Emulator.cpp \
+ *         Common_Classes/System.cpp Common_Classes/GPIO.cpp \
+ *         Common_Classes/MPU6050.cpp Common_Classes/UARTBuffer.cpp \
+ *         Common_Classes/FlightRecorder.cpp -o SensorBench
+ *     ./SensorBench [cycles per mode]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "HostHardware.h"
+#include "HostDriverlib.h"
+#include "MPU6050Emulator.h"
+#include "Config.h"
+#include "System.h"
+#include "GPIO.h"
+#include "MPU6050.h"
+
+
+enum BenchMode
+{
+    MODE_BURST,
+    MODE_ASYNC,
+    MODE_FIFO,
+    MODE_DATA_READY,
+    MODE_COUNT
+};
+
+const char *MODE_NAMES[MODE_COUNT] = {"burst", "async", "fifo", "data ready"};
+
+// Movement of the segway
+const float SWING_AMPLITUDE = 5.0f;    // [deg]
+const float SWING_FREQ = 1.0f;         // [Hz]
+const uint32_t MOVEMENT_STEP_US = 100; // resolution of the movement
+
+// Errors of the emulated sensor
+const float GYRO_BIAS[3] = {1.5f, -2.0f, 0.8f}; // [deg/s]
+const float GYRO_NOISE = 0.05f;                 // [deg/s]
+const float ACCEL_NOISE = 0.004f;               // [g]
+
+System sys;
+MPU6050Emulator *emulator;
+GPIO sensorInterrupt;
+volatile bool dataReady = false;
+
+
+void sensorISR()
+{
+    sensorInterrupt.clearInterruptFlag();
+    dataReady = true;
+}
+
+uint8_t getAxisIndex(char axis)
+{
+    return (axis | 0x20) - 'x';
+}
+
+float getTrueAngleRate(double t)
+{
+    /*
+     * Returns the true angle rate around the wheel axis in deg/s at the
+     * given time. Zero before the swinging starts (t < 0).
+     */
+
+    if (t < 0.0)
+    {
+        return 0.0f;
+    }
+    float omega = 2.0f * 3.14159265f * SWING_FREQ;
+    return SWING_AMPLITUDE * omega * cosf(omega * t);
+}
+
+void moveUntil(uint64_t cycles, double swingStart, bool stopAtDataReady)
+{
+    /*
+     * Let the time pass until the given cycle count while updating the
+     * movement of the emulated sensor.
+     */
+
+    const uint8_t wheel = getAxisIndex(CFG_SENSOR_WHEEL_AXIS);
+    const uint8_t hor = getAxisIndex(CFG_SENSOR_HOR_AXIS);
+    const uint8_t ver = 3 - wheel - hor;
+    const float DEG_TO_RAD = 3.14159265f / 180.0f;
+
+    while (host.getCycles() < cycles && !(stopAtDataReady && dataReady))
+    {
+        double t = host.getTime() - swingStart;
+        float angleRates[3] = {0.0f, 0.0f, 0.0f};
+        float accels[3] = {0.0f, 0.0f, 0.0f};
+        float angle = 0.0f;
+        if (t >= 0.0)
+        {
+            float omega = 2.0f * 3.14159265f * SWING_FREQ;
+            angle = SWING_AMPLITUDE * sinf(omega * t) * DEG_TO_RAD;
+        }
+        angleRates[wheel] = getTrueAngleRate(t);
+        accels[hor] = sinf(angle);
+        accels[ver] = cosf(angle);
+        emulator->setAngleRates(angleRates[0], angleRates[1], angleRates[2]);
+        emulator->setAccels(accels[0], accels[1], accels[2]);
+
+        uint64_t next = host.getCycles() + host.getCyclesUS(MOVEMENT_STEP_US);
+        host.advanceTo(next < cycles ? next : cycles);
+    }
+}
+
+bool runMode(BenchMode mode, uint32_t cycles)
+{
+    /*
+     * Initialize a new sensor like Segway::init does, then read it for the
+     * given number of control cycles. Returns whether the calibration check
+     * passed.
+     */
+
+    MPU6050Emulator sensorEmulator;
+    emulator = &sensorEmulator;
+    sensorEmulator.init(CFG_SENSOR_I2C_MODULE, CFG_SENSOR_ADRESSBIT, 1 + mode);
+    sensorEmulator.setGyroBias(GYRO_BIAS[0], GYRO_BIAS[1], GYRO_BIAS[2]);
+    sensorEmulator.setNoise(GYRO_NOISE, ACCEL_NOISE);
+    sensorEmulator.connectInterruptPin(CFG_SENSOR_INT_PORT,
+                                       CFG_SENSOR_INT_PIN);
+
+    MPU6050 sensor;
+    sensor.init(&sys, CFG_SENSOR_I2C_MODULE, CFG_SENSOR_ADRESSBIT);
+    sensor.setWheelAxis(CFG_SENSOR_WHEEL_AXIS);
+    sensor.setHorAxis(CFG_SENSOR_HOR_AXIS);
+    sensor.accelHorInvertSign(CFG_SENSOR_INVERT_HOR);
+    sensor.accelVerInvertSign(CFG_SENSOR_INVERT_VER);
+    sensor.angleRateInvertSign(CFG_SENSOR_INVERT_ANGLE_RATE);
+    if (CFG_SENSOR_LOW_PASS)
+    {
+        sensor.setLowPass(CFG_SENSOR_LOW_PASS);
+    }
+    sensor.setSampleRate(CFG_SENSOR_SAMPLE_FREQ);
+
+    // The sensor is at rest during the calibration.
+    moveUntil(host.getCycles() + 1, 1e9, false);
+    sensor.calibrateGyro(CFG_SENSOR_GYRO_CAL_SAMPLES > 0
+                         ? CFG_SENSOR_GYRO_CAL_SAMPLES : 200);
+    moveUntil(host.getCycles() + host.getCyclesUS(20000), 1e9, false);
+    sensor.readAll();
+    float restRate = sensor.getAngleRate();
+    bool calibrated = fabsf(restRate) < 5.0f * GYRO_NOISE + 0.05f;
+
+    uint32_t fifoSamples = CFG_SENSOR_FIFO_SAMPLES ? CFG_SENSOR_FIFO_SAMPLES
+                                                   : 8;
+    if (mode == MODE_FIFO)
+    {
+        sensor.enableFIFO(fifoSamples, CFG_CTLR_UPDATE_FREQ);
+    }
+    else if (mode == MODE_DATA_READY)
+    {
+        sensorInterrupt.init(&sys, CFG_SENSOR_INT_PORT, CFG_SENSOR_INT_PIN,
+                             GPIO_DIR_MODE_IN);
+        sensorInterrupt.enableInterrupt(GPIO_RISING_EDGE, sensorISR);
+        sensor.enableDataReadyInterrupt(CFG_CTLR_UPDATE_FREQ);
+    }
+
+    // Start swinging one cycle before the measurement starts.
+    uint64_t period = host.getClockFreq() / CFG_CTLR_UPDATE_FREQ;
+    double swingStart = host.getTime();
+    moveUntil(host.getCycles() + period, swingStart, false);
+    if (mode == MODE_ASYNC)
+    {
+        sensor.startReadAll();
+    }
+
+    hostI2CResetStats(CFG_SENSOR_I2C_MODULE);
+    sensorEmulator.resetCounters();
+    dataReady = false;
+
+    uint64_t cpuCycles = 0;
+    uint64_t fifoEntries = 0;
+    double squaredErrors = 0.0;
+    uint64_t nextCycle = host.getCycles();
+    for (uint32_t i = 0; i < cycles; i++)
+    {
+        if (mode == MODE_DATA_READY)
+        {
+            while (!dataReady)
+            {
+                moveUntil(host.getCycles() + period, swingStart, true);
+            }
+            dataReady = false;
+        }
+        else
+        {
+            moveUntil(nextCycle, swingStart, false);
+            nextCycle += period;
+        }
+
+        uint64_t start = host.getCycles();
+        switch (mode)
+        {
+        case MODE_FIFO:
+            fifoEntries += sensor.readFIFO();
+            break;
+        default:
+            sensor.readAll();
+            break;
+        }
+        if (mode == MODE_ASYNC)
+        {
+            sensor.startReadAll();
+        }
+        cpuCycles += host.getCycles() - start;
+
+        float sign = CFG_SENSOR_INVERT_ANGLE_RATE ? -1.0f : 1.0f;
+        float error = sensor.getAngleRate()
+                      - sign * getTrueAngleRate(host.getTime() - swingStart);
+        squaredErrors += error * error;
+    }
+
+    // Finish a running transfer before the sensor is destroyed.
+    if (mode == MODE_ASYNC)
+    {
+        sensor.readAll();
+    }
+    if (mode == MODE_DATA_READY)
+    {
+        GPIOIntDisable(CFG_SENSOR_INT_PORT, CFG_SENSOR_INT_PIN);
+    }
+
+    HostI2CStats stats = hostI2CGetStats(CFG_SENSOR_I2C_MODULE);
+    double cyclesPerUS = host.getClockFreq() / 1e6;
+    printf("%-11s %10.1f %10.1f %10.1f %10.1f %10.1f %12.3f %8s\n",
+           MODE_NAMES[mode],
+           (double) sensorEmulator.getTransactions() / cycles,
+           (double) stats.bytes / cycles,
+           stats.busyCycles / cyclesPerUS / cycles,
+           cpuCycles / cyclesPerUS / cycles,
+           mode == MODE_FIFO ? (double) fifoEntries / cycles : 1.0,
+           sqrt(squaredErrors / cycles),
+           calibrated ? "ok" : "FAILED");
+
+    return calibrated;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t cycles = 100;
+    if (argc > 1)
+    {
+        cycles = strtoul(argv[1], 0, 10);
+    }
+    if (cycles == 0)
+    {
+        fprintf(stderr, "Usage: %s [cycles per mode]\n", argv[0]);
+        return 1;
+    }
+
+    // The debug output is not needed.
+    sys.init(CFG_SYS_FREQ);
+    sys.setDebugging(false);
+
+    printf("Control cycle: %d Hz, sensor sample rate: %d Hz, %u cycles per "
+           "mode\n\n", CFG_CTLR_UPDATE_FREQ, CFG_SENSOR_SAMPLE_FREQ, cycles);
+    printf("%-11s %10s %10s %10s %10s %10s %12s %8s\n", "mode",
+           "trans", "bytes", "bus [us]", "CPU [us]", "samples",
+           "RMS [deg/s]", "calib.");
+
+    bool passed = true;
+    for (uint8_t mode = 0; mode < MODE_COUNT; mode++)
+    {
+        passed &= runMode((BenchMode) mode, cycles);
+    }
+
+    printf("\nAll values per control cycle. RMS: error of the angle rate "
+           "compared to the true one at the time it's read.\n");
+    return passed ? 0 : 1;
+}
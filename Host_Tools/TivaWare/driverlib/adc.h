@@ -0,0 +1,44 @@
+/*
+ * adc.h
+ *
+ * Host replacement of the TivaWare header with the same name.
+ */
+
+#ifndef __DRIVERLIB_ADC_H__
+#define __DRIVERLIB_ADC_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define ADC_CTL_CH0             0x00000000
+#define ADC_CTL_CH1             0x00000001
+#define ADC_CTL_CH2             0x00000002
+#define ADC_CTL_CH3             0x00000003
+#define ADC_CTL_CH4             0x00000004
+#define ADC_CTL_CH5             0x00000005
+#define ADC_CTL_CH6             0x00000006
+#define ADC_CTL_CH7             0x00000007
+#define ADC_CTL_CH8             0x00000008
+#define ADC_CTL_CH9             0x00000009
+#define ADC_CTL_CH10            0x0000000A
+#define ADC_CTL_CH11            0x0000000B
+#define ADC_CTL_IE              0x00000040
+#define ADC_CTL_END             0x00000020
+
+#define ADC_TRIGGER_PROCESSOR   0x00000000
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                          uint32_t ui32Trigger, uint32_t ui32Priority);
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                              uint32_t ui32Step, uint32_t ui32Config);
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum);
+void ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor);
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum);
+uint32_t ADCIntStatus(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                      bool bMasked);
+void ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum);
+int32_t ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum,
+                           uint32_t *pui32Buffer);
+
+
+#endif /* __DRIVERLIB_ADC_H__ */
@@ -0,0 +1,15 @@
+/*
+ * fpu.h
+ *
+ * Host replacement of the TivaWare header with the same name. The host
+ * always has a floating point unit, hence these functions do nothing.
+ */
+
+#ifndef __DRIVERLIB_FPU_H__
+#define __DRIVERLIB_FPU_H__
+
+void FPUEnable(void);
+void FPULazyStackingEnable(void);
+
+
+#endif /* __DRIVERLIB_FPU_H__ */
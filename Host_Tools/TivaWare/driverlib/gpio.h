@@ -0,0 +1,67 @@
+/*
+ * gpio.h
+ *
+ * Host replacement of the TivaWare header with the same name (see
+ * HostDriverlib.cpp).
+ */
+
+#ifndef __DRIVERLIB_GPIO_H__
+#define __DRIVERLIB_GPIO_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define GPIO_PIN_0              0x00000001
+#define GPIO_PIN_1              0x00000002
+#define GPIO_PIN_2              0x00000004
+#define GPIO_PIN_3              0x00000008
+#define GPIO_PIN_4              0x00000010
+#define GPIO_PIN_5              0x00000020
+#define GPIO_PIN_6              0x00000040
+#define GPIO_PIN_7              0x00000080
+
+#define GPIO_DIR_MODE_IN        0x00000000
+#define GPIO_DIR_MODE_OUT       0x00000001
+#define GPIO_DIR_MODE_HW        0x00000002
+
+#define GPIO_FALLING_EDGE       0x00000000
+#define GPIO_RISING_EDGE        0x00000004
+#define GPIO_BOTH_EDGES         0x00000001
+#define GPIO_LOW_LEVEL          0x00000002
+#define GPIO_HIGH_LEVEL         0x00000006
+
+#define GPIO_STRENGTH_2MA       0x00000001
+#define GPIO_STRENGTH_4MA       0x00000002
+#define GPIO_STRENGTH_6MA       0x00000065
+#define GPIO_STRENGTH_8MA       0x00000066
+#define GPIO_STRENGTH_8MA_SC    0x0000006E
+#define GPIO_STRENGTH_10MA      0x00000075
+#define GPIO_STRENGTH_12MA      0x00000077
+
+#define GPIO_PIN_TYPE_STD       0x00000008
+#define GPIO_PIN_TYPE_STD_WPU   0x0000000A
+#define GPIO_PIN_TYPE_STD_WPD   0x0000000C
+#define GPIO_PIN_TYPE_OD        0x00000009
+#define GPIO_PIN_TYPE_ANALOG    0x00000000
+
+void GPIODirModeSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32PinIO);
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins,
+                      uint32_t ui32Strength, uint32_t ui32PadType);
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val);
+void GPIOPinConfigure(uint32_t ui32PinConfig);
+void GPIOPinTypeADC(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeI2C(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeI2CSCL(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypePWM(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOPinTypeUART(uint32_t ui32Port, uint8_t ui8Pins);
+void GPIOIntTypeSet(uint32_t ui32Port, uint8_t ui8Pins,
+                    uint32_t ui32IntType);
+void GPIOIntRegister(uint32_t ui32Port, void (*pfnIntHandler)(void));
+void GPIOIntEnable(uint32_t ui32Port, uint32_t ui32IntFlags);
+void GPIOIntDisable(uint32_t ui32Port, uint32_t ui32IntFlags);
+uint32_t GPIOIntStatus(uint32_t ui32Port, bool bMasked);
+void GPIOIntClear(uint32_t ui32Port, uint32_t ui32IntFlags);
+
+
+#endif /* __DRIVERLIB_GPIO_H__ */
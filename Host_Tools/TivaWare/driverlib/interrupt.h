@@ -0,0 +1,21 @@
+/*
+ * interrupt.h
+ *
+ * Host replacement of the TivaWare header with the same name (see
+ * HostDriverlib.cpp).
+ */
+
+#ifndef __DRIVERLIB_INTERRUPT_H__
+#define __DRIVERLIB_INTERRUPT_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+bool IntMasterEnable(void);
+bool IntMasterDisable(void);
+void IntEnable(uint32_t ui32Interrupt);
+void IntDisable(uint32_t ui32Interrupt);
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority);
+
+
+#endif /* __DRIVERLIB_INTERRUPT_H__ */
@@ -0,0 +1,39 @@
+/*
+ * pin_map.h
+ *
+ * Host replacement of the TivaWare header with the same name. Contains the
+ * pin configurations of the TM4C123GH6PM used by Common_Classes.
+ */
+
+#ifndef __DRIVERLIB_PIN_MAP_H__
+#define __DRIVERLIB_PIN_MAP_H__
+
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PA6_I2C1SCL        0x00001803
+#define GPIO_PA6_M1PWM2         0x00001805
+#define GPIO_PA7_I2C1SDA        0x00001C03
+#define GPIO_PA7_M1PWM3         0x00001C05
+#define GPIO_PB2_I2C0SCL        0x00010803
+#define GPIO_PB3_I2C0SDA        0x00010C03
+#define GPIO_PB4_M0PWM2         0x00011004
+#define GPIO_PB5_M0PWM3         0x00011404
+#define GPIO_PB6_M0PWM0         0x00011804
+#define GPIO_PB7_M0PWM1         0x00011C04
+#define GPIO_PC4_M0PWM6         0x00021004
+#define GPIO_PC5_M0PWM7         0x00021404
+#define GPIO_PD0_I2C3SCL        0x00030003
+#define GPIO_PD0_M1PWM0         0x00030005
+#define GPIO_PD1_I2C3SDA        0x00030403
+#define GPIO_PD1_M1PWM1         0x00030405
+#define GPIO_PE4_I2C2SCL        0x00041003
+#define GPIO_PE4_M0PWM4         0x00041004
+#define GPIO_PE5_I2C2SDA        0x00041403
+#define GPIO_PE5_M0PWM5         0x00041404
+#define GPIO_PF0_M1PWM4         0x00050005
+#define GPIO_PF1_M1PWM5         0x00050405
+#define GPIO_PF2_M1PWM6         0x00050805
+#define GPIO_PF3_M1PWM7         0x00050C05
+
+
+#endif /* __DRIVERLIB_PIN_MAP_H__ */
@@ -0,0 +1,90 @@
+/*
+ * sysctl.h
+ *
+ * Host replacement of the TivaWare header with the same name (see
+ * HostDriverlib.cpp).
+ */
+
+#ifndef __DRIVERLIB_SYSCTL_H__
+#define __DRIVERLIB_SYSCTL_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYSCTL_PERIPH_ADC0      0xf0003800
+#define SYSCTL_PERIPH_ADC1      0xf0003801
+#define SYSCTL_PERIPH_CAN0      0xf0003400
+#define SYSCTL_PERIPH_CAN1      0xf0003401
+#define SYSCTL_PERIPH_COMP0     0xf0003c00
+#define SYSCTL_PERIPH_EEPROM0   0xf0005800
+#define SYSCTL_PERIPH_GPIOA     0xf0000800
+#define SYSCTL_PERIPH_GPIOB     0xf0000801
+#define SYSCTL_PERIPH_GPIOC     0xf0000802
+#define SYSCTL_PERIPH_GPIOD     0xf0000803
+#define SYSCTL_PERIPH_GPIOE     0xf0000804
+#define SYSCTL_PERIPH_GPIOF     0xf0000805
+#define SYSCTL_PERIPH_HIBERNATE 0xf0001400
+#define SYSCTL_PERIPH_I2C0      0xf0002000
+#define SYSCTL_PERIPH_I2C1      0xf0002001
+#define SYSCTL_PERIPH_I2C2      0xf0002002
+#define SYSCTL_PERIPH_I2C3      0xf0002003
+#define SYSCTL_PERIPH_PWM0      0xf0004000
+#define SYSCTL_PERIPH_PWM1      0xf0004001
+#define SYSCTL_PERIPH_QEI0      0xf0004400
+#define SYSCTL_PERIPH_QEI1      0xf0004401
+#define SYSCTL_PERIPH_SSI0      0xf0001c00
+#define SYSCTL_PERIPH_SSI1      0xf0001c01
+#define SYSCTL_PERIPH_SSI2      0xf0001c02
+#define SYSCTL_PERIPH_SSI3      0xf0001c03
+#define SYSCTL_PERIPH_TIMER0    0xf0000400
+#define SYSCTL_PERIPH_TIMER1    0xf0000401
+#define SYSCTL_PERIPH_TIMER2    0xf0000402
+#define SYSCTL_PERIPH_TIMER3    0xf0000403
+#define SYSCTL_PERIPH_TIMER4    0xf0000404
+#define SYSCTL_PERIPH_TIMER5    0xf0000405
+#define SYSCTL_PERIPH_UART0     0xf0001800
+#define SYSCTL_PERIPH_UART1     0xf0001801
+#define SYSCTL_PERIPH_UART2     0xf0001802
+#define SYSCTL_PERIPH_UART3     0xf0001803
+#define SYSCTL_PERIPH_UART4     0xf0001804
+#define SYSCTL_PERIPH_UART5     0xf0001805
+#define SYSCTL_PERIPH_UART6     0xf0001806
+#define SYSCTL_PERIPH_UART7     0xf0001807
+#define SYSCTL_PERIPH_UDMA      0xf0000c00
+#define SYSCTL_PERIPH_USB0      0xf0002800
+#define SYSCTL_PERIPH_WDOG0     0xf0000000
+#define SYSCTL_PERIPH_WDOG1     0xf0000001
+#define SYSCTL_PERIPH_WTIMER0   0xf0005c00
+#define SYSCTL_PERIPH_WTIMER1   0xf0005c01
+#define SYSCTL_PERIPH_WTIMER2   0xf0005c02
+#define SYSCTL_PERIPH_WTIMER3   0xf0005c03
+#define SYSCTL_PERIPH_WTIMER4   0xf0005c04
+#define SYSCTL_PERIPH_WTIMER5   0xf0005c05
+
+#define SYSCTL_PWMDIV_1         0x00000000
+#define SYSCTL_PWMDIV_2         0x00100000
+#define SYSCTL_PWMDIV_4         0x00120000
+#define SYSCTL_PWMDIV_8         0x00140000
+#define SYSCTL_PWMDIV_16        0x00160000
+#define SYSCTL_PWMDIV_32        0x00180000
+#define SYSCTL_PWMDIV_64        0x001A0000
+
+#define SYSCTL_SYSDIV_4         0x01C00000
+#define SYSCTL_SYSDIV_5         0x02000000
+#define SYSCTL_SYSDIV_2_5       0xC1000000
+#define SYSCTL_USE_PLL          0x00000000
+#define SYSCTL_XTAL_16MHZ       0x00000540
+#define SYSCTL_OSC_MAIN         0x00000000
+
+void SysCtlClockSet(uint32_t ui32Config);
+uint32_t SysCtlClockGet(void);
+void SysCtlDelay(uint32_t ui32Count);
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral);
+void SysCtlPeripheralDisable(uint32_t ui32Peripheral);
+void SysCtlPeripheralReset(uint32_t ui32Peripheral);
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral);
+void SysCtlPWMClockSet(uint32_t ui32Config);
+uint32_t SysCtlPWMClockGet(void);
+
+
+#endif /* __DRIVERLIB_SYSCTL_H__ */
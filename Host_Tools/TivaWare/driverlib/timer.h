@@ -0,0 +1,34 @@
+/*
+ * timer.h
+ *
+ * Host replacement of the TivaWare header with the same name.
+ */
+
+#ifndef __DRIVERLIB_TIMER_H__
+#define __DRIVERLIB_TIMER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_A                 0x000000ff
+#define TIMER_B                 0x0000ff00
+#define TIMER_BOTH              0x0000ffff
+
+#define TIMER_CFG_ONE_SHOT      0x00000021
+#define TIMER_CFG_PERIODIC      0x00000022
+
+#define TIMER_TIMA_TIMEOUT      0x00000001
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer);
+void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value);
+uint64_t TimerValueGet64(uint32_t ui32Base);
+void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer,
+                      void (*pfnHandler)(void));
+void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void TimerIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+
+#endif /* __DRIVERLIB_TIMER_H__ */
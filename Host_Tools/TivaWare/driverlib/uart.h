@@ -0,0 +1,39 @@
+/*
+ * uart.h
+ *
+ * Host replacement of the TivaWare header with the same name.
+ */
+
+#ifndef __DRIVERLIB_UART_H__
+#define __DRIVERLIB_UART_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UART_INT_TX             0x020
+
+#define UART_FIFO_TX1_8         0x00000000
+#define UART_FIFO_TX2_8         0x00000001
+#define UART_FIFO_TX4_8         0x00000002
+#define UART_FIFO_RX1_8         0x00000000
+#define UART_FIFO_RX4_8         0x00000010
+
+#define UART_TXINT_MODE_FIFO    0x00000000
+#define UART_TXINT_MODE_EOT     0x00000010
+
+void UARTCharPut(uint32_t ui32Base, unsigned char ucData);
+bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData);
+bool UARTSpaceAvail(uint32_t ui32Base);
+bool UARTBusy(uint32_t ui32Base);
+void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel,
+                      uint32_t ui32RxLevel);
+void UARTTxIntModeSet(uint32_t ui32Base, uint32_t ui32Mode);
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+void UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags);
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked);
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+bool UARTCharsAvail(uint32_t ui32Base);
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base);
+
+#endif /* __DRIVERLIB_UART_H__ */
@@ -0,0 +1,20 @@
+/*
+ * hw_types.h
+ *
+ * Host replacement of the TivaWare header with the same name. Registers
+ * accessed directly with HWREG are mapped to the register space of the host
+ * hardware (see HostHardware::getRegister).
+ */
+
+#ifndef __HW_TYPES_H__
+#define __HW_TYPES_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+
+volatile uint32_t *hostRegister(uint32_t address);
+
+#define HWREG(x)                (*hostRegister(x))
+
+
+#endif /* __HW_TYPES_H__ */
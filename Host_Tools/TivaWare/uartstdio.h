@@ -0,0 +1,19 @@
+/*
+ * uartstdio.h
+ *
+ * Host replacement of the TivaWare utility with the same name. The output
+ * is written to stdout (see HostDriverlib.cpp).
+ */
+
+#ifndef __UARTSTDIO_H__
+#define __UARTSTDIO_H__
+
+#include <stdint.h>
+
+void UARTStdioConfig(uint32_t ui32Port, uint32_t ui32Baud,
+                     uint32_t ui32SrcClock);
+int UARTwrite(const char *pcBuf, uint32_t ui32Len);
+void UARTprintf(const char *pcString, ...);
+
+
+#endif /* __UARTSTDIO_H__ */